@@ -0,0 +1,166 @@
+/**
+ * CrossInput Latency Benchmark
+ *
+ * Measures inject-to-delivery latency: the time from calling a CrossInput
+ * function until a probe window on the same X server receives the resulting
+ * event. Run it through `make bench_latency`, which starts a private Xvfb
+ * server so the probe owns focus and the whole screen.
+ */
+
+#include "../include/CrossInput.h"
+#include "x11_probe.h"
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Bench::Clock;
+    using Bench::ProbeWindow;
+
+    constexpr int kWarmup = 50;
+    constexpr int kSamples = 1000;
+    constexpr auto kTimeout = std::chrono::milliseconds(500);
+    // A backend that misses this many events in a row is not delivering to this server
+    constexpr int kMaxConsecutiveLost = 5;
+
+    struct Operation
+    {
+        const char *name;
+        int expect;                         // X event type the probe waits for
+        std::function<void(int)> setup;     // unmeasured, runs before each sample
+        std::function<void(int)> inject;    // measured
+        std::function<void()> teardown;     // unmeasured, runs after each sample
+    };
+
+    std::vector<Operation> operations()
+    {
+        using CrossInput::KeyCode;
+        using CrossInput::MouseButton;
+        auto nothing = [](int) {};
+        return {
+            {"KeyDown", KeyPress, nothing,
+             [](int)
+             { CrossInput::KeyDown(KeyCode::KEY_A); },
+             []
+             { CrossInput::KeyUp(KeyCode::KEY_A); }},
+            {"KeyUp", KeyRelease,
+             [](int)
+             { CrossInput::KeyDown(KeyCode::KEY_A); },
+             [](int)
+             { CrossInput::KeyUp(KeyCode::KEY_A); },
+             [] {}},
+            {"MouseButtonDown", ButtonPress, nothing,
+             [](int)
+             { CrossInput::MouseButtonDown(MouseButton::Left); },
+             []
+             { CrossInput::MouseButtonUp(MouseButton::Left); }},
+            {"SetCursorPosition", MotionNotify, nothing,
+             [](int i)
+             { CrossInput::SetCursorPosition(i % 2 ? CrossInput::Point{200, 200} : CrossInput::Point{100, 100}); },
+             [] {}},
+            {"MoveCursor", MotionNotify, nothing,
+             [](int i)
+             { CrossInput::MoveCursor(i % 2 ? 5 : -5, 0); },
+             [] {}},
+            {"TypeText", KeyRelease, nothing,
+             [](int)
+             { CrossInput::TypeText("a"); },
+             [] {}},
+        };
+    }
+
+    const char *backendName(CrossInput::Backend backend)
+    {
+        switch (backend)
+        {
+        case CrossInput::Backend::X11:
+            return "x11";
+        case CrossInput::Backend::Wayland:
+            return "wayland";
+        case CrossInput::Backend::Uinput:
+            return "uinput";
+        default:
+            return "auto";
+        }
+    }
+
+    void runOperation(ProbeWindow &probe, const char *backend, const Operation &op)
+    {
+        std::vector<double> latencies;
+        latencies.reserve(kSamples);
+        int lost = 0, lostInARow = 0;
+
+        for (int i = 0; i < kWarmup + kSamples && lostInARow < kMaxConsecutiveLost; ++i)
+        {
+            op.setup(i);
+            probe.drain();
+
+            Clock::time_point delivered;
+            Clock::time_point start = Clock::now();
+            op.inject(i);
+            bool ok = probe.waitFor(op.expect, delivered, kTimeout);
+
+            op.teardown();
+            if (!ok)
+            {
+                ++lost;
+                ++lostInARow;
+                continue;
+            }
+            lostInARow = 0;
+            if (i >= kWarmup)
+                latencies.push_back(Bench::microseconds(delivered - start));
+        }
+
+        if (latencies.empty())
+        {
+            printf("%-8s %-18s %8s %10s %10s %10s %6d  (no events delivered)\n",
+                   backend, op.name, "-", "-", "-", "-", lost);
+            return;
+        }
+
+        Bench::Percentiles p = Bench::summarize(latencies);
+        printf("%-8s %-18s %8zu %10.1f %10.1f %10.1f %6d\n",
+               backend, op.name, latencies.size(), p.p50, p.p99, p.p999, lost);
+    }
+} // namespace
+
+int main()
+{
+    if (!std::getenv("DISPLAY"))
+    {
+        fprintf(stderr, "bench_latency: DISPLAY is not set; run it through `make bench_latency`\n");
+        return 1;
+    }
+
+    ProbeWindow probe;
+    if (!probe.isValid())
+    {
+        fprintf(stderr, "bench_latency: cannot open the X display\n");
+        return 1;
+    }
+
+    printf("CrossInput inject-to-delivery latency (%s), microseconds\n\n", CrossInput::GetPlatformName().c_str());
+    printf("%-8s %-18s %8s %10s %10s %10s %6s\n", "backend", "api", "samples", "p50", "p99", "p99.9", "lost");
+
+    // Only XTest can target the private server: libei talks to the host
+    // compositor and uinput devices are read by the host's input stack, so
+    // those backends would type into the real desktop instead of the probe
+    const CrossInput::Backend backends[] = {CrossInput::Backend::X11};
+    for (CrossInput::Backend backend : backends)
+    {
+        if (!CrossInput::SetBackend(backend))
+        {
+            printf("%-8s (unavailable)\n", backendName(backend));
+            continue;
+        }
+        for (const Operation &op : operations())
+            runOperation(probe, backendName(backend), op);
+    }
+
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    return 0;
+}
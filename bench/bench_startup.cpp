@@ -0,0 +1,267 @@
+/**
+ * CrossInput Cold-Start Benchmark
+ *
+ * Measures the wall time from process start to the first delivered event. Each
+ * run re-executes this binary as a child that selects a backend and presses one
+ * key; the child reports when each startup phase was reached and the parent's
+ * probe window reports when the key arrived. Medians over all runs, in ms:
+ *
+ *   load     exec + dynamic linking + static init, up to main()
+ *   connect  main() until the display / session bus / uinput node is open
+ *   session  portal session started (libei) or virtual device created (uinput)
+ *   device   EIS devices resumed (libei)
+ *   frame    last phase above until the first event is flushed
+ *   deliver  flush until the probe window reads the event (X11 only)
+ *
+ *   bench_startup [--runs 10] [--host]
+ *
+ * --host also measures the Wayland and uinput backends, which inject into the
+ * real desktop; those runs end at the first frame.
+ */
+
+#include "../include/CrossInput.h"
+#include "../src/core/startup_phases.h"
+#include "x11_probe.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    using Bench::Clock;
+    using Bench::ProbeWindow;
+    using CrossInput::Internal::StartupPhase;
+
+    constexpr int kDefaultRuns = 10;
+    // Generous for one XTest event, short enough that a child that failed early does not stall the run
+    constexpr auto kTimeout = std::chrono::seconds(2);
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    int64_t toNs(Clock::time_point t)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    struct BackendInfo
+    {
+        const char *name;
+        CrossInput::Backend backend;
+        bool host; // injects into the real desktop
+    };
+
+    const BackendInfo kBackends[] = {
+        {"x11", CrossInput::Backend::X11, false},
+        {"wayland", CrossInput::Backend::Wayland, true},
+        {"uinput", CrossInput::Backend::Uinput, true},
+    };
+
+    // Steady-clock timestamps (ns) of one run; 0 where a phase does not apply
+    struct Run
+    {
+        int64_t spawn = 0;
+        int64_t main = 0;
+        int64_t phases[static_cast<int>(StartupPhase::Count)] = {};
+        int64_t delivered = 0;
+    };
+
+    // Child side: one key press, then the phase timestamps on stdout
+    int runChild(const char *name)
+    {
+        int64_t mainNs = nowNs();
+        for (const BackendInfo &info : kBackends)
+        {
+            if (strcmp(info.name, name) != 0)
+                continue;
+            if (!CrossInput::SetBackend(info.backend))
+                return 2;
+
+            CrossInput::KeyDown(CrossInput::KeyCode::KEY_F12);
+            CrossInput::KeyUp(CrossInput::KeyCode::KEY_F12);
+
+            const std::atomic<int64_t> *times = CrossInput::Internal::startupPhaseTimes();
+            printf("%lld", static_cast<long long>(mainNs));
+            for (int i = 0; i < static_cast<int>(StartupPhase::Count); ++i)
+                printf(" %lld", static_cast<long long>(times[i].load()));
+            printf("\n");
+            return 0;
+        }
+        return 2;
+    }
+
+    bool spawnRun(const BackendInfo &info, ProbeWindow *probe, Run &run)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+            return false;
+        if (probe)
+            probe->drain();
+
+        run.spawn = nowNs();
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid == 0)
+        {
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+            execl("/proc/self/exe", "bench_startup", "--child", info.name, static_cast<char *>(nullptr));
+            _exit(127);
+        }
+        close(fds[1]);
+
+        Clock::time_point delivered;
+        bool ok = !probe || probe->waitFor(KeyPress, delivered, kTimeout);
+        if (probe && ok)
+            run.delivered = toNs(delivered);
+
+        std::string output;
+        char buffer[256];
+        ssize_t n;
+        while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+            output.append(buffer, static_cast<size_t>(n));
+        close(fds[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            return false;
+
+        long long values[1 + static_cast<int>(StartupPhase::Count)];
+        if (sscanf(output.c_str(), "%lld %lld %lld %lld %lld", &values[0], &values[1], &values[2], &values[3],
+                   &values[4]) != 5)
+            return false;
+        run.main = values[0];
+        for (int i = 0; i < static_cast<int>(StartupPhase::Count); ++i)
+            run.phases[i] = values[i + 1];
+        return true;
+    }
+
+    // Median of the per-run durations from `from` to `to`; negative if the phase never applied
+    template <typename From, typename To>
+    double medianMs(const std::vector<Run> &runs, From from, To to)
+    {
+        std::vector<double> samples;
+        for (const Run &run : runs)
+        {
+            int64_t start = from(run), end = to(run);
+            if (start != 0 && end != 0)
+                samples.push_back(static_cast<double>(end - start) / 1e6);
+        }
+        if (samples.empty())
+            return -1.0;
+        return Bench::summarize(samples).p50;
+    }
+
+    void printCell(double ms)
+    {
+        if (ms < 0.0)
+            printf(" %9s", "-");
+        else
+            printf(" %9.2f", ms);
+    }
+
+    void report(const char *name, const std::vector<Run> &runs, int failed)
+    {
+        auto phase = [](StartupPhase p)
+        { return [p](const Run &run)
+          { return run.phases[static_cast<int>(p)]; }; };
+        // Start of the frame phase: the latest phase the backend reached before it
+        auto beforeFrame = [](const Run &run)
+        {
+            int64_t t = run.main;
+            for (int i = 0; i < static_cast<int>(StartupPhase::FirstFrame); ++i)
+                t = run.phases[i] ? run.phases[i] : t;
+            return t;
+        };
+        auto spawn = [](const Run &run)
+        { return run.spawn; };
+        auto entered = [](const Run &run)
+        { return run.main; };
+        auto delivered = [](const Run &run)
+        { return run.delivered; };
+        auto end = [](const Run &run)
+        { return run.delivered ? run.delivered : run.phases[static_cast<int>(StartupPhase::FirstFrame)]; };
+
+        printf("%-8s %5zu", name, runs.size());
+        printCell(medianMs(runs, spawn, entered));
+        printCell(medianMs(runs, entered, phase(StartupPhase::Connect)));
+        printCell(medianMs(runs, phase(StartupPhase::Connect), phase(StartupPhase::Session)));
+        printCell(medianMs(runs, phase(StartupPhase::Session), phase(StartupPhase::DeviceReady)));
+        printCell(medianMs(runs, beforeFrame, phase(StartupPhase::FirstFrame)));
+        printCell(medianMs(runs, phase(StartupPhase::FirstFrame), delivered));
+        printCell(medianMs(runs, spawn, end));
+        printf(" %6d\n", failed);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--child") == 0)
+        return runChild(argv[2]);
+
+    int runs = kDefaultRuns;
+    bool host = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            runs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--host") == 0)
+            host = true;
+    }
+
+    if (!std::getenv("DISPLAY") && !host)
+    {
+        fprintf(stderr, "bench_startup: DISPLAY is not set; run it through `make bench_startup`\n");
+        return 1;
+    }
+
+    printf("CrossInput cold start to first event (%s), median of %d runs, milliseconds\n\n",
+           CrossInput::GetPlatformName().c_str(), runs);
+    printf("%-8s %5s %9s %9s %9s %9s %9s %9s %9s %6s\n", "backend", "runs", "load", "connect", "session",
+           "device", "frame", "deliver", "total", "failed");
+
+    for (const BackendInfo &info : kBackends)
+    {
+        if (info.host && !host)
+            continue;
+
+        // Only the X11 run can be observed: the other backends deliver to the host session
+        std::unique_ptr<ProbeWindow> probe;
+        if (!info.host)
+        {
+            probe.reset(new ProbeWindow());
+            if (!probe->isValid())
+            {
+                printf("%-8s (cannot open the X display)\n", info.name);
+                continue;
+            }
+        }
+
+        std::vector<Run> results;
+        int failed = 0;
+        for (int i = 0; i < runs; ++i)
+        {
+            Run run;
+            if (spawnRun(info, probe.get(), run))
+                results.push_back(run);
+            else
+                ++failed;
+        }
+        report(info.name, results, failed);
+    }
+    return 0;
+}
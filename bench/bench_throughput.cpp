@@ -0,0 +1,253 @@
+/**
+ * CrossInput Throughput Benchmark
+ *
+ * Calls each public API in a tight loop and reports calls per second and CPU
+ * nanoseconds per call as JSON, one result per line. X11 runs against the
+ * display server; libei runs against an in-process libeis server when built
+ * with libeis; the Null backend measures the library alone. With --baseline it
+ * compares against a stored run and exits non-zero on a regression or when the
+ * baseline is missing.
+ *
+ *   bench_throughput [--baseline FILE] [--tolerance 0.2] [--output FILE]
+ */
+
+#include "../include/CrossInput.h"
+#include "bench_util.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef CROSSINPUT_HAS_LIBEIS
+#include "../test/eis_test_server.h"
+#endif
+
+namespace
+{
+    using Bench::Clock;
+
+    constexpr int kWarmupCalls = 20;
+    constexpr auto kDuration = std::chrono::milliseconds(300);
+
+    struct Result
+    {
+        std::string backend;
+        std::string api;
+        unsigned long long calls;
+        double callsPerSec;
+        double cpuNsPerCall;
+    };
+
+    struct Api
+    {
+        const char *name;
+        std::function<void(unsigned long long)> call;
+    };
+
+    std::vector<Api> apis()
+    {
+        using CrossInput::KeyCode;
+        using CrossInput::MouseButton;
+        return {
+            {"KeyPress", [](unsigned long long)
+             { CrossInput::KeyPress(KeyCode::KEY_F12); }},
+            {"KeyCombination", [](unsigned long long)
+             { CrossInput::KeyCombination({KeyCode::KEY_SHIFT, KeyCode::KEY_F12}); }},
+            {"MouseClick", [](unsigned long long)
+             { CrossInput::MouseClick(MouseButton::Middle); }},
+            {"MoveCursor", [](unsigned long long i)
+             { CrossInput::MoveCursor(i % 2 ? 1 : -1, 0); }},
+            {"IsKeyPressed", [](unsigned long long)
+             { (void)CrossInput::IsKeyPressed(KeyCode::KEY_A); }},
+            {"GetCursorPosition", [](unsigned long long)
+             { (void)CrossInput::GetCursorPosition(); }},
+        };
+    }
+
+    double threadCpuNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) * 1e9 + static_cast<double>(ts.tv_nsec);
+    }
+
+    Result measure(const char *backend, const Api &api)
+    {
+        for (int i = 0; i < kWarmupCalls; ++i)
+            api.call(static_cast<unsigned long long>(i));
+
+        unsigned long long calls = 0;
+        double cpuStart = threadCpuNs();
+        Clock::time_point start = Clock::now();
+        Clock::time_point end;
+        do
+        {
+            // Check the clock every 16 calls so it stays out of the measurement
+            for (int i = 0; i < 16; ++i)
+                api.call(calls++);
+            end = Clock::now();
+        } while (end - start < kDuration);
+        double cpu = threadCpuNs() - cpuStart;
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        return Result{backend, api.name, calls, static_cast<double>(calls) / seconds,
+                      cpu / static_cast<double>(calls)};
+    }
+
+    std::string toJson(const std::vector<Result> &results)
+    {
+        std::ostringstream out;
+        out << "{\n  \"platform\": \"" << CrossInput::GetPlatformName() << "\",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            char line[256];
+            snprintf(line, sizeof(line),
+                     "    {\"backend\": \"%s\", \"api\": \"%s\", \"calls\": %llu, "
+                     "\"calls_per_sec\": %.1f, \"cpu_ns_per_call\": %.1f}%s\n",
+                     r.backend.c_str(), r.api.c_str(), r.calls, r.callsPerSec, r.cpuNsPerCall,
+                     i + 1 < results.size() ? "," : "");
+            out << line;
+        }
+        out << "  ]\n}\n";
+        return out.str();
+    }
+
+    // Reads results back from a file written by toJson (one result per line)
+    std::vector<Result> loadBaseline(const char *path)
+    {
+        std::vector<Result> results;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            char backend[64], api[64];
+            Result r;
+            if (sscanf(line.c_str(),
+                       " {\"backend\": \"%63[^\"]\", \"api\": \"%63[^\"]\", \"calls\": %llu, "
+                       "\"calls_per_sec\": %lf, \"cpu_ns_per_call\": %lf}",
+                       backend, api, &r.calls, &r.callsPerSec, &r.cpuNsPerCall) == 5)
+            {
+                r.backend = backend;
+                r.api = api;
+                results.push_back(r);
+            }
+        }
+        return results;
+    }
+
+    // Returns the number of regressions beyond `tolerance` (0.2 = 20% slower).
+    // Results the baseline has no entry for are listed but not counted.
+    int compare(const std::vector<Result> &baseline, const std::vector<Result> &current, double tolerance)
+    {
+        int regressions = 0;
+        for (const Result &now : current)
+        {
+            const Result *base = nullptr;
+            for (const Result &candidate : baseline)
+            {
+                if (candidate.backend == now.backend && candidate.api == now.api)
+                    base = &candidate;
+            }
+            if (!base)
+            {
+                fprintf(stderr, "%-8s %-18s %12s -> %12.0f calls/s  (no baseline entry)\n", now.backend.c_str(),
+                        now.api.c_str(), "-", now.callsPerSec);
+                continue;
+            }
+
+            double ratio = now.callsPerSec / base->callsPerSec;
+            bool regressed = ratio < 1.0 - tolerance;
+            fprintf(stderr, "%-8s %-18s %12.0f -> %12.0f calls/s  (%+.1f%%)%s\n",
+                    base->backend.c_str(), base->api.c_str(), base->callsPerSec, now.callsPerSec,
+                    (ratio - 1.0) * 100.0, regressed ? "  REGRESSION" : "");
+            regressions += regressed;
+        }
+        return regressions;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *baselinePath = nullptr;
+    const char *outputPath = nullptr;
+    double tolerance = 0.2;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--baseline") == 0)
+            baselinePath = argv[i + 1];
+        else if (strcmp(argv[i], "--output") == 0)
+            outputPath = argv[i + 1];
+        else if (strcmp(argv[i], "--tolerance") == 0)
+            tolerance = atof(argv[i + 1]);
+    }
+
+    std::vector<Result> results;
+
+    // Backends that inject into the host desktop (portal libei, uinput) are left out
+    if (std::getenv("DISPLAY") && CrossInput::SetBackend(CrossInput::Backend::X11))
+    {
+        for (const Api &api : apis())
+            results.push_back(measure("x11", api));
+    }
+
+#ifdef CROSSINPUT_HAS_LIBEIS
+    // Measured on its own thread, which owns the libei connection to the server
+    {
+        TestEis::Server server(false);
+        if (server.isValid() && CrossInput::UseEisConnection(server.addClient()) &&
+            CrossInput::SetBackend(CrossInput::Backend::Wayland))
+        {
+            std::thread([&]
+                        {
+                            for (const Api &api : apis())
+                                results.push_back(measure("libei", api));
+                            CrossInput::Sync();
+                        })
+                .join();
+        }
+    }
+#endif
+
+    // The library's own overhead, with no display server in the loop. Events
+    // past the buffer are counted instead of stored, which costs about the same.
+    if (CrossInput::SetBackend(CrossInput::Backend::Null))
+    {
+        for (const Api &api : apis())
+        {
+            CrossInput::ResetNullBackend(1920, 1080, 1 << 20);
+            results.push_back(measure("null", api));
+        }
+    }
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    if (results.empty())
+    {
+        fprintf(stderr, "bench_throughput: no backend available; run it through `make bench_throughput`\n");
+        return 1;
+    }
+
+    std::string json = toJson(results);
+    fputs(json.c_str(), stdout);
+    if (outputPath)
+        std::ofstream(outputPath) << json;
+
+    if (!baselinePath)
+        return 0;
+
+    // A gate that passes without a baseline would never catch anything
+    std::vector<Result> baseline = loadBaseline(baselinePath);
+    if (baseline.empty())
+    {
+        fprintf(stderr, "bench_throughput: no baseline at %s; record one with `make bench_throughput_baseline`\n",
+                baselinePath);
+        return 1;
+    }
+    return compare(baseline, results, tolerance) > 0 ? 1 : 0;
+}
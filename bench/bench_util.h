@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace Bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline double microseconds(Clock::duration d)
+    {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    // Nearest-rank percentile of an already sorted sample, p in [0, 100]
+    inline double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    struct Percentiles
+    {
+        double p50;
+        double p99;
+        double p999;
+    };
+
+    inline Percentiles summarize(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        return Percentiles{percentile(samples, 50.0), percentile(samples, 99.0), percentile(samples, 99.9)};
+    }
+} // namespace Bench
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Runs a command against a private Xvfb server and shuts the server down afterwards.
+# Usage: bench/with_xvfb.sh <command> [args...]
+set -e
+
+if ! command -v Xvfb >/dev/null 2>&1; then
+    echo "with_xvfb: Xvfb not found (install xvfb / xorg-server-xvfb)" >&2
+    exit 1
+fi
+
+# -displayfd lets Xvfb pick a free display number and report it once it is ready
+fifo=$(mktemp -u)
+mkfifo "$fifo"
+Xvfb -displayfd 3 -screen 0 1280x1024x24 -nolisten tcp 3>"$fifo" &
+pid=$!
+trap 'kill $pid 2>/dev/null; rm -f "$fifo"' EXIT INT TERM
+
+read -r display <"$fifo"
+if [ -z "$display" ]; then
+    echo "with_xvfb: Xvfb failed to start" >&2
+    exit 1
+fi
+
+env -u WAYLAND_DISPLAY DISPLAY=":$display" XDG_SESSION_TYPE=x11 "$@"
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "bench_util.h"
+#include <cerrno>
+#include <poll.h>
+
+// Include after CrossInput.h: Xlib's KeyPress macro would otherwise rename CrossInput::KeyPress
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+namespace Bench
+{
+    // A fullscreen, focused window on its own connection that reports input arrival times
+    class ProbeWindow
+    {
+    public:
+        ProbeWindow() : display_(XOpenDisplay(nullptr)), window_(0)
+        {
+            if (!display_)
+                return;
+
+            int screen = DefaultScreen(display_);
+            XSetWindowAttributes attrs = {};
+            attrs.override_redirect = True; // no window manager placement
+            attrs.event_mask = KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+                               PointerMotionMask | StructureNotifyMask;
+            window_ = XCreateWindow(display_, RootWindow(display_, screen), 0, 0,
+                                    DisplayWidth(display_, screen), DisplayHeight(display_, screen), 0,
+                                    CopyFromParent, InputOutput, CopyFromParent,
+                                    CWOverrideRedirect | CWEventMask, &attrs);
+            XMapRaised(display_, window_);
+
+            XEvent ev;
+            do
+            {
+                XNextEvent(display_, &ev);
+            } while (ev.type != MapNotify);
+
+            XSetInputFocus(display_, window_, RevertToParent, CurrentTime);
+            XSync(display_, False);
+            drain();
+        }
+
+        ~ProbeWindow()
+        {
+            if (display_)
+            {
+                XDestroyWindow(display_, window_);
+                XCloseDisplay(display_);
+            }
+        }
+
+        ProbeWindow(const ProbeWindow &) = delete;
+        ProbeWindow &operator=(const ProbeWindow &) = delete;
+
+        bool isValid() const { return display_ != nullptr; }
+        Display *display() const { return display_; }
+        Window window() const { return window_; }
+
+        // Waits up to `timeout` for an event of `type`, returning when it was read off the connection
+        bool waitFor(int type, Clock::time_point &delivered, std::chrono::milliseconds timeout)
+        {
+            XEvent ev;
+            if (!waitFor(type, ev, timeout))
+                return false;
+            delivered = Clock::now();
+            return true;
+        }
+
+        // Waits up to `timeout` for an event of `type`, discarding the others
+        bool waitFor(int type, XEvent &event, std::chrono::milliseconds timeout)
+        {
+            const Clock::time_point deadline = Clock::now() + timeout;
+            pollfd pfd = {ConnectionNumber(display_), POLLIN, 0};
+            for (;;)
+            {
+                while (XPending(display_))
+                {
+                    XNextEvent(display_, &event);
+                    if (event.type == type)
+                        return true;
+                }
+
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+                if (remaining.count() <= 0)
+                    return false;
+                if (poll(&pfd, 1, static_cast<int>(remaining.count())) < 0 && errno != EINTR)
+                    return false;
+            }
+        }
+
+        // Discards everything queued, after a round trip so in-flight events are included
+        void drain()
+        {
+            XSync(display_, False);
+            while (XPending(display_))
+            {
+                XEvent ev;
+                XNextEvent(display_, &ev);
+            }
+        }
+
+    private:
+        Display *display_;
+        Window window_;
+    };
+} // namespace Bench
@@ -1,5 +1,11 @@
 #pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace CrossInput
 {
@@ -105,7 +111,8 @@ namespace CrossInput
     // KEYBOARD ACTIONS
     // ----------------------------------------------------
 
-    // Checks if a specific key is currently pressed globally
+    // Checks if a specific key is currently pressed globally.
+    // On Wayland this reads the keyboards' evdev nodes when they are accessible.
     bool IsKeyPressed(KeyCode key);
 
     // Simulates pressing down a key
@@ -116,6 +123,31 @@ namespace CrossInput
     void KeyPress(KeyCode key);
     // Simulates a combination of keys (e.g., Ctrl+C)
     void KeyCombination(const std::initializer_list<KeyCode> &keys);
+    // Types UTF-8 text using the active keyboard layout. Characters are
+    // translated through a precomputed table, modifiers are held once per run
+    // of characters that need them, and the whole text is sent as one batch.
+    // On X11, characters missing from the layout are typed through spare
+    // keycodes that are remapped on demand; elsewhere they are skipped.
+    void TypeText(std::string_view utf8);
+
+    struct PasteOptions
+    {
+        // Also own PRIMARY, which some applications paste on middle click
+        bool primary = false;
+        // Put the previous clipboard text back once the target has fetched ours
+        bool restoreClipboard = false;
+        // How long the target has to fetch the text after Ctrl+V
+        std::chrono::milliseconds timeout = std::chrono::seconds(2);
+    };
+
+    // Enters text by placing it on the X clipboard and pressing Ctrl+V through
+    // the active backend: one chord instead of two key events per character,
+    // so long text arrives far faster than with TypeText. A background thread
+    // owns the selection and serves it, in increments when it is large.
+    // Needs an X display (X11, or XWayland for Wayland clients). Returns false
+    // if there is none, under Backend::Null, or when no application fetched
+    // the text within the timeout; TypeText can then be used instead.
+    bool PasteText(std::string_view utf8, const PasteOptions &options = PasteOptions());
 
     // ----------------------------------------------------
     // MOUSE ACTIONS
@@ -132,6 +164,535 @@ namespace CrossInput
     // Move cursor by relative amount (works better on Wayland)
     void MoveCursor(int dx, int dy);
 
+    // Blocks until the events this thread has injected were processed, so that
+    // state read afterwards (GetCursorPosition, IsKeyPressed) reflects them.
+    // X11 makes a server round trip. libei waits for the compositor to answer
+    // a ping and then, after SetCursorPosition, for XWayland to report the new
+    // cursor position. Returns false if that is not confirmed within
+    // timeoutMs, e.g. while the cursor is over a window XWayland cannot see.
+    // Windows, macOS and Backend::Uinput offer nothing to wait for beyond the
+    // hand-off each call already makes, and return true.
+    bool Sync(int timeoutMs = 1000);
+
+    // ----------------------------------------------------
+    // EVENTS
+    // ----------------------------------------------------
+
+    enum class EventType
+    {
+        KeyDown,
+        KeyUp,
+        MouseButtonDown,
+        MouseButtonUp,
+        SetCursorPosition,
+        MoveCursor
+    };
+
+    // A single input action. Only the field matching `type` is used;
+    // MoveCursor stores its relative delta in `pos`.
+    struct InputEvent
+    {
+        EventType type;
+        KeyCode key;
+        MouseButton button;
+        Point pos;
+
+        static InputEvent Key(KeyCode key, bool down)
+        {
+            return InputEvent{down ? EventType::KeyDown : EventType::KeyUp, key, MouseButton::Left, Point{0, 0}};
+        }
+        static InputEvent Button(MouseButton button, bool down)
+        {
+            return InputEvent{down ? EventType::MouseButtonDown : EventType::MouseButtonUp, KeyCode::KEY_A, button, Point{0, 0}};
+        }
+        static InputEvent MoveTo(const Point &pos)
+        {
+            return InputEvent{EventType::SetCursorPosition, KeyCode::KEY_A, MouseButton::Left, pos};
+        }
+        static InputEvent MoveBy(int dx, int dy)
+        {
+            return InputEvent{EventType::MoveCursor, KeyCode::KEY_A, MouseButton::Left, Point{dx, dy}};
+        }
+    };
+
+    // Sends events through the active backend, in order
+    void SubmitEvent(const InputEvent &event);
+    void SubmitEvents(const InputEvent *events, size_t count);
+
+    // A fixed list of events for sending many times. The first Play() translates
+    // it for the active backend (X keycodes, evdev frames) and keeps the result,
+    // so later calls skip the key lookups and send everything as one batch: one
+    // flush under X11, one write() under uinput. Backends without a prepared
+    // form play it like SubmitEvents. Switching backends or keyboard layouts
+    // re-translates on the next Play(). Safe to play from several threads.
+    class InputSequence
+    {
+    public:
+        InputSequence(const InputEvent *events, size_t count);
+        InputSequence(std::initializer_list<InputEvent> events);
+        ~InputSequence();
+
+        // Presses `keys` in order and releases them in reverse, like KeyCombination
+        static InputSequence Chord(std::initializer_list<KeyCode> keys);
+
+        void Play() const;
+        size_t Size() const;
+
+        InputSequence(const InputSequence &) = delete;
+        InputSequence &operator=(const InputSequence &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    // ----------------------------------------------------
+    // SCHEDULING
+    // ----------------------------------------------------
+
+    // Time source for Scheduler and ReplayRecording. Leaving the options' clock
+    // unset uses steady_clock with precise sleeping.
+    class SchedulerClock
+    {
+    public:
+        virtual ~SchedulerClock() = default;
+
+        virtual std::chrono::steady_clock::time_point Now() const = 0;
+        // Returns once Now() has reached `deadline`. Stop() and newly scheduled
+        // events cannot interrupt it.
+        virtual void AdvanceTo(std::chrono::steady_clock::time_point deadline) = 0;
+    };
+
+    // Simulated time for tests: AdvanceTo jumps straight to the deadline, so
+    // timed sequences run without sleeping and every event fires exactly at
+    // its requested time. Schedule before Start() for repeatable results.
+    class VirtualClock : public SchedulerClock
+    {
+    public:
+        explicit VirtualClock(std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now());
+        ~VirtualClock() override;
+
+        std::chrono::steady_clock::time_point Now() const override;
+        void AdvanceTo(std::chrono::steady_clock::time_point deadline) override;
+        void Advance(std::chrono::nanoseconds delta);
+
+        VirtualClock(const VirtualClock &) = delete;
+        VirtualClock &operator=(const VirtualClock &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    struct SchedulerOptions
+    {
+        // Final stretch before each deadline that is busy-waited instead of slept.
+        // Larger values trade CPU time for accuracy.
+        std::chrono::nanoseconds spinTail = std::chrono::microseconds(200);
+        // Run the dispatch thread under SCHED_FIFO (Linux, needs CAP_SYS_NICE)
+        bool realtime = false;
+        int realtimePriority = 50;
+        // Pin the dispatch thread to this CPU, -1 leaves it unpinned (Linux only)
+        int cpu = -1;
+        // Replaces real time, e.g. with a VirtualClock the caller keeps to read Now()
+        std::shared_ptr<SchedulerClock> clock;
+    };
+
+    // Requested vs. achieved fire time of one scheduled event
+    struct EventTiming
+    {
+        std::chrono::steady_clock::time_point requested;
+        std::chrono::steady_clock::time_point achieved;
+    };
+
+    // Summary of how late events fired relative to their deadlines
+    struct TimingReport
+    {
+        size_t events;
+        std::chrono::nanoseconds meanError;
+        std::chrono::nanoseconds p50Error;
+        std::chrono::nanoseconds p99Error;
+        std::chrono::nanoseconds maxError;
+    };
+
+    // Fires timestamped events on a dedicated thread. Deadlines are slept
+    // towards (timerfd with TFD_TIMER_ABSTIME on Linux) and the last
+    // `spinTail` is busy-waited, giving sub-100us accuracy on an idle core.
+    // Events can be scheduled before or after Start().
+    class Scheduler
+    {
+    public:
+        explicit Scheduler(const SchedulerOptions &options = SchedulerOptions());
+        ~Scheduler();
+
+        void Schedule(const InputEvent &event, std::chrono::steady_clock::time_point when);
+        void ScheduleAfter(const InputEvent &event, std::chrono::nanoseconds delay);
+
+        // Starts the dispatch thread
+        void Start();
+        // Blocks until every scheduled event has fired
+        void Wait();
+        // Stops the dispatch thread, dropping events that have not fired yet
+        void Stop();
+
+        std::vector<EventTiming> GetTimings() const;
+        TimingReport GetReport() const;
+
+        Scheduler(const Scheduler &) = delete;
+        Scheduler &operator=(const Scheduler &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    // ----------------------------------------------------
+    // RECORDING AND REPLAY
+    // ----------------------------------------------------
+
+    // An event with its offset from the start of a recording
+    struct TimedEvent
+    {
+        InputEvent event;
+        std::chrono::nanoseconds timestamp;
+    };
+
+    // Writes events to a compact binary recording: delta-encoded timestamps,
+    // zigzag varint coordinates and KeyCode ids. Timestamps must not decrease.
+    class RecordingWriter
+    {
+    public:
+        explicit RecordingWriter(const std::string &path);
+        ~RecordingWriter();
+
+        bool IsOpen() const;
+        bool Write(const TimedEvent &event);
+        // Flushes and closes the file, returns false if any write failed
+        bool Close();
+
+        RecordingWriter(const RecordingWriter &) = delete;
+        RecordingWriter &operator=(const RecordingWriter &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    // Streams events out of a memory-mapped recording without copying them to the heap
+    class RecordingReader
+    {
+    public:
+        explicit RecordingReader(const std::string &path);
+        ~RecordingReader();
+
+        bool IsOpen() const;
+        // Decodes the next event, returns false at the end or on corrupt data
+        bool Next(TimedEvent &out);
+        // Restarts decoding from the first event
+        void Rewind();
+
+        RecordingReader(const RecordingReader &) = delete;
+        RecordingReader &operator=(const RecordingReader &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    struct ReplayOptions
+    {
+        // Playback rate; 2.0 plays twice as fast, 0 or less plays as fast as possible
+        double speed = 1.0;
+        // Busy-wait tail before each deadline, see SchedulerOptions::spinTail
+        std::chrono::nanoseconds spinTail = std::chrono::microseconds(200);
+        // Paces playback instead of real time, see SchedulerOptions::clock
+        std::shared_ptr<SchedulerClock> clock;
+    };
+
+    // Replays a recording on the calling thread, returns the number of events sent
+    size_t ReplayRecording(const std::string &path, const ReplayOptions &options = ReplayOptions());
+
+    // ----------------------------------------------------
+    // PATH SIMPLIFICATION
+    // ----------------------------------------------------
+
+    enum class SimplifyMethod
+    {
+        // Keeps every dropped point within `tolerance` pixels of the simplified path
+        DouglasPeucker,
+        // Drops points by smallest triangle area while each lies within `tolerance` of
+        // its current neighbours; smoother on curves, but earlier drops are not re-checked
+        Visvalingam
+    };
+
+    // Removes redundant cursor moves from a recorded stream. Runs of consecutive
+    // SetCursorPosition or MoveCursor events are simplified independently; other
+    // events are kept and the cursor position at each of them is preserved exactly.
+    // Kept events keep their original timestamps and relative moves still sum to
+    // the same total displacement.
+    std::vector<TimedEvent> SimplifyPath(const std::vector<TimedEvent> &events, double tolerance,
+                                         SimplifyMethod method = SimplifyMethod::DouglasPeucker);
+
+    // Streaming counterpart of SimplifyPath for unbounded streams. Uses an
+    // opening-window test with the same distance bound as DouglasPeucker and
+    // bounded memory per run.
+    class PathSimplifier
+    {
+    public:
+        explicit PathSimplifier(double tolerance);
+        ~PathSimplifier();
+
+        // Feeds the next event, appending any events that became final to `out`
+        void Push(const TimedEvent &event, std::vector<TimedEvent> &out);
+        // Flushes the pending run at the end of the stream
+        void Finish(std::vector<TimedEvent> &out);
+
+        PathSimplifier(const PathSimplifier &) = delete;
+        PathSimplifier &operator=(const PathSimplifier &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    // Streams a recording through PathSimplifier into a new file, returns events written
+    size_t SimplifyRecording(const std::string &inputPath, const std::string &outputPath, double tolerance);
+
+    // ----------------------------------------------------
+    // LISTENING
+    // ----------------------------------------------------
+
+    // Captures global keyboard and mouse input from the moment it is constructed.
+    // A capture thread pushes events into a lock-free ring which the owner drains
+    // in batches; timestamps are steady_clock time since its epoch. If the owner
+    // falls a full ring behind, new events are dropped and counted.
+    //
+    // Linux: XInput2 raw events on X11; on Wayland (or without a display) the
+    // evdev nodes under /dev/input, which need read access (usually the 'input' group).
+    // Windows: low-level keyboard and mouse hooks.
+    //
+    // Drain a stream from one thread at a time.
+    class EventStream
+    {
+    public:
+        explicit EventStream(size_t capacity = 4096);
+        ~EventStream();
+
+        // False if no capture source could be started
+        bool IsActive() const;
+        // Copies up to `max` pending events into `out` without blocking
+        size_t Poll(TimedEvent *out, size_t max);
+        // Like Poll, but blocks up to `timeout` for the first event to arrive
+        size_t Wait(TimedEvent *out, size_t max, std::chrono::milliseconds timeout);
+        // Events lost because the ring was full
+        size_t Dropped() const;
+        // Stops capturing; events already buffered can still be drained
+        void Stop();
+
+        EventStream(const EventStream &) = delete;
+        EventStream &operator=(const EventStream &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    // ----------------------------------------------------
+    // BACKEND SELECTION
+    // ----------------------------------------------------
+
+    enum class Backend
+    {
+        // Linux: libei on Wayland sessions, XTest otherwise. The only backend elsewhere.
+        Auto,
+        // XTest through the X server (or XWayland)
+        X11,
+        // libei through the RemoteDesktop portal
+        Wayland,
+        // A virtual kernel device via /dev/uinput: works under X11, Wayland and on
+        // the console with no portal, but needs write access to /dev/uinput.
+        // Text is typed as US QWERTY and SetCursorPosition needs an X screen for scaling.
+        Uinput,
+        // An in-process simulated desktop on every platform: nothing reaches the
+        // OS. Events are recorded into a preallocated buffer and IsKeyPressed /
+        // GetCursorPosition answer from the simulated state. Text is typed as US QWERTY.
+        Null,
+        // Forwards calls to a crossinputd process (Linux), which injects them
+        // through its own backend; see ConnectDaemon
+        Daemon
+    };
+
+    // Chooses how input is injected. Returns false, keeping the current backend,
+    // if `backend` is unavailable in this build or session. Reading state
+    // (IsKeyPressed, GetCursorPosition) is unaffected except under Backend::Null.
+    bool SetBackend(Backend backend);
+    // The backend in use, with Auto resolved
+    Backend GetBackend();
+
+    // How Backend::Wayland retries after the portal or EIS connection fails.
+    // Failures are shared by all threads. While backing off no handshake is
+    // attempted: input goes through XTest instead when `fallbackToX11` is set
+    // and an X display exists (reaching XWayland clients only), and is
+    // dropped otherwise.
+    struct ReconnectPolicy
+    {
+        // Wait after the first failure, doubled after each further one
+        std::chrono::milliseconds initialBackoff = std::chrono::seconds(1);
+        std::chrono::milliseconds maxBackoff = std::chrono::seconds(60);
+        // Failed attempts before giving up for good; 0 retries forever
+        int maxAttempts = 5;
+        bool fallbackToX11 = false;
+    };
+
+    // Applies `policy` and forgets earlier failures, so the next call retries
+    void SetReconnectPolicy(const ReconnectPolicy &policy);
+
+    // Makes Backend::Wayland talk to an EIS server over `fd`, an already
+    // connected socket, instead of asking the RemoteDesktop portal: for example
+    // a compositor's test socket or an in-process libeis server. The next
+    // thread to inject through libei adopts it, replacing its connection.
+    // Takes ownership of `fd` on success; returns false without libei support.
+    bool UseEisConnection(int fd);
+
+    // Clears the Null backend's desktop: cursor at the origin, no keys held,
+    // nothing recorded. The cursor is clamped to `width` x `height`; up to
+    // `capacity` events are recorded (the buffer is allocated here, later
+    // events are counted as dropped).
+    void ResetNullBackend(int width = 1920, int height = 1080, size_t capacity = 65536);
+    // Events the Null backend received since the last reset, oldest first.
+    // TypeText is recorded as the key events it expands to.
+    std::vector<InputEvent> GetNullBackendEvents();
+    // Events not recorded because the buffer was full
+    size_t GetNullBackendDropped();
+
+    // ----------------------------------------------------
+    // INJECTOR DAEMON
+    // ----------------------------------------------------
+
+    // $XDG_RUNTIME_DIR/crossinputd.sock, or /tmp/crossinputd-<uid>/crossinputd.sock
+    // without XDG_RUNTIME_DIR; the daemon creates that directory 0700 and both
+    // sides refuse it otherwise. Empty where the daemon is unsupported.
+    std::string DefaultDaemonSocket();
+
+    // Connects to the daemon listening on `socketPath` and selects
+    // Backend::Daemon. Calls are written to a ring in memory shared with the
+    // daemon and return without waiting for it; use Sync() to wait until the
+    // daemon has injected them. Returns false, keeping the current backend, if
+    // no daemon answers. SetBackend(Backend::Daemon) connects to
+    // DefaultDaemonSocket().
+    bool ConnectDaemon(const std::string &socketPath = DefaultDaemonSocket());
+
+    // Serves the injection calls of every process connected with ConnectDaemon
+    // from one thread, through one backend connection (one portal session on
+    // Wayland). The crossinputd tool runs one of these; tests can run it
+    // in-process. Linux only.
+    class InjectorDaemon
+    {
+    public:
+        // `backend` is used on the daemon's thread only and cannot be Backend::Daemon
+        explicit InjectorDaemon(const std::string &socketPath = DefaultDaemonSocket(),
+                                Backend backend = Backend::Auto);
+        ~InjectorDaemon();
+
+        // False if the socket could not be bound, the backend is unavailable,
+        // another daemon already listens on the path, or a file other than a
+        // stale socket is in the way
+        bool IsRunning() const;
+        size_t ClientCount() const;
+        // Disconnects every client and removes the socket
+        void Stop();
+
+        InjectorDaemon(const InjectorDaemon &) = delete;
+        InjectorDaemon &operator=(const InjectorDaemon &) = delete;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+    };
+
+    // ----------------------------------------------------
+    // STATISTICS
+    // ----------------------------------------------------
+
+    // Operations counted by GetStats. Composite calls (KeyPress, MouseClick,
+    // KeyCombination) are counted as the primitive calls they make, and so is
+    // an InputSequence on backends that have no prepared form for it.
+    enum class StatOp
+    {
+        KeyDown,
+        KeyUp,
+        TypeText,
+        MouseButtonDown,
+        MouseButtonUp,
+        SetCursorPosition,
+        MoveCursor,
+        IsKeyPressed,
+        GetCursorPosition,
+        PlaySequence,
+        Count
+    };
+
+    // Log-linear latency histogram in nanoseconds: exact below 16 ns, then
+    // eight buckets per power of two (within 12.5%) up to about 18 minutes.
+    struct LatencyHistogram
+    {
+        static constexpr size_t kBuckets = 304;
+
+        uint64_t counts[kBuckets] = {};
+        uint64_t total = 0;
+
+        // Highest value (ns) in the bucket holding the p-th percentile, p in [0, 100]; 0 if empty
+        uint64_t Percentile(double p) const;
+        // Smallest value (ns) counted in `bucket`
+        static uint64_t BucketLowerBound(size_t bucket);
+    };
+
+    struct OperationStats
+    {
+        uint64_t calls = 0;
+        // Calls that could not reach the backend (no display, no device, write failed)
+        uint64_t failures = 0;
+        // Duration of the whole call
+        LatencyHistogram submit;
+    };
+
+    struct Stats
+    {
+        OperationStats operations[static_cast<size_t>(StatOp::Count)];
+        // Time spent handing events to the display server, EIS or the kernel
+        LatencyHistogram flush;
+        // Backend connections re-established after being lost
+        uint64_t reconnects = 0;
+        // Events waiting in all Schedulers now, and the most seen at once
+        uint64_t schedulerQueueDepth = 0;
+        uint64_t schedulerQueueHighWater = 0;
+
+        const OperationStats &operator[](StatOp op) const { return operations[static_cast<size_t>(op)]; }
+    };
+
+    // Statistics are off until enabled. While on, a call costs a clock read and a
+    // few relaxed stores to counters owned by the calling thread. Building with
+    // -DCROSSINPUT_NO_STATS removes the instrumentation; GetStats then returns zeros.
+    void EnableStats(bool enabled);
+    // Totals over all threads since the last ResetStats
+    Stats GetStats();
+    void ResetStats();
+
+    // ----------------------------------------------------
+    // TRACING
+    // ----------------------------------------------------
+
+    // Starts a trace session: portal steps, device resume, emulation frames and
+    // flushes are recorded into a preallocated buffer per thread. Events past
+    // `eventsPerThread` are dropped and counted. Starting again discards the
+    // previous session. Building with -DCROSSINPUT_NO_TRACE removes the trace points.
+    void StartTracing(size_t eventsPerThread = 65536);
+    void StopTracing();
+    // Writes the current session in Chrome trace JSON, for chrome://tracing or
+    // ui.perfetto.dev. Can be called while tracing; returns false if the file
+    // cannot be written.
+    bool WriteTrace(const std::string &path);
+
     // ----------------------------------------------------
     // SYSTEM INFO
     // ----------------------------------------------------
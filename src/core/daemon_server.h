@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../../include/CrossInput.h"
+#include <memory>
+#include <string>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // A running injector daemon thread; destroying it disconnects every
+        // client and removes the socket
+        class DaemonServer
+        {
+        public:
+            virtual ~DaemonServer() = default;
+            virtual size_t clientCount() const = 0;
+        };
+
+        // Implemented per platform. Returns nullptr if the daemon cannot start.
+        std::unique_ptr<DaemonServer> startDaemonServer(const std::string &socketPath, Backend backend);
+
+    } // namespace Internal
+} // namespace CrossInput
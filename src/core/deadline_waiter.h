@@ -0,0 +1,190 @@
+#pragma once
+
+#include "../platform/platform_detect.h"
+#include <chrono>
+
+#include <condition_variable>
+#include <mutex>
+
+#ifdef CROSSINPUT_LINUX
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Sleeps until an absolute steady_clock deadline, interruptible from
+        // other threads via wake().
+        //
+        // On Linux this arms a CLOCK_MONOTONIC timerfd with TFD_TIMER_ABSTIME and
+        // polls it together with an eventfd, so there is no drift from computing
+        // relative timeouts and a wake-up never races with re-arming. Elsewhere,
+        // or when the descriptors cannot be created, it falls back to a
+        // condition variable.
+        class DeadlineWaiter
+        {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+#ifdef CROSSINPUT_LINUX
+            DeadlineWaiter()
+                : timer_fd_(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)),
+                  wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+            {
+                // poll() would ignore a missing descriptor and block forever
+                if (timer_fd_ < 0 || wake_fd_ < 0)
+                {
+                    closeFds();
+                    timer_fd_ = wake_fd_ = -1;
+                }
+            }
+
+            ~DeadlineWaiter() { closeFds(); }
+
+            // Returns true when the deadline passed, false when woken early
+            bool waitUntil(Clock::time_point deadline)
+            {
+                if (timer_fd_ < 0)
+                    return waitUntilNotified(deadline);
+
+                // libstdc++'s steady_clock is CLOCK_MONOTONIC, so the epoch matches
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+                if (ns <= 0)
+                    return true;
+
+                itimerspec spec = {};
+                spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+                spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+                timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+                pollfd fds[2] = {{timer_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+                while (poll(fds, 2, -1) < 0 && errno == EINTR)
+                {
+                }
+
+                uint64_t value;
+                if (fds[1].revents & POLLIN)
+                {
+                    ssize_t ignored = read(wake_fd_, &value, sizeof(value));
+                    (void)ignored;
+                    return false;
+                }
+                if (fds[0].revents & POLLIN)
+                {
+                    ssize_t ignored = read(timer_fd_, &value, sizeof(value));
+                    (void)ignored;
+                }
+                return true;
+            }
+
+            // Blocks until wake() is called
+            void waitForWake()
+            {
+                if (wake_fd_ < 0)
+                    return waitForNotify();
+
+                pollfd pfd = {wake_fd_, POLLIN, 0};
+                while (poll(&pfd, 1, -1) < 0 && errno == EINTR)
+                {
+                }
+
+                uint64_t value;
+                ssize_t ignored = read(wake_fd_, &value, sizeof(value));
+                (void)ignored;
+            }
+
+            void wake()
+            {
+                if (wake_fd_ < 0)
+                    return notify();
+
+                uint64_t one = 1;
+                ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+                (void)ignored;
+            }
+
+        private:
+            void closeFds()
+            {
+                if (timer_fd_ >= 0)
+                    close(timer_fd_);
+                if (wake_fd_ >= 0)
+                    close(wake_fd_);
+            }
+
+            int timer_fd_;
+            int wake_fd_;
+#else
+            DeadlineWaiter() = default;
+
+            bool waitUntil(Clock::time_point deadline) { return waitUntilNotified(deadline); }
+            void waitForWake() { waitForNotify(); }
+            void wake() { notify(); }
+#endif
+
+        private:
+            bool waitUntilNotified(Clock::time_point deadline)
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                bool woken = cv_.wait_until(lock, deadline, [this]
+                                            { return woken_; });
+                woken_ = false;
+                return !woken;
+            }
+
+            void waitForNotify()
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]
+                         { return woken_; });
+                woken_ = false;
+            }
+
+            void notify()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    woken_ = true;
+                }
+                cv_.notify_one();
+            }
+
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            bool woken_ = false;
+
+        public:
+            // Non-copyable
+            DeadlineWaiter(const DeadlineWaiter &) = delete;
+            DeadlineWaiter &operator=(const DeadlineWaiter &) = delete;
+        };
+
+        // Sleeps until `spinTail` before the deadline, then busy-waits the rest.
+        // Returns false if woken early (the caller should re-check its queue).
+        inline bool preciseWaitUntil(DeadlineWaiter &waiter,
+                                     DeadlineWaiter::Clock::time_point deadline,
+                                     std::chrono::nanoseconds spinTail)
+        {
+            auto sleepUntil = deadline - spinTail;
+            if (DeadlineWaiter::Clock::now() < sleepUntil)
+            {
+                if (!waiter.waitUntil(sleepUntil))
+                    return false;
+            }
+
+            while (DeadlineWaiter::Clock::now() < deadline)
+            {
+                // Spin: the scheduler wakes far enough ahead that this is short
+            }
+            return true;
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../../include/CrossInput.h"
+#include "deadline_waiter.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <memory>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Where a capture thread delivers events. The capture thread is the only
+        // producer; EventStream is the only consumer.
+        struct CaptureSink
+        {
+            explicit CaptureSink(size_t capacity) : ring(capacity) {}
+
+            // Drops the event if the consumer has fallen a full ring behind
+            void push(const InputEvent &event, std::chrono::nanoseconds timestamp)
+            {
+                if (!ring.tryPush(TimedEvent{event, timestamp}))
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Wakes a consumer blocked in EventStream::Wait; call once per batch
+            // of pushes rather than per event
+            void flush() { waiter.wake(); }
+
+            SpscRing<TimedEvent> ring;
+            std::atomic<size_t> dropped{0};
+            DeadlineWaiter waiter;
+        };
+
+        // A running capture thread; destroying it stops the thread
+        class CaptureSource
+        {
+        public:
+            virtual ~CaptureSource() = default;
+        };
+
+        // Implemented per platform. Returns nullptr if no source can be opened.
+        std::unique_ptr<CaptureSource> startCapture(CaptureSink &sink);
+
+        inline std::chrono::nanoseconds captureTimestamp()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch());
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
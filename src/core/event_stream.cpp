@@ -0,0 +1,63 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+#include "event_capture.h"
+
+namespace CrossInput
+{
+
+    struct EventStream::Impl
+    {
+        explicit Impl(size_t capacity) : sink(capacity) {}
+
+        // Declared after the sink so the capture thread stops before the ring goes away
+        Internal::CaptureSink sink;
+        std::unique_ptr<Internal::CaptureSource> source;
+    };
+
+    EventStream::EventStream(size_t capacity)
+        : impl_(new Impl(capacity))
+    {
+        impl_->source = Internal::startCapture(impl_->sink);
+    }
+
+    EventStream::~EventStream()
+    {
+        Stop();
+    }
+
+    bool EventStream::IsActive() const
+    {
+        return impl_->source != nullptr;
+    }
+
+    size_t EventStream::Poll(TimedEvent *out, size_t max)
+    {
+        return impl_->sink.ring.popBatch(out, max);
+    }
+
+    size_t EventStream::Wait(TimedEvent *out, size_t max, std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;)
+        {
+            size_t count = impl_->sink.ring.popBatch(out, max);
+            if (count > 0 || !impl_->source)
+                return count;
+            // A wake posted between the pop and this call stays pending in the
+            // waiter, so the next loop iteration still sees the new events
+            if (impl_->sink.waiter.waitUntil(deadline))
+                return impl_->sink.ring.popBatch(out, max);
+        }
+    }
+
+    size_t EventStream::Dropped() const
+    {
+        return impl_->sink.dropped.load(std::memory_order_relaxed);
+    }
+
+    void EventStream::Stop()
+    {
+        impl_->source.reset();
+    }
+
+} // namespace CrossInput
@@ -0,0 +1,40 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+
+namespace CrossInput
+{
+
+    void SubmitEvent(const InputEvent &event)
+    {
+        switch (event.type)
+        {
+        case EventType::KeyDown:
+            KeyDown(event.key);
+            break;
+        case EventType::KeyUp:
+            KeyUp(event.key);
+            break;
+        case EventType::MouseButtonDown:
+            MouseButtonDown(event.button);
+            break;
+        case EventType::MouseButtonUp:
+            MouseButtonUp(event.button);
+            break;
+        case EventType::SetCursorPosition:
+            SetCursorPosition(event.pos);
+            break;
+        case EventType::MoveCursor:
+            MoveCursor(event.pos.x, event.pos.y);
+            break;
+        }
+    }
+
+    void SubmitEvents(const InputEvent *events, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            SubmitEvent(events[i]);
+        }
+    }
+
+} // namespace CrossInput
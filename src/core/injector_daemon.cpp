@@ -0,0 +1,40 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+#include "daemon_server.h"
+
+namespace CrossInput
+{
+
+    struct InjectorDaemon::Impl
+    {
+        std::unique_ptr<Internal::DaemonServer> server;
+    };
+
+    InjectorDaemon::InjectorDaemon(const std::string &socketPath, Backend backend)
+        : impl_(new Impl())
+    {
+        if (backend != Backend::Daemon)
+            impl_->server = Internal::startDaemonServer(socketPath, backend);
+    }
+
+    InjectorDaemon::~InjectorDaemon()
+    {
+        Stop();
+    }
+
+    bool InjectorDaemon::IsRunning() const
+    {
+        return impl_->server != nullptr;
+    }
+
+    size_t InjectorDaemon::ClientCount() const
+    {
+        return impl_->server ? impl_->server->clientCount() : 0;
+    }
+
+    void InjectorDaemon::Stop()
+    {
+        impl_->server.reset();
+    }
+
+} // namespace CrossInput
@@ -0,0 +1,83 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+#include "input_sequence.h"
+#include "stats.h"
+#include <mutex>
+
+namespace CrossInput
+{
+
+    struct InputSequence::Impl
+    {
+        std::vector<InputEvent> events;
+
+        // The last translation and the backend it was made for. Players copy
+        // the pointer under the mutex and send outside it.
+        std::mutex mutex;
+        Backend preparedFor = Backend::Auto;
+        std::shared_ptr<const Internal::PreparedSequence> prepared;
+    };
+
+    InputSequence::InputSequence(const InputEvent *events, size_t count)
+        : impl_(new Impl())
+    {
+        impl_->events.assign(events, events + count);
+    }
+
+    InputSequence::InputSequence(std::initializer_list<InputEvent> events)
+        : InputSequence(events.begin(), events.size())
+    {
+    }
+
+    InputSequence::~InputSequence() = default;
+
+    InputSequence InputSequence::Chord(std::initializer_list<KeyCode> keys)
+    {
+        std::vector<InputEvent> events;
+        events.reserve(keys.size() * 2);
+        for (KeyCode key : keys)
+            events.push_back(InputEvent::Key(key, true));
+        for (auto it = std::rbegin(keys); it != std::rend(keys); ++it)
+            events.push_back(InputEvent::Key(*it, false));
+        return InputSequence(events.data(), events.size());
+    }
+
+    void InputSequence::Play() const
+    {
+        Backend backend = GetBackend();
+        std::shared_ptr<const Internal::PreparedSequence> prepared;
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            if (impl_->preparedFor == backend)
+                prepared = impl_->prepared;
+        }
+
+        if (prepared)
+        {
+            Internal::StatScope stat(StatOp::PlaySequence);
+            if (prepared->play())
+                return;
+        }
+
+        prepared = Internal::prepareSequence(backend, impl_->events.data(), impl_->events.size());
+        if (prepared)
+        {
+            {
+                std::lock_guard<std::mutex> lock(impl_->mutex);
+                impl_->preparedFor = backend;
+                impl_->prepared = prepared;
+            }
+            Internal::StatScope stat(StatOp::PlaySequence);
+            if (prepared->play())
+                return;
+        }
+
+        SubmitEvents(impl_->events.data(), impl_->events.size());
+    }
+
+    size_t InputSequence::Size() const
+    {
+        return impl_->events.size();
+    }
+
+} // namespace CrossInput
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../include/CrossInput.h"
+#include <memory>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // An InputSequence translated for one backend. Immutable once built, so
+        // several threads may play it at once.
+        class PreparedSequence
+        {
+        public:
+            virtual ~PreparedSequence() = default;
+            // Sends the events. Returns false, sending nothing, if the
+            // translation no longer holds (the keyboard mapping changed).
+            virtual bool play() const = 0;
+        };
+
+        // Implemented per platform. Returns nullptr when `backend` has no
+        // prepared form or cannot translate right now; the events are then
+        // sent one by one.
+        std::shared_ptr<const PreparedSequence> prepareSequence(Backend backend, const InputEvent *events,
+                                                                size_t count);
+
+    } // namespace Internal
+} // namespace CrossInput
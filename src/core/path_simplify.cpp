@@ -0,0 +1,387 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace CrossInput
+{
+    namespace
+    {
+        // Integer path point; relative runs accumulate deltas, which must stay exact
+        struct PathPoint
+        {
+            long long x;
+            long long y;
+        };
+
+        enum class RunType
+        {
+            None,
+            Absolute,
+            Relative
+        };
+
+        RunType runTypeOf(EventType type)
+        {
+            switch (type)
+            {
+            case EventType::SetCursorPosition:
+                return RunType::Absolute;
+            case EventType::MoveCursor:
+                return RunType::Relative;
+            default:
+                return RunType::None;
+            }
+        }
+
+        // Distance from p to the segment a-b
+        double segmentDistance(const PathPoint &p, const PathPoint &a, const PathPoint &b)
+        {
+            double dx = static_cast<double>(b.x - a.x);
+            double dy = static_cast<double>(b.y - a.y);
+            double px = static_cast<double>(p.x - a.x);
+            double py = static_cast<double>(p.y - a.y);
+
+            double lengthSq = dx * dx + dy * dy;
+            double t = lengthSq > 0.0 ? (px * dx + py * dy) / lengthSq : 0.0;
+            if (t < 0.0)
+                t = 0.0;
+            else if (t > 1.0)
+                t = 1.0;
+
+            double ex = px - t * dx;
+            double ey = py - t * dy;
+            return std::sqrt(ex * ex + ey * ey);
+        }
+
+        double triangleArea(const PathPoint &a, const PathPoint &b, const PathPoint &c)
+        {
+            double cross = static_cast<double>(b.x - a.x) * static_cast<double>(c.y - a.y) -
+                           static_cast<double>(c.x - a.x) * static_cast<double>(b.y - a.y);
+            return std::fabs(cross) * 0.5;
+        }
+
+        // Iterative Douglas-Peucker; deep recursion would overflow on long straight runs
+        void douglasPeucker(const std::vector<PathPoint> &points, double tolerance, std::vector<char> &keep)
+        {
+            std::vector<std::pair<size_t, size_t>> ranges;
+            ranges.emplace_back(0, points.size() - 1);
+
+            while (!ranges.empty())
+            {
+                size_t first = ranges.back().first;
+                size_t last = ranges.back().second;
+                ranges.pop_back();
+
+                double maxDistance = -1.0;
+                size_t farthest = first;
+                for (size_t i = first + 1; i < last; ++i)
+                {
+                    double distance = segmentDistance(points[i], points[first], points[last]);
+                    if (distance > maxDistance)
+                    {
+                        maxDistance = distance;
+                        farthest = i;
+                    }
+                }
+
+                if (maxDistance > tolerance)
+                {
+                    keep[farthest] = 1;
+                    ranges.emplace_back(first, farthest);
+                    ranges.emplace_back(farthest, last);
+                }
+            }
+        }
+
+        // Visvalingam-Whyatt: removes points in order of the smallest triangle they form
+        // with their current neighbours. A point is only removed while it lies within
+        // `tolerance` of the segment joining those neighbours, so the tolerance keeps
+        // its pixel meaning instead of being an abstract area.
+        void visvalingam(const std::vector<PathPoint> &points, double tolerance, std::vector<char> &keep)
+        {
+            const size_t n = points.size();
+
+            std::vector<size_t> prev(n), next(n);
+            std::vector<unsigned> version(n, 0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                prev[i] = i - 1;
+                next[i] = i + 1;
+                keep[i] = 1;
+            }
+
+            struct Candidate
+            {
+                double area;
+                size_t index;
+                unsigned version;
+                bool operator>(const Candidate &other) const { return area > other.area; }
+            };
+            std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+
+            for (size_t i = 1; i + 1 < n; ++i)
+                heap.push(Candidate{triangleArea(points[i - 1], points[i], points[i + 1]), i, 0});
+
+            while (!heap.empty())
+            {
+                Candidate smallest = heap.top();
+                heap.pop();
+
+                size_t i = smallest.index;
+                if (smallest.version != version[i])
+                    continue; // stale entry, the point's neighbours changed
+                if (segmentDistance(points[i], points[prev[i]], points[next[i]]) > tolerance)
+                    continue; // stays until a neighbour is removed and it is re-ranked
+
+                keep[i] = 0;
+                next[prev[i]] = next[i];
+                prev[next[i]] = prev[i];
+
+                for (size_t neighbour : {prev[i], next[i]})
+                {
+                    if (neighbour == 0 || neighbour == n - 1)
+                        continue;
+                    ++version[neighbour];
+                    heap.push(Candidate{triangleArea(points[prev[neighbour]], points[neighbour], points[next[neighbour]]),
+                                        neighbour, version[neighbour]});
+                }
+            }
+        }
+
+        void simplifyRun(const std::vector<TimedEvent> &events, size_t begin, size_t end, RunType type,
+                         double tolerance, SimplifyMethod method, std::vector<TimedEvent> &out)
+        {
+            // Relative runs start from an implicit origin: the position before the run
+            std::vector<PathPoint> points;
+            points.reserve(end - begin + 1);
+            if (type == RunType::Relative)
+                points.push_back(PathPoint{0, 0});
+
+            PathPoint cumulative{0, 0};
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Point &pos = events[i].event.pos;
+                if (type == RunType::Relative)
+                {
+                    cumulative.x += pos.x;
+                    cumulative.y += pos.y;
+                    points.push_back(cumulative);
+                }
+                else
+                {
+                    points.push_back(PathPoint{pos.x, pos.y});
+                }
+            }
+
+            // Endpoints are always kept, so a run this short has nothing to drop
+            if (points.size() <= 2)
+            {
+                out.insert(out.end(), events.begin() + begin, events.begin() + end);
+                return;
+            }
+
+            std::vector<char> keep(points.size(), 0);
+            keep.front() = 1;
+            keep.back() = 1;
+            if (method == SimplifyMethod::Visvalingam)
+                visvalingam(points, tolerance, keep);
+            else
+                douglasPeucker(points, tolerance, keep);
+
+            if (type == RunType::Absolute)
+            {
+                for (size_t i = 0; i < points.size(); ++i)
+                {
+                    if (keep[i])
+                        out.push_back(events[begin + i]);
+                }
+                return;
+            }
+
+            PathPoint last{0, 0};
+            for (size_t i = 1; i < points.size(); ++i)
+            {
+                if (!keep[i])
+                    continue;
+                int dx = static_cast<int>(points[i].x - last.x);
+                int dy = static_cast<int>(points[i].y - last.y);
+                out.push_back(TimedEvent{InputEvent::MoveBy(dx, dy), events[begin + i - 1].timestamp});
+                last = points[i];
+            }
+        }
+
+        // Longest run of points held back by the streaming simplifier
+        constexpr size_t kMaxWindow = 256;
+    } // namespace
+
+    std::vector<TimedEvent> SimplifyPath(const std::vector<TimedEvent> &events, double tolerance, SimplifyMethod method)
+    {
+        std::vector<TimedEvent> out;
+        out.reserve(events.size() / 8 + 16);
+
+        size_t i = 0;
+        while (i < events.size())
+        {
+            RunType type = runTypeOf(events[i].event.type);
+            if (type == RunType::None)
+            {
+                out.push_back(events[i++]);
+                continue;
+            }
+
+            size_t end = i + 1;
+            while (end < events.size() && runTypeOf(events[end].event.type) == type)
+                ++end;
+
+            simplifyRun(events, i, end, type, tolerance, method, out);
+            i = end;
+        }
+        return out;
+    }
+
+    // --- PathSimplifier ---
+
+    struct PathSimplifier::Impl
+    {
+        struct Pending
+        {
+            PathPoint point;
+            TimedEvent event;
+        };
+
+        double tolerance;
+        RunType run = RunType::None;
+        PathPoint anchor{0, 0};     // last emitted point of the current run
+        PathPoint cumulative{0, 0}; // running sum of relative moves
+        std::vector<Pending> pending;
+
+        void emit(const Pending &kept, std::vector<TimedEvent> &out)
+        {
+            if (run == RunType::Absolute)
+            {
+                out.push_back(kept.event);
+            }
+            else
+            {
+                int dx = static_cast<int>(kept.point.x - anchor.x);
+                int dy = static_cast<int>(kept.point.y - anchor.y);
+                out.push_back(TimedEvent{InputEvent::MoveBy(dx, dy), kept.event.timestamp});
+            }
+            anchor = kept.point;
+        }
+
+        void flush(std::vector<TimedEvent> &out)
+        {
+            if (!pending.empty())
+                emit(pending.back(), out);
+            pending.clear();
+            run = RunType::None;
+        }
+    };
+
+    PathSimplifier::PathSimplifier(double tolerance) : impl_(new Impl())
+    {
+        impl_->tolerance = tolerance;
+        impl_->pending.reserve(kMaxWindow);
+    }
+
+    PathSimplifier::~PathSimplifier() = default;
+
+    void PathSimplifier::Push(const TimedEvent &timed, std::vector<TimedEvent> &out)
+    {
+        Impl &s = *impl_;
+        RunType type = runTypeOf(timed.event.type);
+
+        if (type != s.run)
+        {
+            s.flush(out);
+            if (type == RunType::None)
+            {
+                out.push_back(timed);
+                return;
+            }
+
+            s.run = type;
+            if (type == RunType::Absolute)
+            {
+                // The first absolute position of a run is always kept
+                s.anchor = PathPoint{timed.event.pos.x, timed.event.pos.y};
+                out.push_back(timed);
+                return;
+            }
+            s.anchor = PathPoint{0, 0};
+            s.cumulative = PathPoint{0, 0};
+        }
+
+        PathPoint point;
+        if (type == RunType::Relative)
+        {
+            s.cumulative.x += timed.event.pos.x;
+            s.cumulative.y += timed.event.pos.y;
+            point = s.cumulative;
+        }
+        else
+        {
+            point = PathPoint{timed.event.pos.x, timed.event.pos.y};
+        }
+
+        // Opening window: extend the segment from the anchor while every held-back
+        // point stays within tolerance, otherwise commit the last point that fit
+        for (const auto &held : s.pending)
+        {
+            if (segmentDistance(held.point, s.anchor, point) > s.tolerance)
+            {
+                s.emit(s.pending.back(), out);
+                s.pending.clear();
+                break;
+            }
+        }
+
+        s.pending.push_back(Impl::Pending{point, timed});
+        if (s.pending.size() >= kMaxWindow)
+        {
+            s.emit(s.pending.back(), out);
+            s.pending.clear();
+        }
+    }
+
+    void PathSimplifier::Finish(std::vector<TimedEvent> &out)
+    {
+        impl_->flush(out);
+    }
+
+    size_t SimplifyRecording(const std::string &inputPath, const std::string &outputPath, double tolerance)
+    {
+        RecordingReader reader(inputPath);
+        if (!reader.IsOpen())
+            return 0;
+
+        RecordingWriter writer(outputPath);
+        if (!writer.IsOpen())
+            return 0;
+
+        PathSimplifier simplifier(tolerance);
+        std::vector<TimedEvent> ready;
+        size_t written = 0;
+
+        TimedEvent timed;
+        while (reader.Next(timed))
+        {
+            ready.clear();
+            simplifier.Push(timed, ready);
+            for (const auto &event : ready)
+                written += writer.Write(event) ? 1 : 0;
+        }
+
+        ready.clear();
+        simplifier.Finish(ready);
+        for (const auto &event : ready)
+            written += writer.Write(event) ? 1 : 0;
+
+        return writer.Close() ? written : 0;
+    }
+
+} // namespace CrossInput
@@ -0,0 +1,348 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+#include "deadline_waiter.h"
+#include "varint.h"
+#include <cstdio>
+#include <cstring>
+
+#ifndef CROSSINPUT_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Recording file layout:
+//
+//   header:  "CIRC" | version (1 byte) | 3 reserved bytes
+//   record:  type (1 byte) | varint timestamp delta in ns | payload
+//
+//   KeyDown/KeyUp                 varint KeyCode id
+//   MouseButtonDown/Up            varint MouseButton id
+//   SetCursorPosition             zigzag varint x, y relative to the previous absolute position
+//   MoveCursor                    zigzag varint dx, dy
+//
+// A 1 kHz mouse stream encodes to roughly 5 bytes per event.
+
+namespace CrossInput
+{
+    namespace
+    {
+        const uint8_t kMagic[4] = {'C', 'I', 'R', 'C'};
+        constexpr uint8_t kVersion = 1;
+        constexpr size_t kHeaderSize = 8;
+        constexpr size_t kMaxRecordBytes = 1 + 3 * Internal::kMaxVarintBytes;
+
+        constexpr uint64_t kMaxEventType = static_cast<uint64_t>(EventType::MoveCursor);
+        constexpr uint64_t kMaxKeyCode = static_cast<uint64_t>(KeyCode::KEY_BACKSLASH);
+        constexpr uint64_t kMaxMouseButton = static_cast<uint64_t>(MouseButton::Middle);
+    } // namespace
+
+    // --- RecordingWriter ---
+
+    struct RecordingWriter::Impl
+    {
+        FILE *file = nullptr;
+        bool failed = false;
+        std::chrono::nanoseconds lastTimestamp{0};
+        Point lastPosition{0, 0};
+    };
+
+    RecordingWriter::RecordingWriter(const std::string &path) : impl_(new Impl())
+    {
+        impl_->file = std::fopen(path.c_str(), "wb");
+        if (!impl_->file)
+            return;
+
+        // Large buffer: a recording is written as one long sequential stream
+        std::setvbuf(impl_->file, nullptr, _IOFBF, 1 << 20);
+
+        uint8_t header[kHeaderSize] = {kMagic[0], kMagic[1], kMagic[2], kMagic[3], kVersion, 0, 0, 0};
+        if (std::fwrite(header, 1, sizeof(header), impl_->file) != sizeof(header))
+            impl_->failed = true;
+    }
+
+    RecordingWriter::~RecordingWriter()
+    {
+        Close();
+    }
+
+    bool RecordingWriter::IsOpen() const
+    {
+        return impl_->file != nullptr;
+    }
+
+    bool RecordingWriter::Write(const TimedEvent &timed)
+    {
+        if (!impl_->file || impl_->failed)
+            return false;
+        if (timed.timestamp < impl_->lastTimestamp)
+            return false;
+
+        uint8_t buffer[kMaxRecordBytes];
+        size_t n = 0;
+
+        const InputEvent &event = timed.event;
+        buffer[n++] = static_cast<uint8_t>(event.type);
+        n += Internal::encodeVarint(static_cast<uint64_t>((timed.timestamp - impl_->lastTimestamp).count()), buffer + n);
+
+        switch (event.type)
+        {
+        case EventType::KeyDown:
+        case EventType::KeyUp:
+            n += Internal::encodeVarint(static_cast<uint64_t>(event.key), buffer + n);
+            break;
+        case EventType::MouseButtonDown:
+        case EventType::MouseButtonUp:
+            n += Internal::encodeVarint(static_cast<uint64_t>(event.button), buffer + n);
+            break;
+        case EventType::SetCursorPosition:
+            n += Internal::encodeVarint(Internal::zigzagEncode(static_cast<int64_t>(event.pos.x) - impl_->lastPosition.x), buffer + n);
+            n += Internal::encodeVarint(Internal::zigzagEncode(static_cast<int64_t>(event.pos.y) - impl_->lastPosition.y), buffer + n);
+            impl_->lastPosition = event.pos;
+            break;
+        case EventType::MoveCursor:
+            n += Internal::encodeVarint(Internal::zigzagEncode(event.pos.x), buffer + n);
+            n += Internal::encodeVarint(Internal::zigzagEncode(event.pos.y), buffer + n);
+            break;
+        }
+
+        impl_->lastTimestamp = timed.timestamp;
+        if (std::fwrite(buffer, 1, n, impl_->file) != n)
+            impl_->failed = true;
+        return !impl_->failed;
+    }
+
+    bool RecordingWriter::Close()
+    {
+        if (!impl_->file)
+            return !impl_->failed;
+
+        if (std::fclose(impl_->file) != 0)
+            impl_->failed = true;
+        impl_->file = nullptr;
+        return !impl_->failed;
+    }
+
+    // --- RecordingReader ---
+
+    struct RecordingReader::Impl
+    {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        const uint8_t *cursor = nullptr;
+        std::chrono::nanoseconds timestamp{0};
+        Point position{0, 0};
+#ifdef CROSSINPUT_WINDOWS
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+
+        bool map(const std::string &path)
+        {
+#ifdef CROSSINPUT_WINDOWS
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(kHeaderSize))
+                return false;
+
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping)
+                return false;
+
+            void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (!view)
+                return false;
+
+            data = static_cast<const uint8_t *>(view);
+            size = static_cast<size_t>(fileSize.QuadPart);
+            return true;
+#else
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize))
+            {
+                close(fd);
+                return false;
+            }
+
+            void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (view == MAP_FAILED)
+                return false;
+
+            // Recordings are decoded front to back exactly once
+            madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+            data = static_cast<const uint8_t *>(view);
+            size = static_cast<size_t>(st.st_size);
+            return true;
+#endif
+        }
+
+        void unmap()
+        {
+#ifdef CROSSINPUT_WINDOWS
+            if (data)
+                UnmapViewOfFile(data);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (data)
+                munmap(const_cast<uint8_t *>(data), size);
+#endif
+            data = nullptr;
+            size = 0;
+        }
+    };
+
+    RecordingReader::RecordingReader(const std::string &path) : impl_(new Impl())
+    {
+        if (!impl_->map(path))
+        {
+            impl_->unmap();
+            return;
+        }
+
+        if (std::memcmp(impl_->data, kMagic, sizeof(kMagic)) != 0 || impl_->data[4] != kVersion)
+        {
+            fprintf(stderr, "CrossInput: %s is not a CrossInput recording\n", path.c_str());
+            impl_->unmap();
+            return;
+        }
+
+        Rewind();
+    }
+
+    RecordingReader::~RecordingReader()
+    {
+        impl_->unmap();
+    }
+
+    bool RecordingReader::IsOpen() const
+    {
+        return impl_->data != nullptr;
+    }
+
+    void RecordingReader::Rewind()
+    {
+        impl_->cursor = impl_->data ? impl_->data + kHeaderSize : nullptr;
+        impl_->timestamp = std::chrono::nanoseconds(0);
+        impl_->position = Point{0, 0};
+    }
+
+    bool RecordingReader::Next(TimedEvent &out)
+    {
+        if (!impl_->data)
+            return false;
+
+        const uint8_t *p = impl_->cursor;
+        const uint8_t *end = impl_->data + impl_->size;
+        if (p >= end)
+            return false;
+
+        uint64_t type = *p++;
+        if (type > kMaxEventType)
+            return false;
+
+        uint64_t delta;
+        size_t used = Internal::decodeVarint(p, end, delta);
+        if (used == 0)
+            return false;
+        p += used;
+
+        InputEvent event = InputEvent::MoveBy(0, 0);
+        event.type = static_cast<EventType>(type);
+
+        uint64_t a, b;
+        switch (event.type)
+        {
+        case EventType::KeyDown:
+        case EventType::KeyUp:
+            if ((used = Internal::decodeVarint(p, end, a)) == 0 || a > kMaxKeyCode)
+                return false;
+            p += used;
+            event.key = static_cast<KeyCode>(a);
+            break;
+        case EventType::MouseButtonDown:
+        case EventType::MouseButtonUp:
+            if ((used = Internal::decodeVarint(p, end, a)) == 0 || a > kMaxMouseButton)
+                return false;
+            p += used;
+            event.button = static_cast<MouseButton>(a);
+            break;
+        case EventType::SetCursorPosition:
+        case EventType::MoveCursor:
+            if ((used = Internal::decodeVarint(p, end, a)) == 0)
+                return false;
+            p += used;
+            if ((used = Internal::decodeVarint(p, end, b)) == 0)
+                return false;
+            p += used;
+
+            event.pos = Point{static_cast<int>(Internal::zigzagDecode(a)), static_cast<int>(Internal::zigzagDecode(b))};
+            if (event.type == EventType::SetCursorPosition)
+            {
+                event.pos.x += impl_->position.x;
+                event.pos.y += impl_->position.y;
+                impl_->position = event.pos;
+            }
+            break;
+        }
+
+        impl_->cursor = p;
+        impl_->timestamp += std::chrono::nanoseconds(delta);
+        out.event = event;
+        out.timestamp = impl_->timestamp;
+        return true;
+    }
+
+    // --- Replay ---
+
+    size_t ReplayRecording(const std::string &path, const ReplayOptions &options)
+    {
+        RecordingReader reader(path);
+        if (!reader.IsOpen())
+            return 0;
+
+        Internal::DeadlineWaiter waiter;
+        SchedulerClock *clock = options.clock.get();
+        const bool paced = options.speed > 0.0;
+        const auto start = clock ? clock->Now() : std::chrono::steady_clock::now();
+
+        size_t sent = 0;
+        TimedEvent timed;
+        while (reader.Next(timed))
+        {
+            if (paced)
+            {
+                auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>(timed.timestamp / options.speed);
+                if (clock)
+                    clock->AdvanceTo(start + offset);
+                else
+                {
+                    while (!Internal::preciseWaitUntil(waiter, start + offset, options.spinTail))
+                    {
+                        // Nothing else wakes this waiter; just resume waiting
+                    }
+                }
+            }
+
+            SubmitEvent(timed.event);
+            ++sent;
+        }
+        return sent;
+    }
+
+} // namespace CrossInput
@@ -0,0 +1,266 @@
+#include "../platform/platform_detect.h"
+#include "../../include/CrossInput.h"
+#include "deadline_waiter.h"
+#include "stats.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#ifdef CROSSINPUT_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace CrossInput
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        struct PendingEvent
+        {
+            Clock::time_point when;
+            unsigned long long sequence; // keeps events with equal deadlines in FIFO order
+            InputEvent event;
+        };
+
+        struct LaterFirst
+        {
+            bool operator()(const PendingEvent &a, const PendingEvent &b) const
+            {
+                if (a.when != b.when)
+                    return a.when > b.when;
+                return a.sequence > b.sequence;
+            }
+        };
+
+        void applyThreadOptions(const SchedulerOptions &options)
+        {
+#ifdef CROSSINPUT_LINUX
+            if (options.cpu >= 0)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(options.cpu, &set);
+                if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+                    fprintf(stderr, "CrossInput: Failed to pin scheduler thread to CPU %d\n", options.cpu);
+            }
+
+            if (options.realtime)
+            {
+                sched_param param = {};
+                param.sched_priority = options.realtimePriority;
+                if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+                    fprintf(stderr, "CrossInput: SCHED_FIFO unavailable (needs CAP_SYS_NICE)\n");
+            }
+#else
+            (void)options;
+#endif
+        }
+    } // namespace
+
+    // --- VirtualClock ---
+
+    struct VirtualClock::Impl
+    {
+        // Nanoseconds since the steady_clock epoch; read by scheduling threads
+        std::atomic<Clock::rep> now;
+    };
+
+    VirtualClock::VirtualClock(std::chrono::steady_clock::time_point start) : impl_(new Impl())
+    {
+        impl_->now.store(start.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    VirtualClock::~VirtualClock() = default;
+
+    std::chrono::steady_clock::time_point VirtualClock::Now() const
+    {
+        return Clock::time_point(Clock::duration(impl_->now.load(std::memory_order_acquire)));
+    }
+
+    void VirtualClock::AdvanceTo(std::chrono::steady_clock::time_point deadline)
+    {
+        // Time never runs backwards, even for an already-passed deadline
+        Clock::rep target = deadline.time_since_epoch().count();
+        Clock::rep current = impl_->now.load(std::memory_order_relaxed);
+        while (current < target &&
+               !impl_->now.compare_exchange_weak(current, target, std::memory_order_acq_rel))
+        {
+        }
+    }
+
+    void VirtualClock::Advance(std::chrono::nanoseconds delta)
+    {
+        AdvanceTo(Now() + std::chrono::duration_cast<Clock::duration>(delta));
+    }
+
+    // --- Scheduler ---
+
+    struct Scheduler::Impl
+    {
+        SchedulerOptions options;
+        Internal::DeadlineWaiter waiter;
+
+        mutable std::mutex mutex;
+        std::condition_variable drained;
+        std::priority_queue<PendingEvent, std::vector<PendingEvent>, LaterFirst> queue;
+        unsigned long long nextSequence = 0;
+        size_t inFlight = 0;
+        std::vector<EventTiming> timings;
+
+        std::thread thread;
+        std::atomic<bool> running{false};
+
+        Clock::time_point now() const
+        {
+            return options.clock ? options.clock->Now() : Clock::now();
+        }
+
+        void run()
+        {
+            applyThreadOptions(options);
+
+            while (running.load(std::memory_order_acquire))
+            {
+                Clock::time_point deadline;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!queue.empty())
+                        deadline = queue.top().when;
+                    else
+                        deadline = Clock::time_point::max();
+                }
+
+                if (deadline == Clock::time_point::max())
+                {
+                    waiter.waitForWake();
+                    continue;
+                }
+
+                if (options.clock)
+                    options.clock->AdvanceTo(deadline);
+                else if (!Internal::preciseWaitUntil(waiter, deadline, options.spinTail))
+                    continue; // Woken early: a new (possibly earlier) event arrived or we are stopping
+
+                PendingEvent next;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (queue.empty() || queue.top().when > deadline)
+                        continue;
+                    next = queue.top();
+                    queue.pop();
+                    Internal::recordDequeued(1);
+                    ++inFlight;
+                }
+
+                Clock::time_point achieved = now();
+                SubmitEvent(next.event);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    timings.push_back(EventTiming{next.when, achieved});
+                    --inFlight;
+                    if (queue.empty() && inFlight == 0)
+                        drained.notify_all();
+                }
+            }
+        }
+    };
+
+    Scheduler::Scheduler(const SchedulerOptions &options) : impl_(new Impl())
+    {
+        impl_->options = options;
+    }
+
+    Scheduler::~Scheduler()
+    {
+        Stop();
+        // A scheduler that was never started still holds its events
+        Internal::recordDequeued(impl_->queue.size());
+    }
+
+    void Scheduler::Schedule(const InputEvent &event, std::chrono::steady_clock::time_point when)
+    {
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            impl_->queue.push(PendingEvent{when, impl_->nextSequence++, event});
+            Internal::recordQueued(1);
+        }
+        impl_->waiter.wake();
+    }
+
+    void Scheduler::ScheduleAfter(const InputEvent &event, std::chrono::nanoseconds delay)
+    {
+        Schedule(event, impl_->now() + std::chrono::duration_cast<Clock::duration>(delay));
+    }
+
+    void Scheduler::Start()
+    {
+        if (impl_->running.exchange(true))
+            return;
+        impl_->thread = std::thread([this]
+                                    { impl_->run(); });
+    }
+
+    void Scheduler::Wait()
+    {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        impl_->drained.wait(lock, [this]
+                            { return (impl_->queue.empty() && impl_->inFlight == 0) ||
+                                     !impl_->running.load(std::memory_order_acquire); });
+    }
+
+    void Scheduler::Stop()
+    {
+        if (!impl_->running.exchange(false))
+            return;
+        impl_->waiter.wake();
+        if (impl_->thread.joinable())
+            impl_->thread.join();
+
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        Internal::recordDequeued(impl_->queue.size());
+        while (!impl_->queue.empty())
+            impl_->queue.pop();
+        impl_->drained.notify_all();
+    }
+
+    std::vector<EventTiming> Scheduler::GetTimings() const
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        return impl_->timings;
+    }
+
+    TimingReport Scheduler::GetReport() const
+    {
+        std::vector<std::chrono::nanoseconds> errors;
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            errors.reserve(impl_->timings.size());
+            for (const auto &timing : impl_->timings)
+                errors.push_back(timing.achieved - timing.requested);
+        }
+
+        TimingReport report = {};
+        report.events = errors.size();
+        if (errors.empty())
+            return report;
+
+        std::sort(errors.begin(), errors.end());
+        std::chrono::nanoseconds total(0);
+        for (auto error : errors)
+            total += error;
+
+        report.meanError = total / static_cast<long long>(errors.size());
+        report.p50Error = errors[errors.size() / 2];
+        report.p99Error = errors[std::min(errors.size() - 1, errors.size() * 99 / 100)];
+        report.maxError = errors.back();
+        return report;
+    }
+
+} // namespace CrossInput
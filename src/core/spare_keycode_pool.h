@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Keycodes with no keysyms in the server's mapping, lent out to keysyms
+        // the layout cannot type. Only the bookkeeping lives here; the requests
+        // go through a Server, so the policy runs the same against a fake one.
+        //
+        //   Mapping::minKeycode() / maxKeycode()   keycode range
+        //   Mapping::isUnused(keycode)             no keysym at any level
+        //   Mapping::get(keycode, level)           keysym, 0 for none
+        //   Server::sync()                         waits until earlier requests are processed
+        //   Server::remap(keycode, keysym)         maps keysym at both shift levels
+        //   Server::clear(first, count)            unmaps count keycodes from first
+        //
+        // Remapping costs a request, so a keysym keeps its keycode across calls and
+        // slots are only recycled least-recently-used.
+        class SpareKeycodePool
+        {
+        public:
+            using Keysym = unsigned long;
+
+            // Upper bound on keycodes taken from the server's unused range
+            static constexpr size_t kMaxSlots = 32;
+
+            // Reserves the pool on first use; afterwards drops slots whose mapping
+            // was changed by someone else
+            template <typename Mapping>
+            void sync(const Mapping &mapping)
+            {
+                if (!reserved_)
+                {
+                    reserved_ = true;
+                    for (int keycode = mapping.maxKeycode(); keycode >= mapping.minKeycode() && slots_.size() < kMaxSlots; --keycode)
+                    {
+                        if (mapping.isUnused(keycode))
+                            slots_.push_back(Slot{static_cast<unsigned>(keycode), kNone, 0, 0});
+                    }
+                    return;
+                }
+
+                for (size_t i = 0; i < slots_.size();)
+                {
+                    const Slot &slot = slots_[i];
+                    Keysym current = mapping.get(static_cast<int>(slot.keycode), 0);
+                    if (current == slot.keysym || (slot.keysym == kNone && mapping.isUnused(static_cast<int>(slot.keycode))))
+                    {
+                        ++i;
+                        continue;
+                    }
+
+                    byKeysym_.erase(slot.keysym);
+                    slots_[i] = slots_.back();
+                    slots_.pop_back();
+                    reindex();
+                }
+            }
+
+            bool isPooled(int keycode) const
+            {
+                for (const auto &slot : slots_)
+                    if (static_cast<int>(slot.keycode) == keycode)
+                        return true;
+                return false;
+            }
+
+            size_t size() const { return slots_.size(); }
+
+            // Whether some slot is still remapped and needs restoreAll
+            bool dirty() const { return dirty_; }
+
+            // Starts a new call; slots used within one call are only recycled
+            // after a Server::sync
+            void beginCall() { ++generation_; }
+
+            // Keycode that types `keysym`, 0 if the pool is empty
+            template <typename Server>
+            unsigned acquire(Server &server, Keysym keysym)
+            {
+                auto found = byKeysym_.find(keysym);
+                if (found != byKeysym_.end())
+                {
+                    Slot &slot = slots_[found->second];
+                    slot.lastUse = ++clock_;
+                    slot.generation = generation_;
+                    return slot.keycode;
+                }
+
+                if (slots_.empty())
+                    return 0;
+
+                size_t victim = 0;
+                for (size_t i = 1; i < slots_.size(); ++i)
+                    if (slots_[i].lastUse < slots_[victim].lastUse)
+                        victim = i;
+
+                Slot &slot = slots_[victim];
+                if (slot.generation == generation_)
+                {
+                    // The keycode was pressed earlier in this call; let the server
+                    // deliver those events before its meaning changes
+                    server.sync();
+                }
+
+                server.remap(slot.keycode, keysym);
+                dirty_ = true;
+
+                if (slot.keysym != kNone)
+                    byKeysym_.erase(slot.keysym);
+                slot.keysym = keysym;
+                slot.lastUse = ++clock_;
+                slot.generation = generation_;
+                byKeysym_[keysym] = victim;
+                return slot.keycode;
+            }
+
+            // Clears every remapped slot, coalescing adjacent keycodes into one request
+            template <typename Server>
+            void restoreAll(Server &server)
+            {
+                std::vector<unsigned> keycodes;
+                for (auto &slot : slots_)
+                {
+                    if (slot.keysym != kNone)
+                        keycodes.push_back(slot.keycode);
+                    slot.keysym = kNone;
+                    slot.lastUse = 0;
+                }
+                byKeysym_.clear();
+                if (keycodes.empty())
+                    return;
+
+                std::sort(keycodes.begin(), keycodes.end());
+                for (size_t first = 0; first < keycodes.size();)
+                {
+                    size_t last = first;
+                    while (last + 1 < keycodes.size() && keycodes[last + 1] == keycodes[last] + 1)
+                        ++last;
+                    server.clear(keycodes[first], static_cast<unsigned>(last - first + 1));
+                    first = last + 1;
+                }
+                server.sync();
+                dirty_ = false;
+            }
+
+        private:
+            static constexpr Keysym kNone = 0;
+
+            struct Slot
+            {
+                unsigned keycode;
+                Keysym keysym;
+                uint64_t lastUse;
+                uint64_t generation;
+            };
+
+            void reindex()
+            {
+                byKeysym_.clear();
+                for (size_t i = 0; i < slots_.size(); ++i)
+                    if (slots_[i].keysym != kNone)
+                        byKeysym_[slots_[i].keysym] = i;
+            }
+
+            std::vector<Slot> slots_;
+            std::unordered_map<Keysym, size_t> byKeysym_;
+            uint64_t clock_ = 0;
+            uint64_t generation_ = 0;
+            bool reserved_ = false;
+            bool dirty_ = false;
+        };
+
+    } // namespace Internal
+} // namespace CrossInput
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Bounded single-producer/single-consumer ring. Capacity is rounded up to a
+        // power of two; head and tail live on separate cache lines and each side
+        // caches the other's index, so a push or pop touches shared memory only
+        // when its cached view says the ring is full or empty.
+        template <typename T>
+        class SpscRing
+        {
+        public:
+            explicit SpscRing(size_t capacity) : SpscRing(capacity, 0) {}
+
+            // Starts both indices at `firstIndex` instead of 0, so tests can run
+            // the ring across the point where the size_t counters wrap
+            SpscRing(size_t capacity, size_t firstIndex)
+                : mask_(roundUp(capacity) - 1), slots_(mask_ + 1), head_(firstIndex),
+                  cached_tail_(firstIndex), tail_(firstIndex), cached_head_(firstIndex)
+            {
+            }
+
+            size_t capacity() const { return mask_ + 1; }
+
+            // Producer side. Returns false (and drops the item) when the ring is full.
+            bool tryPush(const T &item)
+            {
+                size_t head = head_.load(std::memory_order_relaxed);
+                if (head - cached_tail_ > mask_)
+                {
+                    cached_tail_ = tail_.load(std::memory_order_acquire);
+                    if (head - cached_tail_ > mask_)
+                        return false;
+                }
+                slots_[head & mask_] = item;
+                head_.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer side. Moves up to `max` items into `out`, returns the count.
+            size_t popBatch(T *out, size_t max)
+            {
+                size_t tail = tail_.load(std::memory_order_relaxed);
+                if (cached_head_ == tail)
+                {
+                    cached_head_ = head_.load(std::memory_order_acquire);
+                    if (cached_head_ == tail)
+                        return 0;
+                }
+
+                size_t count = cached_head_ - tail;
+                if (count > max)
+                    count = max;
+                for (size_t i = 0; i < count; ++i)
+                    out[i] = slots_[(tail + i) & mask_];
+                tail_.store(tail + count, std::memory_order_release);
+                return count;
+            }
+
+            SpscRing(const SpscRing &) = delete;
+            SpscRing &operator=(const SpscRing &) = delete;
+
+        private:
+            static size_t roundUp(size_t n)
+            {
+                size_t size = 2;
+                while (size < n)
+                    size <<= 1;
+                return size;
+            }
+
+            const size_t mask_;
+            std::vector<T> slots_;
+
+            alignas(64) std::atomic<size_t> head_;
+            size_t cached_tail_; // producer's view of tail_
+
+            alignas(64) std::atomic<size_t> tail_;
+            size_t cached_head_; // consumer's view of head_
+        };
+
+    } // namespace Internal
+} // namespace CrossInput
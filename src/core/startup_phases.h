@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Milestones on the way to the first injected event. Backends mark the
+        // ones that apply to them; bench/bench_startup.cpp reads them back.
+        enum class StartupPhase
+        {
+            Connect,     // display server / session bus / uinput device node opened
+            Session,     // portal session started, or virtual device created
+            DeviceReady, // EIS devices resumed
+            FirstFrame,  // first event flushed to the backend
+            Count
+        };
+
+        // steady_clock nanoseconds at which each phase was first reached; 0 if not yet
+        inline std::atomic<int64_t> *startupPhaseTimes()
+        {
+            static std::atomic<int64_t> times[static_cast<int>(StartupPhase::Count)] = {};
+            return times;
+        }
+
+        // Records the first time `phase` is reached; later calls cost one relaxed load
+        inline void markStartupPhase(StartupPhase phase)
+        {
+            std::atomic<int64_t> &slot = startupPhaseTimes()[static_cast<int>(phase)];
+            if (slot.load(std::memory_order_relaxed) != 0)
+                return;
+
+            int64_t expected = 0;
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+            slot.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
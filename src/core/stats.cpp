@@ -0,0 +1,169 @@
+#include "stats.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace CrossInput
+{
+    uint64_t LatencyHistogram::BucketLowerBound(size_t bucket)
+    {
+        if (bucket < 16)
+            return bucket;
+        size_t exponent = (bucket - 16) / 8 + 4;
+        return (8 + (bucket - 16) % 8) << (exponent - 3);
+    }
+
+    uint64_t LatencyHistogram::Percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+        rank = rank < 1 ? 1 : (rank > total ? total : rank);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+                return i + 1 < kBuckets ? BucketLowerBound(i + 1) - 1 : BucketLowerBound(i);
+        }
+        return BucketLowerBound(kBuckets - 1);
+    }
+
+#ifndef CROSSINPUT_NO_STATS
+
+    namespace Internal
+    {
+        std::atomic<bool> g_statsEnabled{false};
+        std::atomic<uint64_t> g_schedulerQueueDepth{0};
+        std::atomic<uint64_t> g_schedulerQueueHighWater{0};
+
+        namespace
+        {
+            struct Registry
+            {
+                std::mutex mutex;
+                std::vector<std::unique_ptr<ThreadStats>> blocks;
+                // Totals at the last ResetStats, subtracted from every snapshot
+                Stats baseline;
+            };
+
+            Registry &registry()
+            {
+                // Leaked so threads exiting after static destruction can still release their block
+                static Registry *instance = new Registry();
+                return *instance;
+            }
+
+            void addHistogram(LatencyHistogram &to, const std::atomic<uint64_t> *counts)
+            {
+                for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i)
+                {
+                    uint64_t n = counts[i].load(std::memory_order_relaxed);
+                    to.counts[i] += n;
+                    to.total += n;
+                }
+            }
+
+            void subtractHistogram(LatencyHistogram &from, const LatencyHistogram &baseline)
+            {
+                for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i)
+                    from.counts[i] -= baseline.counts[i];
+                from.total -= baseline.total;
+            }
+
+            // Call with the registry mutex held
+            Stats sumBlocks(const Registry &reg)
+            {
+                Stats stats;
+                for (const auto &block : reg.blocks)
+                {
+                    for (size_t op = 0; op < ThreadStats::kOps; ++op)
+                    {
+                        stats.operations[op].calls += block->calls[op].load(std::memory_order_relaxed);
+                        stats.operations[op].failures += block->failures[op].load(std::memory_order_relaxed);
+                        addHistogram(stats.operations[op].submit, block->submit[op]);
+                    }
+                    addHistogram(stats.flush, block->flush);
+                    stats.reconnects += block->reconnects.load(std::memory_order_relaxed);
+                }
+                return stats;
+            }
+        } // namespace
+
+        ThreadStats *acquireThreadStats()
+        {
+            Registry &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (const auto &block : reg.blocks)
+            {
+                if (!block->inUse.load(std::memory_order_relaxed))
+                {
+                    block->inUse.store(true, std::memory_order_relaxed);
+                    return block.get();
+                }
+            }
+            reg.blocks.push_back(std::make_unique<ThreadStats>());
+            reg.blocks.back()->inUse.store(true, std::memory_order_relaxed);
+            return reg.blocks.back().get();
+        }
+
+        void releaseThreadStats(ThreadStats *stats)
+        {
+            Registry &reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            stats->inUse.store(false, std::memory_order_relaxed);
+        }
+    } // namespace Internal
+
+    void EnableStats(bool enabled)
+    {
+        Internal::g_statsEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    Stats GetStats()
+    {
+        Internal::Registry &reg = Internal::registry();
+        Stats stats;
+        {
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            stats = Internal::sumBlocks(reg);
+            const Stats &base = reg.baseline;
+            for (size_t op = 0; op < Internal::ThreadStats::kOps; ++op)
+            {
+                stats.operations[op].calls -= base.operations[op].calls;
+                stats.operations[op].failures -= base.operations[op].failures;
+                Internal::subtractHistogram(stats.operations[op].submit, base.operations[op].submit);
+            }
+            Internal::subtractHistogram(stats.flush, base.flush);
+            stats.reconnects -= base.reconnects;
+        }
+        stats.schedulerQueueDepth = Internal::g_schedulerQueueDepth.load(std::memory_order_relaxed);
+        stats.schedulerQueueHighWater = Internal::g_schedulerQueueHighWater.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void ResetStats()
+    {
+        Internal::Registry &reg = Internal::registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        // Counters are never written by other threads, so reset by moving the baseline
+        reg.baseline = Internal::sumBlocks(reg);
+        Internal::g_schedulerQueueHighWater.store(Internal::g_schedulerQueueDepth.load(std::memory_order_relaxed),
+                                                  std::memory_order_relaxed);
+    }
+
+#else
+
+    void EnableStats(bool) {}
+
+    Stats GetStats()
+    {
+        return Stats();
+    }
+
+    void ResetStats() {}
+
+#endif // CROSSINPUT_NO_STATS
+
+} // namespace CrossInput
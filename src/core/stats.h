@@ -0,0 +1,183 @@
+#pragma once
+
+#include "../../include/CrossInput.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Histogram bucket for a latency in nanoseconds; see LatencyHistogram
+        inline size_t latencyBucket(uint64_t ns)
+        {
+            if (ns < 16)
+                return static_cast<size_t>(ns);
+            int exponent = 63 - __builtin_clzll(ns);
+            size_t bucket = 16 + static_cast<size_t>(exponent - 4) * 8 + ((ns >> (exponent - 3)) & 7);
+            return bucket < LatencyHistogram::kBuckets ? bucket : LatencyHistogram::kBuckets - 1;
+        }
+
+#ifndef CROSSINPUT_NO_STATS
+
+        // Counters written only by the owning thread. Stores are relaxed
+        // load+store pairs, not read-modify-writes: there is a single writer and
+        // GetStats only needs each value to be untorn. A block outlives its
+        // thread (its totals still count) and is reused by the next new thread.
+        struct ThreadStats
+        {
+            static constexpr size_t kOps = static_cast<size_t>(StatOp::Count);
+
+            std::atomic<bool> inUse{false};
+            std::atomic<uint64_t> calls[kOps] = {};
+            std::atomic<uint64_t> failures[kOps] = {};
+            std::atomic<uint64_t> submit[kOps][LatencyHistogram::kBuckets] = {};
+            std::atomic<uint64_t> flush[LatencyHistogram::kBuckets] = {};
+            std::atomic<uint64_t> reconnects{0};
+
+            // Set by the backend during the current call; owner thread only
+            bool callFailed = false;
+        };
+
+        extern std::atomic<bool> g_statsEnabled;
+        extern std::atomic<uint64_t> g_schedulerQueueDepth;
+        extern std::atomic<uint64_t> g_schedulerQueueHighWater;
+
+        ThreadStats *acquireThreadStats();
+        void releaseThreadStats(ThreadStats *stats);
+
+        inline bool statsEnabled()
+        {
+            return g_statsEnabled.load(std::memory_order_relaxed);
+        }
+
+        inline ThreadStats &threadStats()
+        {
+            struct Handle
+            {
+                ThreadStats *stats = acquireThreadStats();
+                ~Handle() { releaseThreadStats(stats); }
+            };
+            thread_local Handle handle;
+            return *handle.stats;
+        }
+
+        inline void bumpCounter(std::atomic<uint64_t> &counter)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        inline uint64_t statsNow()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+        }
+
+        // Counts one public API call and its duration
+        class StatScope
+        {
+        public:
+            explicit StatScope(StatOp op) : op_(op), start_(0)
+            {
+                if (statsEnabled())
+                {
+                    threadStats().callFailed = false;
+                    start_ = statsNow();
+                }
+            }
+
+            ~StatScope()
+            {
+                if (start_ == 0)
+                    return;
+                uint64_t elapsed = statsNow() - start_;
+                ThreadStats &stats = threadStats();
+                size_t op = static_cast<size_t>(op_);
+                bumpCounter(stats.calls[op]);
+                if (stats.callFailed)
+                    bumpCounter(stats.failures[op]);
+                bumpCounter(stats.submit[op][latencyBucket(elapsed)]);
+            }
+
+            StatScope(const StatScope &) = delete;
+            StatScope &operator=(const StatScope &) = delete;
+
+        private:
+            StatOp op_;
+            uint64_t start_;
+        };
+
+        // Times one hand-off of events to the display server, EIS or the kernel
+        class FlushTimer
+        {
+        public:
+            FlushTimer() : start_(statsEnabled() ? statsNow() : 0) {}
+
+            ~FlushTimer()
+            {
+                if (start_ != 0)
+                    bumpCounter(threadStats().flush[latencyBucket(statsNow() - start_)]);
+            }
+
+            FlushTimer(const FlushTimer &) = delete;
+            FlushTimer &operator=(const FlushTimer &) = delete;
+
+        private:
+            uint64_t start_;
+        };
+
+        // Marks the enclosing StatScope's call as failed
+        inline void markStatFailure()
+        {
+            if (statsEnabled())
+                threadStats().callFailed = true;
+        }
+
+        inline void recordReconnect()
+        {
+            if (statsEnabled())
+                bumpCounter(threadStats().reconnects);
+        }
+
+        // Scheduler queue gauge; tracked regardless of EnableStats so it stays balanced
+        inline void recordQueued(uint64_t count)
+        {
+            uint64_t depth = g_schedulerQueueDepth.fetch_add(count, std::memory_order_relaxed) + count;
+            uint64_t high = g_schedulerQueueHighWater.load(std::memory_order_relaxed);
+            while (depth > high &&
+                   !g_schedulerQueueHighWater.compare_exchange_weak(high, depth, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        inline void recordDequeued(uint64_t count)
+        {
+            g_schedulerQueueDepth.fetch_sub(count, std::memory_order_relaxed);
+        }
+
+#else
+
+        class StatScope
+        {
+        public:
+            explicit StatScope(StatOp) {}
+        };
+
+        class FlushTimer
+        {
+        public:
+            FlushTimer() {}
+        };
+
+        inline void markStatFailure() {}
+        inline void recordReconnect() {}
+        inline void recordQueued(uint64_t) {}
+        inline void recordDequeued(uint64_t) {}
+
+#endif // CROSSINPUT_NO_STATS
+
+    } // namespace Internal
+} // namespace CrossInput
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // nextCodepoint's result for bytes that do not decode. Not a Unicode
+        // value, so it cannot be confused with a literal U+FFFD in the text.
+        constexpr char32_t kInvalidCodepoint = 0xFFFFFFFF;
+
+        // Decodes one UTF-8 codepoint starting at text[pos] and advances pos.
+        // Malformed sequences consume one byte and yield kInvalidCodepoint; so
+        // do overlong forms, surrogates and values past U+10FFFF, so no byte
+        // sequence other than the shortest one can smuggle in a character like '/'.
+        // Callers skip kInvalidCodepoint rather than typing anything for it.
+        inline char32_t nextCodepoint(std::string_view text, size_t &pos)
+        {
+            const unsigned char lead = static_cast<unsigned char>(text[pos]);
+            if (lead < 0x80)
+            {
+                ++pos;
+                return lead;
+            }
+
+            size_t length;
+            char32_t cp;
+            if ((lead & 0xE0) == 0xC0)
+            {
+                length = 2;
+                cp = lead & 0x1F;
+            }
+            else if ((lead & 0xF0) == 0xE0)
+            {
+                length = 3;
+                cp = lead & 0x0F;
+            }
+            else if ((lead & 0xF8) == 0xF0)
+            {
+                length = 4;
+                cp = lead & 0x07;
+            }
+            else
+            {
+                ++pos;
+                return kInvalidCodepoint;
+            }
+
+            if (pos + length > text.size())
+            {
+                ++pos;
+                return kInvalidCodepoint;
+            }
+
+            for (size_t i = 1; i < length; ++i)
+            {
+                const unsigned char cont = static_cast<unsigned char>(text[pos + i]);
+                if ((cont & 0xC0) != 0x80)
+                {
+                    ++pos;
+                    return kInvalidCodepoint;
+                }
+                cp = (cp << 6) | (cont & 0x3F);
+            }
+
+            static const char32_t kMinimum[5] = {0, 0, 0x80, 0x800, 0x10000};
+            if (cp < kMinimum[length] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+            {
+                ++pos;
+                return kInvalidCodepoint;
+            }
+
+            pos += length;
+            return cp;
+        }
+
+        // Modifier bits a keystroke needs held while its key is pressed
+        enum KeystrokeModifier : uint8_t
+        {
+            kModShift = 1 << 0,
+            kModAltGr = 1 << 1,
+        };
+        constexpr int kModifierCount = 2;
+
+        struct Keystroke
+        {
+            uint32_t code;     // backend key code (X11 keycode, evdev code, VK, ...)
+            uint8_t modifiers; // KeystrokeModifier bits
+            bool valid;
+        };
+
+        // Codepoint -> keystroke lookup, built once from the active layout.
+        // Latin-1 is a direct array index; the rest of Unicode falls back to a hash map.
+        class KeystrokeTable
+        {
+        public:
+            KeystrokeTable() { clear(); }
+
+            void clear()
+            {
+                latin1_.fill(Keystroke{0, 0, false});
+                other_.clear();
+            }
+
+            // Keeps the first mapping for a codepoint unless the new one needs fewer modifiers
+            void add(char32_t cp, uint32_t code, uint8_t modifiers)
+            {
+                Keystroke stroke{code, modifiers, true};
+                Keystroke *existing = slot(cp);
+                if (existing)
+                {
+                    if (!existing->valid || modifierCount(modifiers) < modifierCount(existing->modifiers))
+                        *existing = stroke;
+                    return;
+                }
+
+                auto it = other_.find(cp);
+                if (it == other_.end() || modifierCount(modifiers) < modifierCount(it->second.modifiers))
+                    other_[cp] = stroke;
+            }
+
+            Keystroke lookup(char32_t cp) const
+            {
+                if (cp < latin1_.size())
+                    return latin1_[cp];
+                auto it = other_.find(cp);
+                return it != other_.end() ? it->second : Keystroke{0, 0, false};
+            }
+
+            bool empty() const
+            {
+                if (!other_.empty())
+                    return false;
+                for (const auto &stroke : latin1_)
+                    if (stroke.valid)
+                        return false;
+                return true;
+            }
+
+        private:
+            static int modifierCount(uint8_t modifiers)
+            {
+                return ((modifiers & kModShift) ? 1 : 0) + ((modifiers & kModAltGr) ? 1 : 0);
+            }
+
+            Keystroke *slot(char32_t cp) { return cp < latin1_.size() ? &latin1_[cp] : nullptr; }
+
+            std::array<Keystroke, 256> latin1_;
+            std::unordered_map<char32_t, Keystroke> other_;
+        };
+
+        // Types `text` as runs of keystrokes. Modifiers are pressed when a run that
+        // needs them starts and released when it ends, not around every character.
+        //
+        //   sendKey(code, down)      emits one key event into the backend's batch
+        //   modifierCodes[bit]       key code for each KeystrokeModifier bit
+        //   unmapped(cp) -> Keystroke  resolves characters missing from the table
+        //                            (return valid=false to skip the character);
+        //                            never called for bytes that do not decode
+        template <typename SendKey, typename Unmapped>
+        void typeKeystrokes(std::string_view text, const KeystrokeTable &table,
+                            const uint32_t (&modifierCodes)[kModifierCount],
+                            SendKey &&sendKey, Unmapped &&unmapped)
+        {
+            uint8_t held = 0;
+
+            auto setModifiers = [&](uint8_t wanted)
+            {
+                for (int bit = 0; bit < kModifierCount; ++bit)
+                {
+                    const uint8_t mask = static_cast<uint8_t>(1 << bit);
+                    if ((held & mask) != (wanted & mask) && modifierCodes[bit] != 0)
+                        sendKey(modifierCodes[bit], (wanted & mask) != 0);
+                }
+                held = wanted;
+            };
+
+            size_t pos = 0;
+            while (pos < text.size())
+            {
+                char32_t cp = nextCodepoint(text, pos);
+                if (cp == kInvalidCodepoint)
+                    continue;
+                Keystroke stroke = table.lookup(cp);
+                if (!stroke.valid)
+                    stroke = unmapped(cp);
+                if (!stroke.valid)
+                    continue;
+
+                if (stroke.modifiers != held)
+                    setModifiers(stroke.modifiers);
+
+                sendKey(stroke.code, true);
+                sendKey(stroke.code, false);
+            }
+
+            setModifiers(0);
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
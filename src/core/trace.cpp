@@ -0,0 +1,182 @@
+#include "../../include/CrossInput.h"
+#include "trace.h"
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace CrossInput
+{
+#ifndef CROSSINPUT_NO_TRACE
+
+    namespace Internal
+    {
+        std::atomic<bool> g_tracing{false};
+
+        namespace
+        {
+            struct Registry
+            {
+                std::mutex mutex;
+                std::vector<std::unique_ptr<TraceBuffer>> buffers;
+                // Bumped by StartTracing; a buffer from an older session is cleared by its owner
+                std::atomic<uint64_t> epoch{0};
+                std::atomic<size_t> capacity{0};
+                uint32_t nextTid = 1;
+            };
+
+            Registry &registry()
+            {
+                // Leaked so threads exiting after static destruction can still retire their buffer
+                static Registry *instance = new Registry();
+                return *instance;
+            }
+
+            TraceBuffer *registerBuffer()
+            {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                reg.buffers.push_back(std::make_unique<TraceBuffer>());
+                reg.buffers.back()->tid = reg.nextTid++;
+                return reg.buffers.back().get();
+            }
+
+            void retireBuffer(TraceBuffer *buffer)
+            {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                buffer->retired = true;
+            }
+
+            void writeEvent(FILE *file, const TraceEvent &event, uint32_t tid, bool &first)
+            {
+                fprintf(file, "%s\n{\"cat\":\"%s\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                        first ? "" : ",", event.category, event.name, tid,
+                        static_cast<double>(event.startNs) / 1000.0);
+                if (event.durationNs >= 0)
+                    fprintf(file, ",\"ph\":\"X\",\"dur\":%.3f", static_cast<double>(event.durationNs) / 1000.0);
+                else
+                    fprintf(file, ",\"ph\":\"i\",\"s\":\"t\"");
+                if (event.argName)
+                    fprintf(file, ",\"args\":{\"%s\":%lld}", event.argName, static_cast<long long>(event.arg));
+                fputc('}', file);
+                first = false;
+            }
+        } // namespace
+
+        TraceBuffer *threadTraceBuffer()
+        {
+            struct Handle
+            {
+                TraceBuffer *buffer = registerBuffer();
+                ~Handle() { retireBuffer(buffer); }
+            };
+            thread_local Handle handle;
+
+            Registry &reg = registry();
+            TraceBuffer *buffer = handle.buffer;
+            uint64_t epoch = reg.epoch.load(std::memory_order_acquire);
+            if (buffer->epoch.load(std::memory_order_relaxed) != epoch)
+            {
+                // First event of a new session on this thread. WriteTrace skips
+                // buffers from other sessions, so nobody reads while this resets.
+                size_t capacity = reg.capacity.load(std::memory_order_relaxed);
+                if (buffer->capacity != capacity)
+                {
+                    buffer->events.reset(new TraceEvent[capacity]);
+                    buffer->capacity = capacity;
+                }
+                buffer->count.store(0, std::memory_order_relaxed);
+                buffer->dropped.store(0, std::memory_order_relaxed);
+                buffer->epoch.store(epoch, std::memory_order_release);
+            }
+            return buffer->capacity ? buffer : nullptr;
+        }
+    } // namespace Internal
+
+    void StartTracing(size_t eventsPerThread)
+    {
+        Internal::Registry &reg = Internal::registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        // Buffers of exited threads only held the previous session
+        auto &buffers = reg.buffers;
+        for (size_t i = 0; i < buffers.size();)
+        {
+            if (buffers[i]->retired)
+            {
+                buffers[i] = std::move(buffers.back());
+                buffers.pop_back();
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        reg.capacity.store(eventsPerThread, std::memory_order_relaxed);
+        reg.epoch.fetch_add(1, std::memory_order_release);
+        Internal::g_tracing.store(true, std::memory_order_relaxed);
+    }
+
+    void StopTracing()
+    {
+        Internal::g_tracing.store(false, std::memory_order_relaxed);
+    }
+
+    bool WriteTrace(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "CrossInput: Cannot write trace to %s\n", path.c_str());
+            return false;
+        }
+
+        Internal::Registry &reg = Internal::registry();
+        bool first = true;
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+        {
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            uint64_t epoch = reg.epoch.load(std::memory_order_relaxed);
+            for (const auto &buffer : reg.buffers)
+            {
+                if (epoch == 0 || buffer->epoch.load(std::memory_order_acquire) != epoch)
+                    continue;
+
+                size_t count = buffer->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; ++i)
+                    Internal::writeEvent(file, buffer->events[i], buffer->tid, first);
+
+                uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+                if (dropped > 0)
+                {
+                    int64_t end = count ? buffer->events[count - 1].startNs : 0;
+                    Internal::writeEvent(file,
+                                         Internal::TraceEvent{"trace", "Buffer full", "dropped",
+                                                              static_cast<int64_t>(dropped), end, -1},
+                                         buffer->tid, first);
+                }
+            }
+        }
+        fputs("\n]}\n", file);
+        return fclose(file) == 0;
+    }
+
+#else
+
+    void StartTracing(size_t) {}
+
+    void StopTracing() {}
+
+    bool WriteTrace(const std::string &path)
+    {
+        FILE *file = fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        fputs("{\"traceEvents\":[]}\n", file);
+        return fclose(file) == 0;
+    }
+
+#endif // CROSSINPUT_NO_TRACE
+
+} // namespace CrossInput
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+#ifndef CROSSINPUT_NO_TRACE
+
+        // One Chrome trace event. Names, categories and argument names must be
+        // string literals: only the pointers are stored.
+        struct TraceEvent
+        {
+            const char *category;
+            const char *name;
+            const char *argName; // nullptr for no argument
+            int64_t arg;
+            int64_t startNs;
+            int64_t durationNs; // -1 for an instant event
+        };
+
+        // Events recorded by one thread. Only the owner appends; `count` is
+        // published with release so WriteTrace can read a consistent prefix while
+        // the owner keeps recording. A full buffer drops new events.
+        struct TraceBuffer
+        {
+            std::unique_ptr<TraceEvent[]> events;
+            size_t capacity = 0;
+            std::atomic<size_t> count{0};
+            std::atomic<uint64_t> epoch{0};
+            std::atomic<uint64_t> dropped{0};
+            uint32_t tid = 0;
+            bool retired = false; // owner thread exited; guarded by the registry mutex
+        };
+
+        extern std::atomic<bool> g_tracing;
+
+        // The calling thread's buffer for the current trace session, or nullptr
+        TraceBuffer *threadTraceBuffer();
+
+        inline bool tracing()
+        {
+            return g_tracing.load(std::memory_order_relaxed);
+        }
+
+        inline int64_t traceNow()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        inline void traceRecord(const TraceEvent &event)
+        {
+            TraceBuffer *buffer = threadTraceBuffer();
+            if (!buffer)
+                return;
+            size_t n = buffer->count.load(std::memory_order_relaxed);
+            if (n == buffer->capacity)
+            {
+                buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1,
+                                      std::memory_order_relaxed);
+                return;
+            }
+            buffer->events[n] = event;
+            buffer->count.store(n + 1, std::memory_order_release);
+        }
+
+        // Records a complete ("X") event spanning its lifetime; next() closes the
+        // current span and opens another, for sequential steps in one function
+        class TraceScope
+        {
+        public:
+            TraceScope(const char *category, const char *name)
+                : category_(category), name_(name), start_(tracing() ? traceNow() : 0)
+            {
+            }
+
+            ~TraceScope() { end(); }
+
+            void next(const char *name)
+            {
+                end();
+                name_ = name;
+                start_ = tracing() ? traceNow() : 0;
+            }
+
+            TraceScope(const TraceScope &) = delete;
+            TraceScope &operator=(const TraceScope &) = delete;
+
+        private:
+            void end()
+            {
+                if (start_ != 0)
+                    traceRecord(TraceEvent{category_, name_, nullptr, 0, start_, traceNow() - start_});
+                start_ = 0;
+            }
+
+            const char *category_;
+            const char *name_;
+            int64_t start_;
+        };
+
+        inline void traceInstant(const char *category, const char *name)
+        {
+            if (tracing())
+                traceRecord(TraceEvent{category, name, nullptr, 0, traceNow(), -1});
+        }
+
+        inline void traceInstant(const char *category, const char *name, const char *argName, int64_t arg)
+        {
+            if (tracing())
+                traceRecord(TraceEvent{category, name, argName, arg, traceNow(), -1});
+        }
+
+#else
+
+        class TraceScope
+        {
+        public:
+            TraceScope(const char *, const char *) {}
+            void next(const char *) {}
+        };
+
+        inline void traceInstant(const char *, const char *) {}
+        inline void traceInstant(const char *, const char *, const char *, int64_t) {}
+
+#endif // CROSSINPUT_NO_TRACE
+
+    } // namespace Internal
+} // namespace CrossInput
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // LEB128 unsigned varint: 7 bits per byte, high bit marks continuation
+        constexpr size_t kMaxVarintBytes = 10;
+
+        inline size_t encodeVarint(uint64_t value, uint8_t *out)
+        {
+            size_t n = 0;
+            while (value >= 0x80)
+            {
+                out[n++] = static_cast<uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+            out[n++] = static_cast<uint8_t>(value);
+            return n;
+        }
+
+        // Returns the number of bytes consumed, 0 if the input is truncated or overlong
+        inline size_t decodeVarint(const uint8_t *in, const uint8_t *end, uint64_t &value)
+        {
+            value = 0;
+            for (size_t n = 0; n < kMaxVarintBytes && in + n < end; ++n)
+            {
+                value |= static_cast<uint64_t>(in[n] & 0x7F) << (7 * n);
+                if ((in[n] & 0x80) == 0)
+                    return n + 1;
+            }
+            return 0;
+        }
+
+        // Zigzag maps small negative numbers to small unsigned ones: 0,-1,1,-2 -> 0,1,2,3
+        inline uint64_t zigzagEncode(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline int64_t zigzagDecode(uint64_t value)
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
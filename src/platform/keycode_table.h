@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../../include/CrossInput.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Single source for every KeyCode mapping. One row per KeyCode, in enum order:
+//
+//   X(KeyCode, X11 keysym, evdev code, Windows VK, macOS virtual keycode)
+//
+// Each platform header expands only the column it needs, so a column may use
+// that platform's own constants (XK_*, EvdevCodes::*, VK_*, kVK_*). Forward
+// maps are dense arrays indexed by KeyCode; reverse maps are perfect hashes
+// built and checked at compile time.
+#define CROSSINPUT_KEYCODE_TABLE(X) \
+    /* Alphanumeric */ \
+    X(KEY_A,          XK_a,          EVDEV_KEY_A,          0x41,          kVK_ANSI_A) \
+    X(KEY_B,          XK_b,          EVDEV_KEY_B,          0x42,          kVK_ANSI_B) \
+    X(KEY_C,          XK_c,          EVDEV_KEY_C,          0x43,          kVK_ANSI_C) \
+    X(KEY_D,          XK_d,          EVDEV_KEY_D,          0x44,          kVK_ANSI_D) \
+    X(KEY_E,          XK_e,          EVDEV_KEY_E,          0x45,          kVK_ANSI_E) \
+    X(KEY_F,          XK_f,          EVDEV_KEY_F,          0x46,          kVK_ANSI_F) \
+    X(KEY_G,          XK_g,          EVDEV_KEY_G,          0x47,          kVK_ANSI_G) \
+    X(KEY_H,          XK_h,          EVDEV_KEY_H,          0x48,          kVK_ANSI_H) \
+    X(KEY_I,          XK_i,          EVDEV_KEY_I,          0x49,          kVK_ANSI_I) \
+    X(KEY_J,          XK_j,          EVDEV_KEY_J,          0x4A,          kVK_ANSI_J) \
+    X(KEY_K,          XK_k,          EVDEV_KEY_K,          0x4B,          kVK_ANSI_K) \
+    X(KEY_L,          XK_l,          EVDEV_KEY_L,          0x4C,          kVK_ANSI_L) \
+    X(KEY_M,          XK_m,          EVDEV_KEY_M,          0x4D,          kVK_ANSI_M) \
+    X(KEY_N,          XK_n,          EVDEV_KEY_N,          0x4E,          kVK_ANSI_N) \
+    X(KEY_O,          XK_o,          EVDEV_KEY_O,          0x4F,          kVK_ANSI_O) \
+    X(KEY_P,          XK_p,          EVDEV_KEY_P,          0x50,          kVK_ANSI_P) \
+    X(KEY_Q,          XK_q,          EVDEV_KEY_Q,          0x51,          kVK_ANSI_Q) \
+    X(KEY_R,          XK_r,          EVDEV_KEY_R,          0x52,          kVK_ANSI_R) \
+    X(KEY_S,          XK_s,          EVDEV_KEY_S,          0x53,          kVK_ANSI_S) \
+    X(KEY_T,          XK_t,          EVDEV_KEY_T,          0x54,          kVK_ANSI_T) \
+    X(KEY_U,          XK_u,          EVDEV_KEY_U,          0x55,          kVK_ANSI_U) \
+    X(KEY_V,          XK_v,          EVDEV_KEY_V,          0x56,          kVK_ANSI_V) \
+    X(KEY_W,          XK_w,          EVDEV_KEY_W,          0x57,          kVK_ANSI_W) \
+    X(KEY_X,          XK_x,          EVDEV_KEY_X,          0x58,          kVK_ANSI_X) \
+    X(KEY_Y,          XK_y,          EVDEV_KEY_Y,          0x59,          kVK_ANSI_Y) \
+    X(KEY_Z,          XK_z,          EVDEV_KEY_Z,          0x5A,          kVK_ANSI_Z) \
+    X(KEY_0,          XK_0,          EVDEV_KEY_0,          0x30,          kVK_ANSI_0) \
+    X(KEY_1,          XK_1,          EVDEV_KEY_1,          0x31,          kVK_ANSI_1) \
+    X(KEY_2,          XK_2,          EVDEV_KEY_2,          0x32,          kVK_ANSI_2) \
+    X(KEY_3,          XK_3,          EVDEV_KEY_3,          0x33,          kVK_ANSI_3) \
+    X(KEY_4,          XK_4,          EVDEV_KEY_4,          0x34,          kVK_ANSI_4) \
+    X(KEY_5,          XK_5,          EVDEV_KEY_5,          0x35,          kVK_ANSI_5) \
+    X(KEY_6,          XK_6,          EVDEV_KEY_6,          0x36,          kVK_ANSI_6) \
+    X(KEY_7,          XK_7,          EVDEV_KEY_7,          0x37,          kVK_ANSI_7) \
+    X(KEY_8,          XK_8,          EVDEV_KEY_8,          0x38,          kVK_ANSI_8) \
+    X(KEY_9,          XK_9,          EVDEV_KEY_9,          0x39,          kVK_ANSI_9) \
+    /* Function Keys */ \
+    X(KEY_F1,         XK_F1,         EVDEV_KEY_F1,         VK_F1,         kVK_F1) \
+    X(KEY_F2,         XK_F2,         EVDEV_KEY_F2,         VK_F2,         kVK_F2) \
+    X(KEY_F3,         XK_F3,         EVDEV_KEY_F3,         VK_F3,         kVK_F3) \
+    X(KEY_F4,         XK_F4,         EVDEV_KEY_F4,         VK_F4,         kVK_F4) \
+    X(KEY_F5,         XK_F5,         EVDEV_KEY_F5,         VK_F5,         kVK_F5) \
+    X(KEY_F6,         XK_F6,         EVDEV_KEY_F6,         VK_F6,         kVK_F6) \
+    X(KEY_F7,         XK_F7,         EVDEV_KEY_F7,         VK_F7,         kVK_F7) \
+    X(KEY_F8,         XK_F8,         EVDEV_KEY_F8,         VK_F8,         kVK_F8) \
+    X(KEY_F9,         XK_F9,         EVDEV_KEY_F9,         VK_F9,         kVK_F9) \
+    X(KEY_F10,        XK_F10,        EVDEV_KEY_F10,        VK_F10,        kVK_F10) \
+    X(KEY_F11,        XK_F11,        EVDEV_KEY_F11,        VK_F11,        kVK_F11) \
+    X(KEY_F12,        XK_F12,        EVDEV_KEY_F12,        VK_F12,        kVK_F12) \
+    /* Control Keys */ \
+    X(KEY_ESCAPE,     XK_Escape,     EVDEV_KEY_ESC,        VK_ESCAPE,     kVK_Escape) \
+    X(KEY_SPACE,      XK_space,      EVDEV_KEY_SPACE,      VK_SPACE,      kVK_Space) \
+    X(KEY_ENTER,      XK_Return,     EVDEV_KEY_ENTER,      VK_RETURN,     kVK_Return) \
+    X(KEY_TAB,        XK_Tab,        EVDEV_KEY_TAB,        VK_TAB,        kVK_Tab) \
+    X(KEY_SHIFT,      XK_Shift_L,    EVDEV_KEY_LEFTSHIFT,  VK_LSHIFT,     kVK_Shift) \
+    X(KEY_CONTROL,    XK_Control_L,  EVDEV_KEY_LEFTCTRL,   VK_LCONTROL,   kVK_Control) \
+    X(KEY_ALT,        XK_Alt_L,      EVDEV_KEY_LEFTALT,    VK_LMENU,      kVK_Option) \
+    X(KEY_CAPS_LOCK,  XK_Caps_Lock,  EVDEV_KEY_CAPSLOCK,   VK_CAPITAL,    kVK_CapsLock) \
+    X(KEY_BACKSPACE,  XK_BackSpace,  EVDEV_KEY_BACKSPACE,  VK_BACK,       kVK_Delete) \
+    X(KEY_DELETE,     XK_Delete,     EVDEV_KEY_DELETE,     VK_DELETE,     kVK_ForwardDelete) \
+    X(KEY_INSERT,     XK_Insert,     EVDEV_KEY_INSERT,     VK_INSERT,     kVK_Help) \
+    /* Arrow Keys */ \
+    X(KEY_LEFT,       XK_Left,       EVDEV_KEY_LEFT,       VK_LEFT,       kVK_LeftArrow) \
+    X(KEY_RIGHT,      XK_Right,      EVDEV_KEY_RIGHT,      VK_RIGHT,      kVK_RightArrow) \
+    X(KEY_UP,         XK_Up,         EVDEV_KEY_UP,         VK_UP,         kVK_UpArrow) \
+    X(KEY_DOWN,       XK_Down,       EVDEV_KEY_DOWN,       VK_DOWN,       kVK_DownArrow) \
+    /* Symbol Keys */ \
+    X(KEY_COMMA,      XK_comma,      EVDEV_KEY_COMMA,      VK_OEM_COMMA,  kVK_ANSI_Comma) \
+    X(KEY_PERIOD,     XK_period,     EVDEV_KEY_DOT,        VK_OEM_PERIOD, kVK_ANSI_Period) \
+    X(KEY_SEMICOLON,  XK_semicolon,  EVDEV_KEY_SEMICOLON,  VK_OEM_1,      kVK_ANSI_Semicolon) \
+    X(KEY_APOSTROPHE, XK_apostrophe, EVDEV_KEY_APOSTROPHE, VK_OEM_7,      kVK_ANSI_Quote) \
+    X(KEY_SLASH,      XK_slash,      EVDEV_KEY_SLASH,      VK_OEM_2,      kVK_ANSI_Slash) \
+    X(KEY_BACKSLASH,  XK_backslash,  EVDEV_KEY_BACKSLASH,  VK_OEM_5,      kVK_ANSI_Backslash)
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+#define CROSSINPUT_KEYCODE_ROW_ID(name, keysym, evdev, vk, mac) KeyCode::name,
+        constexpr KeyCode kKeyCodeRows[] = {CROSSINPUT_KEYCODE_TABLE(CROSSINPUT_KEYCODE_ROW_ID)};
+#undef CROSSINPUT_KEYCODE_ROW_ID
+
+        constexpr size_t kKeyCodeCount = sizeof(kKeyCodeRows) / sizeof(kKeyCodeRows[0]);
+
+        constexpr bool keycodeRowsInEnumOrder()
+        {
+            for (size_t i = 0; i < kKeyCodeCount; ++i)
+                if (static_cast<size_t>(kKeyCodeRows[i]) != i)
+                    return false;
+            return true;
+        }
+
+        static_assert(kKeyCodeCount == static_cast<size_t>(KeyCode::KEY_BACKSLASH) + 1,
+                      "CROSSINPUT_KEYCODE_TABLE needs exactly one row per KeyCode");
+        static_assert(keycodeRowsInEnumOrder(),
+                      "CROSSINPUT_KEYCODE_TABLE rows must follow the KeyCode enum order");
+
+        // Forward lookup: one array load; out-of-range keys yield `invalid`
+        template <typename T>
+        constexpr T lookupKeycode(const std::array<T, kKeyCodeCount> &forward, KeyCode key, T invalid)
+        {
+            return static_cast<size_t>(key) < kKeyCodeCount ? forward[static_cast<size_t>(key)] : invalid;
+        }
+
+        // Reverse map from a platform code to KeyCode. The bucket is the code's
+        // low bits; construction proves at compile time that no two codes share one,
+        // so a lookup is a mask, a load and a compare.
+        template <typename T, size_t Buckets>
+        struct ReverseKeyMap
+        {
+            static_assert((Buckets & (Buckets - 1)) == 0, "bucket count must be a power of two");
+
+            std::array<T, Buckets> codes{};
+            std::array<uint8_t, Buckets> keys{}; // KeyCode + 1, 0 marks an empty bucket
+            bool collisionFree = true;
+
+            constexpr bool lookup(T code, KeyCode &out) const
+            {
+                const size_t bucket = static_cast<size_t>(code) & (Buckets - 1);
+                if (keys[bucket] == 0 || codes[bucket] != code)
+                    return false;
+                out = static_cast<KeyCode>(keys[bucket] - 1);
+                return true;
+            }
+        };
+
+        template <size_t Buckets, typename T>
+        constexpr ReverseKeyMap<T, Buckets> makeReverseKeyMap(const std::array<T, kKeyCodeCount> &forward, T invalid)
+        {
+            ReverseKeyMap<T, Buckets> map{};
+            for (size_t i = 0; i < kKeyCodeCount; ++i)
+            {
+                if (forward[i] == invalid)
+                    continue;
+                const size_t bucket = static_cast<size_t>(forward[i]) & (Buckets - 1);
+                if (map.keys[bucket] != 0)
+                    map.collisionFree = false;
+                map.codes[bucket] = forward[i];
+                map.keys[bucket] = static_cast<uint8_t>(i + 1);
+            }
+            return map;
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
@@ -0,0 +1,348 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include "../../core/stats.h"
+#include "daemon_protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace CrossInput
+{
+    namespace DaemonImpl
+    {
+        namespace
+        {
+            using Internal::DaemonCommand;
+            using Internal::DaemonOp;
+            using Internal::DaemonRing;
+
+            // How long a producer waits for room in a full ring before it
+            // decides the daemon is gone
+            constexpr auto kFullRingTimeout = std::chrono::seconds(1);
+
+            // This process's connection, shared by every thread. The mutex makes
+            // the callers a single producer; uncontended it costs a few tens of
+            // nanoseconds.
+            struct Connection
+            {
+                std::mutex mutex;
+                int socket = -1;
+                int wakeFd = -1;
+                DaemonRing *ring = nullptr;
+                uint32_t mask = 0;
+                uint64_t cachedTail = 0; // producer's view of ring->tail
+                bool lost = false;
+
+                // Serializes Sync callers, which read acks off the socket after
+                // releasing the mutex. Connect takes it too, so the socket a
+                // Sync waits on is never closed or reused underneath it.
+                // Lock order: syncMutex, then mutex.
+                std::mutex syncMutex;
+                int32_t nextSequence = 0;
+
+                // Call with the mutex held
+                void close()
+                {
+                    if (ring)
+                        munmap(ring, DaemonRing::bytesFor(mask + 1));
+                    if (wakeFd >= 0)
+                        ::close(wakeFd);
+                    if (socket >= 0)
+                        ::close(socket);
+                    ring = nullptr;
+                    wakeFd = socket = -1;
+                    mask = 0;
+                    cachedTail = 0;
+                    lost = false;
+                }
+
+                // Call with the mutex held
+                void wake()
+                {
+                    uint64_t one = 1;
+                    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+                    (void)ignored;
+                }
+
+                // Call with the mutex held. Whether the daemon closed its end.
+                bool daemonGone(int timeoutMs)
+                {
+                    pollfd pfd = {socket, POLLIN, 0};
+                    return poll(&pfd, 1, timeoutMs) > 0 && (pfd.revents & (POLLHUP | POLLERR));
+                }
+
+                // Call with the mutex held
+                void markLost()
+                {
+                    if (!lost)
+                        fprintf(stderr, "CrossInput: Injector daemon stopped responding\n");
+                    lost = true;
+                }
+
+                // Call with the mutex held. Returns false, dropping the
+                // command, when not connected or the daemon is gone.
+                bool push(const DaemonCommand &command)
+                {
+                    if (!ring || lost)
+                        return false;
+
+                    uint64_t head = ring->head.load(std::memory_order_relaxed);
+                    if (head - cachedTail > mask)
+                    {
+                        cachedTail = ring->tail.load(std::memory_order_acquire);
+                        auto deadline = std::chrono::steady_clock::now() + kFullRingTimeout;
+                        while (head - cachedTail > mask)
+                        {
+                            wake();
+                            if (daemonGone(1) || std::chrono::steady_clock::now() >= deadline)
+                            {
+                                markLost();
+                                return false;
+                            }
+                            cachedTail = ring->tail.load(std::memory_order_acquire);
+                        }
+                    }
+
+                    ring->slots()[head & mask] = command;
+                    ring->head.store(head + 1, std::memory_order_release);
+
+                    // Pairs with the daemon's fence between raising
+                    // consumerWaiting and its last look at head
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (ring->consumerWaiting.load(std::memory_order_relaxed))
+                        wake();
+                    return true;
+                }
+            };
+
+            Connection &connection()
+            {
+                static Connection instance;
+                return instance;
+            }
+
+            void send(const DaemonCommand &command)
+            {
+                Connection &c = connection();
+                std::lock_guard<std::mutex> lock(c.mutex);
+                if (!c.push(command))
+                    Internal::markStatFailure();
+            }
+
+            DaemonCommand command(DaemonOp op, int32_t a, int32_t b = 0)
+            {
+                DaemonCommand result = {};
+                result.op = op;
+                result.a = a;
+                result.b = b;
+                return result;
+            }
+
+            int connectSocket(const std::string &path)
+            {
+                sockaddr_un addr = {};
+                addr.sun_family = AF_UNIX;
+                if (path.empty() || path.size() >= sizeof(addr.sun_path))
+                    return -1;
+                std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+                int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+                if (fd < 0)
+                    return -1;
+                if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+                {
+                    ::close(fd);
+                    return -1;
+                }
+                return fd;
+            }
+        } // namespace
+
+        bool Connect(const std::string &socketPath)
+        {
+            Connection &c = connection();
+            std::lock_guard<std::mutex> syncLock(c.syncMutex);
+            std::lock_guard<std::mutex> lock(c.mutex);
+            c.close();
+
+            if (Internal::inFallbackDirectory(socketPath) && !Internal::isPrivateDirectory(Internal::fallbackDaemonDirectory()))
+            {
+                fprintf(stderr, "CrossInput: %s is not a private directory\n", Internal::fallbackDaemonDirectory().c_str());
+                return false;
+            }
+
+            c.socket = connectSocket(socketPath);
+            if (c.socket < 0)
+            {
+                fprintf(stderr, "CrossInput: No injector daemon at %s\n", socketPath.c_str());
+                return false;
+            }
+
+            // Everything typed from here on goes to this process; never hand
+            // it to a listener another user put at the path
+            if (!Internal::peerIsSameUser(c.socket))
+            {
+                fprintf(stderr, "CrossInput: Injector daemon at %s belongs to another user\n", socketPath.c_str());
+                c.close();
+                return false;
+            }
+
+            size_t bytes = DaemonRing::bytesFor(Internal::kDaemonRingCapacity);
+            int memFd = memfd_create("crossinput-ring", MFD_CLOEXEC);
+            void *memory = MAP_FAILED;
+            if (memFd >= 0 && ftruncate(memFd, static_cast<off_t>(bytes)) == 0)
+                memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+            c.wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+            bool sent = false;
+            if (memory != MAP_FAILED && c.wakeFd >= 0)
+            {
+                c.ring = new (memory) DaemonRing();
+                c.ring->capacity = Internal::kDaemonRingCapacity;
+                c.mask = Internal::kDaemonRingCapacity - 1;
+                int fds[2] = {memFd, c.wakeFd};
+                sent = Internal::sendFds(c.socket, fds, 2, Internal::kDaemonProtocolVersion);
+            }
+            else if (memory != MAP_FAILED)
+            {
+                munmap(memory, bytes);
+            }
+            if (memFd >= 0)
+                ::close(memFd);
+
+            // The daemon answers 1 once it has mapped the ring
+            uint8_t reply = 0;
+            pollfd pfd = {c.socket, POLLIN, 0};
+            if (!sent || poll(&pfd, 1, 1000) <= 0 || recv(c.socket, &reply, 1, 0) != 1 || reply != 1)
+            {
+                fprintf(stderr, "CrossInput: Injector daemon at %s refused the connection\n", socketPath.c_str());
+                c.close();
+                return false;
+            }
+            return true;
+        }
+
+        void KeyDown(KeyCode key)
+        {
+            send(command(DaemonOp::KeyDown, static_cast<int32_t>(key)));
+        }
+
+        void KeyUp(KeyCode key)
+        {
+            send(command(DaemonOp::KeyUp, static_cast<int32_t>(key)));
+        }
+
+        void TypeText(std::string_view text)
+        {
+            Connection &c = connection();
+            std::lock_guard<std::mutex> lock(c.mutex);
+
+            // One lock for every chunk keeps other threads from splicing in
+            while (!text.empty())
+            {
+                // The daemon buffers at most kDaemonMaxText per call, so longer
+                // text goes as several calls, split between code points
+                size_t piece = text.size();
+                if (piece > Internal::kDaemonMaxText)
+                {
+                    piece = Internal::kDaemonMaxText;
+                    while (piece > 0 && (static_cast<unsigned char>(text[piece]) & 0xC0) == 0x80)
+                        --piece;
+                    if (piece == 0)
+                        piece = Internal::kDaemonMaxText;
+                }
+
+                // The daemon joins the chunks of a piece before typing, so they may split a code point
+                for (size_t sent = 0; sent < piece;)
+                {
+                    size_t length = std::min(piece - sent, Internal::kDaemonTextChunk);
+                    DaemonCommand chunk = command(DaemonOp::Text, 0);
+                    chunk.length = static_cast<uint16_t>(length);
+                    chunk.flags = sent + length < piece ? Internal::kDaemonMoreText : 0;
+                    std::memcpy(chunk.text, text.data() + sent, length);
+                    if (!c.push(chunk))
+                    {
+                        Internal::markStatFailure();
+                        return;
+                    }
+                    sent += length;
+                }
+                text.remove_prefix(piece);
+            }
+        }
+
+        void MouseButtonDown(MouseButton button)
+        {
+            send(command(DaemonOp::ButtonDown, static_cast<int32_t>(button)));
+        }
+
+        void MouseButtonUp(MouseButton button)
+        {
+            send(command(DaemonOp::ButtonUp, static_cast<int32_t>(button)));
+        }
+
+        void SetCursorPosition(const Point &pos)
+        {
+            send(command(DaemonOp::MoveTo, pos.x, pos.y));
+        }
+
+        void MoveCursor(int dx, int dy)
+        {
+            send(command(DaemonOp::MoveBy, dx, dy));
+        }
+
+        bool Sync(int timeoutMs)
+        {
+            Connection &c = connection();
+            std::lock_guard<std::mutex> syncLock(c.syncMutex);
+
+            int32_t sequence;
+            int socket;
+            {
+                std::lock_guard<std::mutex> lock(c.mutex);
+                sequence = ++c.nextSequence;
+                if (!c.push(command(DaemonOp::Sync, sequence)))
+                    return false;
+                socket = c.socket;
+            }
+
+            // Acks for earlier Syncs that timed out may still be queued ahead of ours
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            for (;;)
+            {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                pollfd pfd = {socket, POLLIN, 0};
+                if (remaining.count() < 0 || poll(&pfd, 1, static_cast<int>(remaining.count())) <= 0)
+                    return false;
+
+                Internal::DaemonAck ack = {};
+                if (recv(socket, &ack, sizeof(ack), 0) != static_cast<ssize_t>(sizeof(ack)))
+                    return false;
+                if (ack.sequence == sequence)
+                    return ack.ok != 0;
+            }
+        }
+    } // namespace DaemonImpl
+
+    std::string DefaultDaemonSocket()
+    {
+        const char *runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+        if (runtimeDir && *runtimeDir)
+            return std::string(runtimeDir) + "/crossinputd.sock";
+        return Internal::fallbackDaemonDirectory() + "/crossinputd.sock";
+    }
+
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
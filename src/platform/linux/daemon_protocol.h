@@ -0,0 +1,182 @@
+#pragma once
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Wire format between ConnectDaemon clients and InjectorDaemon.
+        //
+        // A client creates a memfd holding a DaemonRing plus an eventfd and
+        // passes both over the daemon's SOCK_SEQPACKET socket. From then on it
+        // only writes commands into the ring, and the daemon only reads them.
+        // The daemon raises `consumerWaiting` before it sleeps, and a client
+        // writes the eventfd only when it sees the flag. While the daemon is
+        // busy, a call costs the client no syscall. The socket stays open. It
+        // carries Sync acknowledgements and tells each side when the other exits.
+
+        constexpr uint8_t kDaemonProtocolVersion = 1;
+        constexpr uint32_t kDaemonRingCapacity = 4096;
+        // Largest ring a daemon maps, so a client cannot make it map gigabytes
+        constexpr uint32_t kDaemonMaxRingCapacity = 1u << 20;
+        constexpr size_t kDaemonTextChunk = 20;
+        // Longest text the daemon buffers for one TypeText; clients split longer text
+        constexpr size_t kDaemonMaxText = 1 << 20;
+
+        enum class DaemonOp : uint8_t
+        {
+            KeyDown,    // a = KeyCode
+            KeyUp,      // a = KeyCode
+            ButtonDown, // a = MouseButton
+            ButtonUp,   // a = MouseButton
+            MoveTo,     // a, b = position
+            MoveBy,     // a, b = delta
+            Text,       // `length` bytes of UTF-8 in `text`, continued while kDaemonMoreText is set
+            Sync,       // the daemon answers with a DaemonAck for sequence `a`
+        };
+
+        constexpr uint8_t kDaemonMoreText = 1;
+
+        struct DaemonCommand
+        {
+            DaemonOp op;
+            uint8_t flags;
+            uint16_t length;
+            int32_t a;
+            int32_t b;
+            char text[kDaemonTextChunk];
+        };
+        static_assert(sizeof(DaemonCommand) == 32, "commands are packed two to a cache line");
+
+        // Header of the shared ring; `capacity` slots follow it
+        struct DaemonRing
+        {
+            uint32_t capacity; // a power of two
+            alignas(64) std::atomic<uint64_t> head{0};            // written by the client
+            alignas(64) std::atomic<uint64_t> tail{0};            // written by the daemon
+            alignas(64) std::atomic<uint32_t> consumerWaiting{0}; // written by the daemon
+
+            DaemonCommand *slots() { return reinterpret_cast<DaemonCommand *>(this + 1); }
+
+            static size_t bytesFor(uint32_t capacity)
+            {
+                return sizeof(DaemonRing) + static_cast<size_t>(capacity) * sizeof(DaemonCommand);
+            }
+        };
+        static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                      "ring indices are shared between processes");
+
+        // Sent by the daemon on the socket once a Sync command has been handled
+        struct DaemonAck
+        {
+            int32_t sequence;
+            uint8_t ok;
+        };
+
+        // Whether the process at the other end of `socket` runs as this user.
+        // Both sides check: the daemon so it only injects for its owner, and a
+        // client so it never hands keystrokes to another user's listener.
+        inline bool peerIsSameUser(int socket)
+        {
+            ucred cred = {};
+            socklen_t length = sizeof(cred);
+            return getsockopt(socket, SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0 && cred.uid == getuid();
+        }
+
+        // Holds the default socket when XDG_RUNTIME_DIR is unset. /tmp is shared,
+        // so the daemon creates it 0700 and both sides refuse it unless it is
+        // still a private directory of this user.
+        inline std::string fallbackDaemonDirectory()
+        {
+            return "/tmp/crossinputd-" + std::to_string(getuid());
+        }
+
+        inline bool inFallbackDirectory(const std::string &path)
+        {
+            const std::string directory = fallbackDaemonDirectory() + "/";
+            return path.compare(0, directory.size(), directory) == 0;
+        }
+
+        // A real directory (not a symlink) owned by this user and closed to everyone else
+        inline bool isPrivateDirectory(const std::string &directory)
+        {
+            struct stat info = {};
+            return lstat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == getuid() &&
+                   (info.st_mode & 077) == 0;
+        }
+
+        // Sends `count` file descriptors with a one-byte message
+        inline bool sendFds(int socket, const int *fds, size_t count, uint8_t byte)
+        {
+            char control[CMSG_SPACE(sizeof(int) * 2)] = {};
+            if (count > 2)
+                return false;
+
+            iovec iov = {&byte, 1};
+            msghdr msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+            std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+            return sendmsg(socket, &msg, MSG_NOSIGNAL) == 1;
+        }
+
+        // Receives a one-byte message and up to two file descriptors. Returns
+        // how many descriptors arrived, or -1 if the peer hung up or failed.
+        inline int receiveFds(int socket, int *fds, uint8_t &byte)
+        {
+            char control[CMSG_SPACE(sizeof(int) * 2)] = {};
+            iovec iov = {&byte, 1};
+            msghdr msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            if (recvmsg(socket, &msg, MSG_CMSG_CLOEXEC) != 1)
+                return -1;
+
+            int received = 0;
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                    continue;
+                int n = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+                if (received + n > 2)
+                    n = 2 - received;
+                std::memcpy(fds + received, CMSG_DATA(cmsg), sizeof(int) * n);
+                received += n;
+            }
+            return received;
+        }
+
+        // Implemented in linux_input.cpp. The daemon opens its backend once, then
+        // binds it to its own thread. That thread then never follows the
+        // process-wide SetBackend choice, which in a test may be Backend::Daemon
+        // itself.
+        bool openBackend(Backend backend);
+        void setThreadBackend(Backend backend);
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
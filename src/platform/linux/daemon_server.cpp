@@ -0,0 +1,434 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include "../../core/daemon_server.h"
+#include "../keycode_table.h"
+#include "daemon_protocol.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+        namespace
+        {
+            // Everything here is touched only by the daemon thread. The ring is
+            // written by the client concurrently and is never trusted: each
+            // command is copied out before it is checked.
+            struct DaemonClient
+            {
+                int socket = -1;
+                int wakeFd = -1;
+                DaemonRing *ring = nullptr;
+                size_t mappedBytes = 0;
+                uint64_t mask = 0;
+                uint64_t tail = 0;
+                std::string text;
+
+                ~DaemonClient()
+                {
+                    if (ring)
+                        munmap(ring, mappedBytes);
+                    if (wakeFd >= 0)
+                        close(wakeFd);
+                    if (socket >= 0)
+                        close(socket);
+                }
+            };
+
+            class LinuxDaemonServer : public DaemonServer
+            {
+            public:
+                static std::unique_ptr<DaemonServer> start(const std::string &path, Backend backend)
+                {
+                    sockaddr_un addr = {};
+                    addr.sun_family = AF_UNIX;
+                    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+                    {
+                        fprintf(stderr, "CrossInput: Invalid injector daemon socket path\n");
+                        return nullptr;
+                    }
+                    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+                    if (!openBackend(backend))
+                    {
+                        fprintf(stderr, "CrossInput: Injector daemon backend is unavailable\n");
+                        return nullptr;
+                    }
+
+                    std::unique_ptr<LinuxDaemonServer> server(new LinuxDaemonServer(path, backend));
+                    if (server->epoll_fd_ < 0 || server->stop_fd_ < 0 || server->listen_fd_ < 0)
+                        return nullptr;
+
+                    // A socket file that still accepts connections belongs to a live daemon
+                    int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+                    bool taken = probe >= 0 && connect(probe, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+                    if (probe >= 0)
+                        close(probe);
+                    if (taken)
+                    {
+                        fprintf(stderr, "CrossInput: An injector daemon already listens on %s\n", path.c_str());
+                        return nullptr;
+                    }
+
+                    if (inFallbackDirectory(path))
+                    {
+                        mkdir(fallbackDaemonDirectory().c_str(), 0700);
+                        if (!isPrivateDirectory(fallbackDaemonDirectory()))
+                        {
+                            fprintf(stderr, "CrossInput: %s is not a private directory\n", fallbackDaemonDirectory().c_str());
+                            return nullptr;
+                        }
+                    }
+
+                    // Only a stale socket is replaced; any other file at the path is left alone
+                    struct stat info = {};
+                    if (lstat(path.c_str(), &info) == 0)
+                    {
+                        if (!S_ISSOCK(info.st_mode))
+                        {
+                            fprintf(stderr, "CrossInput: %s exists and is not a socket\n", path.c_str());
+                            return nullptr;
+                        }
+                        unlink(path.c_str());
+                    }
+                    if (bind(server->listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+                        chmod(path.c_str(), 0600) != 0 || listen(server->listen_fd_, 16) != 0)
+                    {
+                        fprintf(stderr, "CrossInput: Cannot listen on %s\n", path.c_str());
+                        return nullptr;
+                    }
+                    server->bound_ = true;
+
+                    server->watch(server->listen_fd_, nullptr);
+                    server->watch(server->stop_fd_, server.get());
+                    server->thread_ = std::thread([raw = server.get()]
+                                                  { raw->run(); });
+                    return server;
+                }
+
+                ~LinuxDaemonServer() override
+                {
+                    if (thread_.joinable())
+                    {
+                        uint64_t one = 1;
+                        ssize_t ignored = write(stop_fd_, &one, sizeof(one));
+                        (void)ignored;
+                        thread_.join();
+                    }
+                    clients_.clear();
+                    if (bound_)
+                        unlink(path_.c_str());
+                    if (listen_fd_ >= 0)
+                        close(listen_fd_);
+                    if (stop_fd_ >= 0)
+                        close(stop_fd_);
+                    if (epoll_fd_ >= 0)
+                        close(epoll_fd_);
+                }
+
+                size_t clientCount() const override { return client_count_.load(std::memory_order_relaxed); }
+
+            private:
+                LinuxDaemonServer(const std::string &path, Backend backend)
+                    : path_(path), backend_(backend), epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+                      stop_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+                      listen_fd_(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0))
+                {
+                }
+
+                // `tag` is the client the fd belongs to, nullptr for the
+                // listening socket and `this` for the stop eventfd
+                void watch(int fd, void *tag)
+                {
+                    epoll_event event = {};
+                    event.events = EPOLLIN;
+                    event.data.ptr = tag;
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+                }
+
+                void run()
+                {
+                    setThreadBackend(backend_);
+
+                    epoll_event events[16];
+                    for (;;)
+                    {
+                        drainAll();
+
+                        // Announce the sleep, then look at every ring once more;
+                        // a client that pushed after our drain either sees the
+                        // flag and writes its eventfd, or is seen here
+                        for (auto &client : clients_)
+                        {
+                            if (client->ring)
+                                client->ring->consumerWaiting.store(1, std::memory_order_relaxed);
+                        }
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        bool pending = false;
+                        for (auto &client : clients_)
+                        {
+                            if (client->ring && client->ring->head.load(std::memory_order_relaxed) != client->tail)
+                                pending = true;
+                        }
+
+                        int count = epoll_wait(epoll_fd_, events, 16, pending ? 0 : -1);
+                        for (auto &client : clients_)
+                        {
+                            if (client->ring)
+                                client->ring->consumerWaiting.store(0, std::memory_order_relaxed);
+                        }
+
+                        for (int i = 0; i < count; ++i)
+                        {
+                            void *tag = events[i].data.ptr;
+                            if (tag == this)
+                                return;
+                            if (tag == nullptr)
+                                accept();
+                            else
+                                service(static_cast<DaemonClient *>(tag), events[i].events);
+                        }
+                        removeDropped();
+                    }
+                }
+
+                void accept()
+                {
+                    int fd;
+                    while ((fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0)
+                    {
+                        if (!peerIsSameUser(fd))
+                        {
+                            close(fd);
+                            continue;
+                        }
+                        std::unique_ptr<DaemonClient> client(new DaemonClient());
+                        client->socket = fd;
+                        watch(fd, client.get());
+                        clients_.push_back(std::move(client));
+                    }
+                }
+
+                // Handles readiness on a client's socket or eventfd
+                void service(DaemonClient *client, uint32_t readiness)
+                {
+                    if (!client->ring)
+                    {
+                        if (!handshake(client))
+                            drop(client);
+                        return;
+                    }
+
+                    if (readiness & (EPOLLHUP | EPOLLERR))
+                    {
+                        // Run what the client queued before exiting
+                        drain(client);
+                        drop(client);
+                        return;
+                    }
+
+                    // The eventfd only wakes us; the ring is drained on the next pass
+                    uint64_t value;
+                    ssize_t ignored = read(client->wakeFd, &value, sizeof(value));
+                    (void)ignored;
+                }
+
+                // Maps the ring a new client sent with its first message
+                bool handshake(DaemonClient *client)
+                {
+                    int fds[2] = {-1, -1};
+                    uint8_t version = 0;
+                    int received = receiveFds(client->socket, fds, version);
+                    int memFd = received > 0 ? fds[0] : -1;
+                    client->wakeFd = received > 1 ? fds[1] : -1;
+
+                    bool ok = received == 2 && version == kDaemonProtocolVersion && mapRing(client, memFd);
+                    if (memFd >= 0)
+                        close(memFd);
+                    if (!ok)
+                        return false;
+
+                    watch(client->wakeFd, client);
+                    client_count_.fetch_add(1, std::memory_order_relaxed);
+                    uint8_t accepted = 1;
+                    return ::send(client->socket, &accepted, 1, MSG_NOSIGNAL) == 1;
+                }
+
+                bool mapRing(DaemonClient *client, int memFd)
+                {
+                    struct stat st = {};
+                    if (fstat(memFd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(DaemonRing))
+                        return false;
+
+                    void *header = mmap(nullptr, sizeof(DaemonRing), PROT_READ, MAP_SHARED, memFd, 0);
+                    if (header == MAP_FAILED)
+                        return false;
+                    uint32_t capacity = static_cast<DaemonRing *>(header)->capacity;
+                    munmap(header, sizeof(DaemonRing));
+
+                    bool powerOfTwo = capacity != 0 && (capacity & (capacity - 1)) == 0;
+                    if (!powerOfTwo || capacity > kDaemonMaxRingCapacity ||
+                        static_cast<size_t>(st.st_size) < DaemonRing::bytesFor(capacity))
+                        return false;
+
+                    // The client may change `capacity` later; keep the value checked here
+                    size_t bytes = DaemonRing::bytesFor(capacity);
+                    void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+                    if (memory == MAP_FAILED)
+                        return false;
+                    client->ring = static_cast<DaemonRing *>(memory);
+                    client->mappedBytes = bytes;
+                    client->mask = capacity - 1;
+                    client->tail = client->ring->tail.load(std::memory_order_relaxed);
+                    return true;
+                }
+
+                void drainAll()
+                {
+                    for (auto &client : clients_)
+                    {
+                        if (client->ring && client->socket >= 0)
+                            drain(client.get());
+                    }
+                    removeDropped();
+                }
+
+                void drain(DaemonClient *client)
+                {
+                    uint64_t head = client->ring->head.load(std::memory_order_acquire);
+                    if (head - client->tail > client->mask + 1)
+                    {
+                        drop(client); // a head no producer could have written
+                        return;
+                    }
+
+                    while (client->tail != head)
+                    {
+                        DaemonCommand command = client->ring->slots()[client->tail & client->mask];
+                        ++client->tail;
+                        if (!execute(client, command))
+                        {
+                            drop(client);
+                            return;
+                        }
+                    }
+                    client->ring->tail.store(client->tail, std::memory_order_release);
+                }
+
+                // Returns false if the command is malformed
+                bool execute(DaemonClient *client, const DaemonCommand &command)
+                {
+                    switch (command.op)
+                    {
+                    case DaemonOp::KeyDown:
+                    case DaemonOp::KeyUp:
+                    {
+                        if (command.a < 0 || static_cast<size_t>(command.a) >= kKeyCodeCount)
+                            return false;
+                        KeyCode key = static_cast<KeyCode>(command.a);
+                        if (command.op == DaemonOp::KeyDown)
+                            KeyDown(key);
+                        else
+                            KeyUp(key);
+                        return true;
+                    }
+                    case DaemonOp::ButtonDown:
+                    case DaemonOp::ButtonUp:
+                    {
+                        if (command.a < 0 || command.a > static_cast<int32_t>(MouseButton::Middle))
+                            return false;
+                        MouseButton button = static_cast<MouseButton>(command.a);
+                        if (command.op == DaemonOp::ButtonDown)
+                            MouseButtonDown(button);
+                        else
+                            MouseButtonUp(button);
+                        return true;
+                    }
+                    case DaemonOp::MoveTo:
+                        SetCursorPosition(Point{command.a, command.b});
+                        return true;
+                    case DaemonOp::MoveBy:
+                        MoveCursor(command.a, command.b);
+                        return true;
+                    case DaemonOp::Text:
+                        if (command.length > kDaemonTextChunk || client->text.size() + command.length > kDaemonMaxText)
+                            return false;
+                        client->text.append(command.text, command.length);
+                        if (!(command.flags & kDaemonMoreText))
+                        {
+                            TypeText(client->text);
+                            client->text.clear();
+                        }
+                        return true;
+                    case DaemonOp::Sync:
+                    {
+                        DaemonAck ack = {command.a, static_cast<uint8_t>(Sync() ? 1 : 0)};
+                        ssize_t ignored = ::send(client->socket, &ack, sizeof(ack), MSG_NOSIGNAL | MSG_DONTWAIT);
+                        (void)ignored;
+                        return true;
+                    }
+                    }
+                    return false;
+                }
+
+                // Closes the connection now; the entry is removed after the
+                // current batch of epoll events, which may still point at it
+                void drop(DaemonClient *client)
+                {
+                    if (client->socket < 0)
+                        return;
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client->socket, nullptr);
+                    if (client->wakeFd >= 0)
+                        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client->wakeFd, nullptr);
+                    close(client->socket);
+                    client->socket = -1;
+                }
+
+                void removeDropped()
+                {
+                    size_t kept = 0, connected = 0;
+                    for (size_t i = 0; i < clients_.size(); ++i)
+                    {
+                        if (clients_[i]->socket < 0)
+                            continue;
+                        connected += clients_[i]->ring != nullptr;
+                        clients_[kept++] = std::move(clients_[i]);
+                    }
+                    clients_.resize(kept);
+                    client_count_.store(connected, std::memory_order_relaxed);
+                }
+
+                std::string path_;
+                Backend backend_;
+                int epoll_fd_;
+                int stop_fd_;
+                int listen_fd_;
+                bool bound_ = false;
+                std::thread thread_;
+                std::vector<std::unique_ptr<DaemonClient>> clients_;
+                std::atomic<size_t> client_count_{0}; // clients past the handshake
+            };
+        } // namespace
+
+        std::unique_ptr<DaemonServer> startDaemonServer(const std::string &socketPath, Backend backend)
+        {
+            return LinuxDaemonServer::start(socketPath, backend);
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
@@ -0,0 +1,373 @@
+#pragma once
+
+#ifdef CROSSINPUT_LINUX
+
+// With `make DLOPEN=1` the library links none of libX11, libXtst, libXi,
+// libei, gio or xkbcommon. Each is dlopen()ed the first time a backend needs
+// it, and the calls below are redirected through the resolved pointers, so a
+// host missing one of them loses that backend instead of failing to start.
+// Without CROSSINPUT_DLOPEN the *Available() checks are constant true.
+//
+// This header pulls in every library header it redirects before defining the
+// macros, so it is safe to include anywhere after them.
+
+#ifdef CROSSINPUT_DLOPEN
+#include <cstdio>
+#include <dlfcn.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+#ifdef CROSSINPUT_HAS_XI2
+#include <X11/extensions/XInput2.h>
+#endif
+#ifdef CROSSINPUT_HAS_LIBEI
+#include <libei.h>
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+#endif
+#ifdef CROSSINPUT_HAS_XKBCOMMON
+#include <xkbcommon/xkbcommon.h>
+#endif
+#endif // CROSSINPUT_DLOPEN
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+#ifdef CROSSINPUT_DLOPEN
+
+#define CROSSINPUT_X11_SYMBOLS(X)  \
+    X(XChangeKeyboardMapping)      \
+    X(XChangeProperty)             \
+    X(XCloseDisplay)               \
+    X(XConvertCase)                \
+    X(XConvertSelection)           \
+    X(XCreateSimpleWindow)         \
+    X(XDeleteProperty)             \
+    X(XDestroyWindow)              \
+    X(XDisplayKeycodes)            \
+    X(XExtendedMaxRequestSize)     \
+    X(XFlush)                      \
+    X(XFree)                       \
+    X(XFreeEventData)              \
+    X(XGetEventData)               \
+    X(XGetInputFocus)              \
+    X(XGetKeyboardMapping)         \
+    X(XGetSelectionOwner)          \
+    X(XGetWindowProperty)          \
+    X(XInternAtom)                 \
+    X(XKeysymToKeycode)            \
+    X(XMaxRequestSize)             \
+    X(XNextEvent)                  \
+    X(XOpenDisplay)                \
+    X(XPending)                    \
+    X(XQueryExtension)             \
+    X(XQueryKeymap)                \
+    X(XQueryPointer)               \
+    X(XQueryTree)                  \
+    X(XRefreshKeyboardMapping)     \
+    X(XSelectInput)                \
+    X(XSendEvent)                  \
+    X(XSetErrorHandler)            \
+    X(XSetSelectionOwner)          \
+    X(XSync)                       \
+    X(XWarpPointer)
+
+#define CROSSINPUT_XTST_SYMBOLS(X) \
+    X(XTestFakeButtonEvent)        \
+    X(XTestFakeKeyEvent)
+
+#define CROSSINPUT_XI_SYMBOLS(X) \
+    X(XIQueryVersion)            \
+    X(XISelectEvents)
+
+#define CROSSINPUT_EI_SYMBOLS(X)          \
+    X(ei_configure_name)                  \
+    X(ei_device_button_button)            \
+    X(ei_device_frame)                    \
+    X(ei_device_get_region)               \
+    X(ei_device_has_capability)           \
+    X(ei_device_keyboard_get_keymap)      \
+    X(ei_device_keyboard_key)             \
+    X(ei_device_pointer_motion)           \
+    X(ei_device_pointer_motion_absolute)  \
+    X(ei_device_ref)                      \
+    X(ei_device_start_emulating)          \
+    X(ei_device_stop_emulating)           \
+    X(ei_device_unref)                    \
+    X(ei_dispatch)                        \
+    X(ei_event_get_device)                \
+    X(ei_event_get_seat)                  \
+    X(ei_event_get_type)                  \
+    X(ei_event_pong_get_ping)             \
+    X(ei_event_unref)                     \
+    X(ei_get_event)                       \
+    X(ei_get_fd)                          \
+    X(ei_keymap_get_fd)                   \
+    X(ei_keymap_get_size)                 \
+    X(ei_keymap_get_type)                 \
+    X(ei_keymap_ref)                      \
+    X(ei_keymap_unref)                    \
+    X(ei_new_ping)                        \
+    X(ei_new_sender)                      \
+    X(ei_now)                             \
+    X(ei_ping)                            \
+    X(ei_ping_unref)                      \
+    X(ei_region_get_height)               \
+    X(ei_region_get_width)                \
+    X(ei_region_get_x)                    \
+    X(ei_region_get_y)                    \
+    X(ei_seat_bind_capabilities)          \
+    X(ei_seat_ref)                        \
+    X(ei_seat_unref)                      \
+    X(ei_setup_backend_fd)                \
+    X(ei_unref)
+
+// libgio-2.0 pulls in glib and gobject, and dlsym searches its dependencies
+#define CROSSINPUT_GIO_SYMBOLS(X)                      \
+    X(g_bus_get_sync)                                  \
+    X(g_dbus_connection_call_sync)                     \
+    X(g_dbus_connection_call_with_unix_fd_list_sync)   \
+    X(g_dbus_connection_get_unique_name)               \
+    X(g_dbus_connection_signal_subscribe)              \
+    X(g_dbus_connection_signal_unsubscribe)            \
+    X(g_error_free)                                    \
+    X(g_free)                                          \
+    X(g_get_monotonic_time)                            \
+    X(g_main_context_default)                          \
+    X(g_main_context_iteration)                        \
+    X(g_object_unref)                                  \
+    X(g_strdup)                                        \
+    X(g_unix_fd_list_get)                              \
+    X(g_variant_builder_add)                           \
+    X(g_variant_builder_init)                          \
+    X(g_variant_get)                                   \
+    X(g_variant_new)                                   \
+    X(g_variant_new_string)                            \
+    X(g_variant_new_uint32)                            \
+    X(g_variant_type_checked_)                         \
+    X(g_variant_unref)
+
+#define CROSSINPUT_XKB_SYMBOLS(X)        \
+    X(xkb_context_new)                   \
+    X(xkb_context_unref)                 \
+    X(xkb_keymap_key_for_each)           \
+    X(xkb_keymap_key_get_mods_for_level) \
+    X(xkb_keymap_key_get_syms_by_level)  \
+    X(xkb_keymap_mod_get_index)          \
+    X(xkb_keymap_new_from_buffer)        \
+    X(xkb_keymap_num_levels_for_key)     \
+    X(xkb_keymap_unref)                  \
+    X(xkb_keysym_to_utf32)
+
+#define CROSSINPUT_DL_POINTER(name) decltype(&::name) name = nullptr;
+#define CROSSINPUT_DL_RESOLVE(name) ok = ok && resolveSymbol(handle, #name, loaded.name);
+
+        // Reports why a library is unusable once; the backend needing it then stays unavailable
+        inline void *openLibrary(const char *soname)
+        {
+            void *handle = dlopen(soname, RTLD_NOW | RTLD_LOCAL);
+            if (!handle)
+                fprintf(stderr, "CrossInput: %s\n", dlerror());
+            return handle;
+        }
+
+        template <typename Fn>
+        bool resolveSymbol(void *handle, const char *name, Fn &fn)
+        {
+            fn = reinterpret_cast<Fn>(dlsym(handle, name));
+            if (!fn)
+                fprintf(stderr, "CrossInput: %s\n", dlerror());
+            return fn != nullptr;
+        }
+
+// Declares `Type` holding the library's entry points and `accessor()`, which
+// loads it on first call and returns nullptr from then on if that failed
+#define CROSSINPUT_DL_LIBRARY(Type, accessor, soname, SYMBOLS)        \
+    struct Type                                                       \
+    {                                                                 \
+        SYMBOLS(CROSSINPUT_DL_POINTER)                                \
+    };                                                                \
+    inline const Type *accessor()                                     \
+    {                                                                 \
+        static const Type *api = []() -> const Type * {               \
+            static Type loaded;                                       \
+            void *handle = openLibrary(soname);                       \
+            bool ok = handle != nullptr;                              \
+            SYMBOLS(CROSSINPUT_DL_RESOLVE)                            \
+            return ok ? &loaded : nullptr;                            \
+        }();                                                          \
+        return api;                                                   \
+    }
+
+        CROSSINPUT_DL_LIBRARY(X11Api, x11Api, "libX11.so.6", CROSSINPUT_X11_SYMBOLS)
+        CROSSINPUT_DL_LIBRARY(XtstApi, xtstApi, "libXtst.so.6", CROSSINPUT_XTST_SYMBOLS)
+
+        inline bool x11Available() { return x11Api() && xtstApi(); }
+
+#ifdef CROSSINPUT_HAS_XI2
+        CROSSINPUT_DL_LIBRARY(XiApi, xiApi, "libXi.so.6", CROSSINPUT_XI_SYMBOLS)
+
+        inline bool xi2Available() { return x11Api() && xiApi(); }
+#endif
+
+#ifdef CROSSINPUT_HAS_LIBEI
+        CROSSINPUT_DL_LIBRARY(EiApi, eiApi, "libei.so.1", CROSSINPUT_EI_SYMBOLS)
+        CROSSINPUT_DL_LIBRARY(GioApi, gioApi, "libgio-2.0.so.0", CROSSINPUT_GIO_SYMBOLS)
+
+        inline bool libeiAvailable() { return eiApi() && gioApi(); }
+#endif
+
+#ifdef CROSSINPUT_HAS_XKBCOMMON
+        CROSSINPUT_DL_LIBRARY(XkbApi, xkbApi, "libxkbcommon.so.0", CROSSINPUT_XKB_SYMBOLS)
+
+        inline bool xkbcommonAvailable() { return xkbApi() != nullptr; }
+#endif
+
+#else
+
+        inline bool x11Available() { return true; }
+        inline bool xi2Available() { return true; }
+        inline bool libeiAvailable() { return true; }
+        inline bool xkbcommonAvailable() { return true; }
+
+#endif // CROSSINPUT_DLOPEN
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#ifdef CROSSINPUT_DLOPEN
+
+// Function-like, so `struct ei_ping` and other same-named tags are untouched.
+// Only call after the matching *Available() check has succeeded.
+#define CROSSINPUT_DL_CALL(accessor, name) (::CrossInput::Internal::accessor()->name)
+
+#define XChangeKeyboardMapping(...) CROSSINPUT_DL_CALL(x11Api, XChangeKeyboardMapping)(__VA_ARGS__)
+#define XChangeProperty(...) CROSSINPUT_DL_CALL(x11Api, XChangeProperty)(__VA_ARGS__)
+#define XCloseDisplay(...) CROSSINPUT_DL_CALL(x11Api, XCloseDisplay)(__VA_ARGS__)
+#define XConvertCase(...) CROSSINPUT_DL_CALL(x11Api, XConvertCase)(__VA_ARGS__)
+#define XConvertSelection(...) CROSSINPUT_DL_CALL(x11Api, XConvertSelection)(__VA_ARGS__)
+#define XCreateSimpleWindow(...) CROSSINPUT_DL_CALL(x11Api, XCreateSimpleWindow)(__VA_ARGS__)
+#define XDeleteProperty(...) CROSSINPUT_DL_CALL(x11Api, XDeleteProperty)(__VA_ARGS__)
+#define XDestroyWindow(...) CROSSINPUT_DL_CALL(x11Api, XDestroyWindow)(__VA_ARGS__)
+#define XDisplayKeycodes(...) CROSSINPUT_DL_CALL(x11Api, XDisplayKeycodes)(__VA_ARGS__)
+#define XExtendedMaxRequestSize(...) CROSSINPUT_DL_CALL(x11Api, XExtendedMaxRequestSize)(__VA_ARGS__)
+#define XFlush(...) CROSSINPUT_DL_CALL(x11Api, XFlush)(__VA_ARGS__)
+#define XFree(...) CROSSINPUT_DL_CALL(x11Api, XFree)(__VA_ARGS__)
+#define XFreeEventData(...) CROSSINPUT_DL_CALL(x11Api, XFreeEventData)(__VA_ARGS__)
+#define XGetEventData(...) CROSSINPUT_DL_CALL(x11Api, XGetEventData)(__VA_ARGS__)
+#define XGetInputFocus(...) CROSSINPUT_DL_CALL(x11Api, XGetInputFocus)(__VA_ARGS__)
+#define XGetKeyboardMapping(...) CROSSINPUT_DL_CALL(x11Api, XGetKeyboardMapping)(__VA_ARGS__)
+#define XGetSelectionOwner(...) CROSSINPUT_DL_CALL(x11Api, XGetSelectionOwner)(__VA_ARGS__)
+#define XGetWindowProperty(...) CROSSINPUT_DL_CALL(x11Api, XGetWindowProperty)(__VA_ARGS__)
+#define XInternAtom(...) CROSSINPUT_DL_CALL(x11Api, XInternAtom)(__VA_ARGS__)
+#define XKeysymToKeycode(...) CROSSINPUT_DL_CALL(x11Api, XKeysymToKeycode)(__VA_ARGS__)
+#define XMaxRequestSize(...) CROSSINPUT_DL_CALL(x11Api, XMaxRequestSize)(__VA_ARGS__)
+#define XNextEvent(...) CROSSINPUT_DL_CALL(x11Api, XNextEvent)(__VA_ARGS__)
+#define XOpenDisplay(...) CROSSINPUT_DL_CALL(x11Api, XOpenDisplay)(__VA_ARGS__)
+#define XPending(...) CROSSINPUT_DL_CALL(x11Api, XPending)(__VA_ARGS__)
+#define XQueryExtension(...) CROSSINPUT_DL_CALL(x11Api, XQueryExtension)(__VA_ARGS__)
+#define XQueryKeymap(...) CROSSINPUT_DL_CALL(x11Api, XQueryKeymap)(__VA_ARGS__)
+#define XQueryPointer(...) CROSSINPUT_DL_CALL(x11Api, XQueryPointer)(__VA_ARGS__)
+#define XQueryTree(...) CROSSINPUT_DL_CALL(x11Api, XQueryTree)(__VA_ARGS__)
+#define XRefreshKeyboardMapping(...) CROSSINPUT_DL_CALL(x11Api, XRefreshKeyboardMapping)(__VA_ARGS__)
+#define XSelectInput(...) CROSSINPUT_DL_CALL(x11Api, XSelectInput)(__VA_ARGS__)
+#define XSendEvent(...) CROSSINPUT_DL_CALL(x11Api, XSendEvent)(__VA_ARGS__)
+#define XSetErrorHandler(...) CROSSINPUT_DL_CALL(x11Api, XSetErrorHandler)(__VA_ARGS__)
+#define XSetSelectionOwner(...) CROSSINPUT_DL_CALL(x11Api, XSetSelectionOwner)(__VA_ARGS__)
+#define XSync(...) CROSSINPUT_DL_CALL(x11Api, XSync)(__VA_ARGS__)
+#define XWarpPointer(...) CROSSINPUT_DL_CALL(x11Api, XWarpPointer)(__VA_ARGS__)
+
+#define XTestFakeButtonEvent(...) CROSSINPUT_DL_CALL(xtstApi, XTestFakeButtonEvent)(__VA_ARGS__)
+#define XTestFakeKeyEvent(...) CROSSINPUT_DL_CALL(xtstApi, XTestFakeKeyEvent)(__VA_ARGS__)
+
+#ifdef CROSSINPUT_HAS_XI2
+#define XIQueryVersion(...) CROSSINPUT_DL_CALL(xiApi, XIQueryVersion)(__VA_ARGS__)
+#define XISelectEvents(...) CROSSINPUT_DL_CALL(xiApi, XISelectEvents)(__VA_ARGS__)
+#endif
+
+#ifdef CROSSINPUT_HAS_LIBEI
+#define ei_configure_name(...) CROSSINPUT_DL_CALL(eiApi, ei_configure_name)(__VA_ARGS__)
+#define ei_device_button_button(...) CROSSINPUT_DL_CALL(eiApi, ei_device_button_button)(__VA_ARGS__)
+#define ei_device_frame(...) CROSSINPUT_DL_CALL(eiApi, ei_device_frame)(__VA_ARGS__)
+#define ei_device_get_region(...) CROSSINPUT_DL_CALL(eiApi, ei_device_get_region)(__VA_ARGS__)
+#define ei_device_has_capability(...) CROSSINPUT_DL_CALL(eiApi, ei_device_has_capability)(__VA_ARGS__)
+#define ei_device_keyboard_get_keymap(...) CROSSINPUT_DL_CALL(eiApi, ei_device_keyboard_get_keymap)(__VA_ARGS__)
+#define ei_device_keyboard_key(...) CROSSINPUT_DL_CALL(eiApi, ei_device_keyboard_key)(__VA_ARGS__)
+#define ei_device_pointer_motion(...) CROSSINPUT_DL_CALL(eiApi, ei_device_pointer_motion)(__VA_ARGS__)
+#define ei_device_pointer_motion_absolute(...) CROSSINPUT_DL_CALL(eiApi, ei_device_pointer_motion_absolute)(__VA_ARGS__)
+#define ei_device_ref(...) CROSSINPUT_DL_CALL(eiApi, ei_device_ref)(__VA_ARGS__)
+#define ei_device_start_emulating(...) CROSSINPUT_DL_CALL(eiApi, ei_device_start_emulating)(__VA_ARGS__)
+#define ei_device_stop_emulating(...) CROSSINPUT_DL_CALL(eiApi, ei_device_stop_emulating)(__VA_ARGS__)
+#define ei_device_unref(...) CROSSINPUT_DL_CALL(eiApi, ei_device_unref)(__VA_ARGS__)
+#define ei_dispatch(...) CROSSINPUT_DL_CALL(eiApi, ei_dispatch)(__VA_ARGS__)
+#define ei_event_get_device(...) CROSSINPUT_DL_CALL(eiApi, ei_event_get_device)(__VA_ARGS__)
+#define ei_event_get_seat(...) CROSSINPUT_DL_CALL(eiApi, ei_event_get_seat)(__VA_ARGS__)
+#define ei_event_get_type(...) CROSSINPUT_DL_CALL(eiApi, ei_event_get_type)(__VA_ARGS__)
+#define ei_event_pong_get_ping(...) CROSSINPUT_DL_CALL(eiApi, ei_event_pong_get_ping)(__VA_ARGS__)
+#define ei_event_unref(...) CROSSINPUT_DL_CALL(eiApi, ei_event_unref)(__VA_ARGS__)
+#define ei_get_event(...) CROSSINPUT_DL_CALL(eiApi, ei_get_event)(__VA_ARGS__)
+#define ei_get_fd(...) CROSSINPUT_DL_CALL(eiApi, ei_get_fd)(__VA_ARGS__)
+#define ei_keymap_get_fd(...) CROSSINPUT_DL_CALL(eiApi, ei_keymap_get_fd)(__VA_ARGS__)
+#define ei_keymap_get_size(...) CROSSINPUT_DL_CALL(eiApi, ei_keymap_get_size)(__VA_ARGS__)
+#define ei_keymap_get_type(...) CROSSINPUT_DL_CALL(eiApi, ei_keymap_get_type)(__VA_ARGS__)
+#define ei_keymap_ref(...) CROSSINPUT_DL_CALL(eiApi, ei_keymap_ref)(__VA_ARGS__)
+#define ei_keymap_unref(...) CROSSINPUT_DL_CALL(eiApi, ei_keymap_unref)(__VA_ARGS__)
+#define ei_new_ping(...) CROSSINPUT_DL_CALL(eiApi, ei_new_ping)(__VA_ARGS__)
+#define ei_new_sender(...) CROSSINPUT_DL_CALL(eiApi, ei_new_sender)(__VA_ARGS__)
+#define ei_now(...) CROSSINPUT_DL_CALL(eiApi, ei_now)(__VA_ARGS__)
+#define ei_ping(...) CROSSINPUT_DL_CALL(eiApi, ei_ping)(__VA_ARGS__)
+#define ei_ping_unref(...) CROSSINPUT_DL_CALL(eiApi, ei_ping_unref)(__VA_ARGS__)
+#define ei_region_get_height(...) CROSSINPUT_DL_CALL(eiApi, ei_region_get_height)(__VA_ARGS__)
+#define ei_region_get_width(...) CROSSINPUT_DL_CALL(eiApi, ei_region_get_width)(__VA_ARGS__)
+#define ei_region_get_x(...) CROSSINPUT_DL_CALL(eiApi, ei_region_get_x)(__VA_ARGS__)
+#define ei_region_get_y(...) CROSSINPUT_DL_CALL(eiApi, ei_region_get_y)(__VA_ARGS__)
+#define ei_seat_bind_capabilities(...) CROSSINPUT_DL_CALL(eiApi, ei_seat_bind_capabilities)(__VA_ARGS__)
+#define ei_seat_ref(...) CROSSINPUT_DL_CALL(eiApi, ei_seat_ref)(__VA_ARGS__)
+#define ei_seat_unref(...) CROSSINPUT_DL_CALL(eiApi, ei_seat_unref)(__VA_ARGS__)
+#define ei_setup_backend_fd(...) CROSSINPUT_DL_CALL(eiApi, ei_setup_backend_fd)(__VA_ARGS__)
+#define ei_unref(...) CROSSINPUT_DL_CALL(eiApi, ei_unref)(__VA_ARGS__)
+
+// glib 2.76+ defines g_strdup as a macro around an inline wrapper
+#undef g_strdup
+#define g_bus_get_sync(...) CROSSINPUT_DL_CALL(gioApi, g_bus_get_sync)(__VA_ARGS__)
+#define g_dbus_connection_call_sync(...) CROSSINPUT_DL_CALL(gioApi, g_dbus_connection_call_sync)(__VA_ARGS__)
+#define g_dbus_connection_call_with_unix_fd_list_sync(...) CROSSINPUT_DL_CALL(gioApi, g_dbus_connection_call_with_unix_fd_list_sync)(__VA_ARGS__)
+#define g_dbus_connection_get_unique_name(...) CROSSINPUT_DL_CALL(gioApi, g_dbus_connection_get_unique_name)(__VA_ARGS__)
+#define g_dbus_connection_signal_subscribe(...) CROSSINPUT_DL_CALL(gioApi, g_dbus_connection_signal_subscribe)(__VA_ARGS__)
+#define g_dbus_connection_signal_unsubscribe(...) CROSSINPUT_DL_CALL(gioApi, g_dbus_connection_signal_unsubscribe)(__VA_ARGS__)
+#define g_error_free(...) CROSSINPUT_DL_CALL(gioApi, g_error_free)(__VA_ARGS__)
+#define g_free(...) CROSSINPUT_DL_CALL(gioApi, g_free)(__VA_ARGS__)
+#define g_get_monotonic_time(...) CROSSINPUT_DL_CALL(gioApi, g_get_monotonic_time)(__VA_ARGS__)
+#define g_main_context_default(...) CROSSINPUT_DL_CALL(gioApi, g_main_context_default)(__VA_ARGS__)
+#define g_main_context_iteration(...) CROSSINPUT_DL_CALL(gioApi, g_main_context_iteration)(__VA_ARGS__)
+#define g_object_unref(...) CROSSINPUT_DL_CALL(gioApi, g_object_unref)(__VA_ARGS__)
+#define g_strdup(...) CROSSINPUT_DL_CALL(gioApi, g_strdup)(__VA_ARGS__)
+#define g_unix_fd_list_get(...) CROSSINPUT_DL_CALL(gioApi, g_unix_fd_list_get)(__VA_ARGS__)
+#define g_variant_builder_add(...) CROSSINPUT_DL_CALL(gioApi, g_variant_builder_add)(__VA_ARGS__)
+#define g_variant_builder_init(...) CROSSINPUT_DL_CALL(gioApi, g_variant_builder_init)(__VA_ARGS__)
+#define g_variant_get(...) CROSSINPUT_DL_CALL(gioApi, g_variant_get)(__VA_ARGS__)
+#define g_variant_new(...) CROSSINPUT_DL_CALL(gioApi, g_variant_new)(__VA_ARGS__)
+#define g_variant_new_string(...) CROSSINPUT_DL_CALL(gioApi, g_variant_new_string)(__VA_ARGS__)
+#define g_variant_new_uint32(...) CROSSINPUT_DL_CALL(gioApi, g_variant_new_uint32)(__VA_ARGS__)
+#define g_variant_type_checked_(...) CROSSINPUT_DL_CALL(gioApi, g_variant_type_checked_)(__VA_ARGS__)
+#define g_variant_unref(...) CROSSINPUT_DL_CALL(gioApi, g_variant_unref)(__VA_ARGS__)
+#endif // CROSSINPUT_HAS_LIBEI
+
+#ifdef CROSSINPUT_HAS_XKBCOMMON
+#define xkb_context_new(...) CROSSINPUT_DL_CALL(xkbApi, xkb_context_new)(__VA_ARGS__)
+#define xkb_context_unref(...) CROSSINPUT_DL_CALL(xkbApi, xkb_context_unref)(__VA_ARGS__)
+#define xkb_keymap_key_for_each(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_key_for_each)(__VA_ARGS__)
+#define xkb_keymap_key_get_mods_for_level(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_key_get_mods_for_level)(__VA_ARGS__)
+#define xkb_keymap_key_get_syms_by_level(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_key_get_syms_by_level)(__VA_ARGS__)
+#define xkb_keymap_mod_get_index(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_mod_get_index)(__VA_ARGS__)
+#define xkb_keymap_new_from_buffer(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_new_from_buffer)(__VA_ARGS__)
+#define xkb_keymap_num_levels_for_key(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_num_levels_for_key)(__VA_ARGS__)
+#define xkb_keymap_unref(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keymap_unref)(__VA_ARGS__)
+#define xkb_keysym_to_utf32(...) CROSSINPUT_DL_CALL(xkbApi, xkb_keysym_to_utf32)(__VA_ARGS__)
+#endif // CROSSINPUT_HAS_XKBCOMMON
+
+#endif // CROSSINPUT_DLOPEN
+
+#endif // CROSSINPUT_LINUX
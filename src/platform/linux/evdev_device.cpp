@@ -0,0 +1,275 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "evdev_device.h"
+#include "../../core/startup_phases.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Deliberately after every CrossInput header, see evdev_device.h
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+        namespace
+        {
+            // Retries interrupted writes; anything short of `bytes` is a failure
+            bool writeAll(int fd, const void *data, size_t bytes)
+            {
+                ssize_t written;
+                while ((written = write(fd, data, bytes)) < 0 && errno == EINTR)
+                {
+                }
+                markStartupPhase(StartupPhase::FirstFrame);
+                return written == static_cast<ssize_t>(bytes);
+            }
+
+            constexpr size_t bitsToLongs(size_t bits)
+            {
+                return (bits + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long));
+            }
+
+            bool testBit(const unsigned long *bits, size_t bit)
+            {
+                return (bits[bit / (8 * sizeof(unsigned long))] >> (bit % (8 * sizeof(unsigned long)))) & 1UL;
+            }
+
+            unsigned probeCapabilities(int fd)
+            {
+                unsigned long types[bitsToLongs(EV_MAX + 1)] = {};
+                unsigned long keys[bitsToLongs(KEY_MAX + 1)] = {};
+                unsigned long rel[bitsToLongs(REL_MAX + 1)] = {};
+                if (ioctl(fd, EVIOCGBIT(0, sizeof(types)), types) < 0)
+                    return 0;
+                if (testBit(types, EV_KEY))
+                    ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys);
+                if (testBit(types, EV_REL))
+                    ioctl(fd, EVIOCGBIT(EV_REL, sizeof(rel)), rel);
+
+                unsigned caps = 0;
+                if (testBit(keys, KEY_A) && testBit(keys, KEY_SPACE))
+                    caps |= kEvdevKeyboard;
+                if (testBit(keys, BTN_LEFT) && testBit(rel, REL_X) && testBit(rel, REL_Y))
+                    caps |= kEvdevPointer;
+                return caps;
+            }
+
+            // Opens /dev/uinput and applies the identity shared by our virtual devices
+            int openUinput()
+            {
+                int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+                if (fd < 0)
+                    fprintf(stderr, "CrossInput: Cannot open /dev/uinput: %s\n", strerror(errno));
+                else
+                    markStartupPhase(StartupPhase::Connect);
+                return fd;
+            }
+
+            bool finishUinput(int fd, const char *name)
+            {
+                uinput_setup setup = {};
+                setup.id.bustype = BUS_VIRTUAL;
+                setup.id.vendor = 0x1209; // pid.codes open-source vendor id
+                setup.id.product = 0x0001;
+                setup.id.version = 1;
+                strncpy(setup.name, name, UINPUT_MAX_NAME_SIZE - 1);
+
+                if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0)
+                {
+                    fprintf(stderr, "CrossInput: Failed to create uinput device: %s\n", strerror(errno));
+                    close(fd);
+                    return false;
+                }
+                markStartupPhase(StartupPhase::Session);
+                return true;
+            }
+        } // namespace
+
+        EvdevDevice::EvdevDevice(const std::string &path)
+            : path_(path), fd_(open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC))
+        {
+            if (fd_ < 0)
+                return;
+
+            int clock = CLOCK_MONOTONIC;
+            ioctl(fd_, EVIOCSCLOCKID, &clock);
+            capabilities_ = probeCapabilities(fd_);
+        }
+
+        EvdevDevice::~EvdevDevice()
+        {
+            if (fd_ >= 0)
+                close(fd_);
+        }
+
+        bool EvdevDevice::keyState(uint8_t (&bits)[kEvdevKeyStateBytes]) const
+        {
+            static_assert(kEvdevKeyStateBytes * 8 == KEY_MAX + 1, "key state buffer must cover KEY_MAX");
+            return ioctl(fd_, EVIOCGKEY(sizeof(bits)), bits) >= 0;
+        }
+
+        size_t EvdevDevice::read(EvdevEvent *out, size_t max, bool &gone)
+        {
+            gone = false;
+            input_event raw[64];
+            if (max > 64)
+                max = 64;
+
+            ssize_t bytes;
+            while ((bytes = ::read(fd_, raw, max * sizeof(input_event))) < 0 && errno == EINTR)
+            {
+            }
+            if (bytes < 0)
+            {
+                gone = (errno == ENODEV);
+                return 0;
+            }
+
+            size_t count = static_cast<size_t>(bytes) / sizeof(input_event);
+            for (size_t i = 0; i < count; ++i)
+            {
+                out[i].type = raw[i].type;
+                out[i].code = raw[i].code;
+                out[i].value = raw[i].value;
+                out[i].timeNs = static_cast<int64_t>(raw[i].input_event_sec) * 1000000000LL +
+                                static_cast<int64_t>(raw[i].input_event_usec) * 1000LL;
+            }
+            return count;
+        }
+
+        std::vector<std::unique_ptr<EvdevDevice>> openEvdevDevices(unsigned wanted)
+        {
+            std::vector<std::unique_ptr<EvdevDevice>> devices;
+
+            DIR *dir = opendir("/dev/input");
+            if (!dir)
+                return devices;
+
+            std::vector<std::string> paths;
+            while (dirent *entry = readdir(dir))
+            {
+                if (strncmp(entry->d_name, "event", 5) == 0)
+                    paths.push_back(std::string("/dev/input/") + entry->d_name);
+            }
+            closedir(dir);
+            std::sort(paths.begin(), paths.end());
+
+            for (const auto &path : paths)
+            {
+                std::unique_ptr<EvdevDevice> device(new EvdevDevice(path));
+                if (device->isValid() && (device->capabilities() & wanted))
+                    devices.push_back(std::move(device));
+            }
+            return devices;
+        }
+
+        std::unique_ptr<UinputDevice> UinputDevice::createKeyboardMouse(const char *name)
+        {
+            int fd = openUinput();
+            if (fd < 0)
+                return nullptr;
+
+            ioctl(fd, UI_SET_EVBIT, EV_KEY);
+            for (int code = 1; code < 256; ++code)
+                ioctl(fd, UI_SET_KEYBIT, code);
+            ioctl(fd, UI_SET_KEYBIT, BTN_LEFT);
+            ioctl(fd, UI_SET_KEYBIT, BTN_RIGHT);
+            ioctl(fd, UI_SET_KEYBIT, BTN_MIDDLE);
+            ioctl(fd, UI_SET_EVBIT, EV_REL);
+            ioctl(fd, UI_SET_RELBIT, REL_X);
+            ioctl(fd, UI_SET_RELBIT, REL_Y);
+
+            if (!finishUinput(fd, name))
+                return nullptr;
+            return std::unique_ptr<UinputDevice>(new UinputDevice(fd));
+        }
+
+        std::unique_ptr<UinputDevice> UinputDevice::createTablet(const char *name, int width, int height)
+        {
+            int fd = openUinput();
+            if (fd < 0)
+                return nullptr;
+
+            // Compositors treat an ABS_X/ABS_Y device with BTN_LEFT like a VM tablet
+            // and map its range onto the whole screen
+            ioctl(fd, UI_SET_EVBIT, EV_KEY);
+            ioctl(fd, UI_SET_KEYBIT, BTN_LEFT);
+            ioctl(fd, UI_SET_EVBIT, EV_ABS);
+            ioctl(fd, UI_SET_ABSBIT, ABS_X);
+            ioctl(fd, UI_SET_ABSBIT, ABS_Y);
+            ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_POINTER);
+
+            uinput_abs_setup axis = {};
+            axis.code = ABS_X;
+            axis.absinfo.maximum = width - 1;
+            ioctl(fd, UI_ABS_SETUP, &axis);
+            axis.code = ABS_Y;
+            axis.absinfo.maximum = height - 1;
+            ioctl(fd, UI_ABS_SETUP, &axis);
+
+            if (!finishUinput(fd, name))
+                return nullptr;
+            return std::unique_ptr<UinputDevice>(new UinputDevice(fd));
+        }
+
+        UinputDevice::~UinputDevice()
+        {
+            ioctl(fd_, UI_DEV_DESTROY);
+            close(fd_);
+        }
+
+        bool UinputDevice::writeFrame(const EvdevEvent *events, size_t count)
+        {
+            input_event frame[17] = {};
+            if (count > 16)
+                return false;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                frame[i].type = events[i].type;
+                frame[i].code = events[i].code;
+                frame[i].value = events[i].value;
+            }
+            frame[count].type = EV_SYN;
+            frame[count].code = SYN_REPORT;
+
+            return writeAll(fd_, frame, (count + 1) * sizeof(input_event));
+        }
+
+        bool UinputDevice::writeFrames(const EvdevFrames &frames)
+        {
+            return writeAll(fd_, frames.bytes_.data(), frames.bytes_.size());
+        }
+
+        void EvdevFrames::append(const EvdevEvent *events, size_t count)
+        {
+            size_t offset = bytes_.size();
+            bytes_.resize(offset + (count + 1) * sizeof(input_event));
+            input_event *frame = reinterpret_cast<input_event *>(bytes_.data() + offset);
+            for (size_t i = 0; i < count; ++i)
+            {
+                frame[i] = input_event{};
+                frame[i].type = events[i].type;
+                frame[i].code = events[i].code;
+                frame[i].value = events[i].value;
+            }
+            frame[count] = input_event{};
+            frame[count].type = EV_SYN;
+            frame[count].code = SYN_REPORT;
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
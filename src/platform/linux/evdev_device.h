@@ -0,0 +1,125 @@
+#pragma once
+
+#ifdef CROSSINPUT_LINUX
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Thin wrappers over /dev/input/event* nodes and /dev/uinput virtual devices.
+// <linux/input.h> defines KEY_* macros
+// that collide with CrossInput::KeyCode, so it is only included by evdev_device.cpp
+// and this header exposes plain integers instead.
+
+// Event types and codes used by the evdev readers, alongside the key codes in
+// linux_keycodes.h (values from <linux/input-event-codes.h>)
+namespace EvdevCodes
+{
+    constexpr uint16_t EVDEV_EV_SYN = 0x00;
+    constexpr uint16_t EVDEV_EV_KEY = 0x01;
+    constexpr uint16_t EVDEV_EV_REL = 0x02;
+    constexpr uint16_t EVDEV_EV_ABS = 0x03;
+    constexpr uint16_t EVDEV_SYN_REPORT = 0;
+    constexpr uint16_t EVDEV_REL_X = 0x00;
+    constexpr uint16_t EVDEV_REL_Y = 0x01;
+    constexpr uint16_t EVDEV_ABS_X = 0x00;
+    constexpr uint16_t EVDEV_ABS_Y = 0x01;
+}
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        struct EvdevEvent
+        {
+            uint16_t type;
+            uint16_t code;
+            int32_t value;
+            int64_t timeNs; // CLOCK_MONOTONIC, the same epoch as steady_clock
+        };
+
+        // Bytes needed for one bit per key code up to KEY_MAX (0x2ff)
+        constexpr size_t kEvdevKeyStateBytes = 0x300 / 8;
+
+        enum EvdevCapability : unsigned
+        {
+            kEvdevKeyboard = 1, // reports letter keys
+            kEvdevPointer = 2   // reports BTN_LEFT and relative motion
+        };
+
+        class EvdevDevice
+        {
+        public:
+            // Opens the node non-blocking and switches its timestamps to CLOCK_MONOTONIC
+            explicit EvdevDevice(const std::string &path);
+            ~EvdevDevice();
+
+            bool isValid() const { return fd_ >= 0; }
+            int fd() const { return fd_; }
+            unsigned capabilities() const { return capabilities_; }
+            const std::string &path() const { return path_; }
+
+            // Snapshot of every key's up/down state (EVIOCGKEY), one bit per key code
+            bool keyState(uint8_t (&bits)[kEvdevKeyStateBytes]) const;
+
+            // Reads whatever is queued, up to `max` events; 0 when nothing is pending.
+            // Sets `gone` when the device has been unplugged.
+            size_t read(EvdevEvent *out, size_t max, bool &gone);
+
+            EvdevDevice(const EvdevDevice &) = delete;
+            EvdevDevice &operator=(const EvdevDevice &) = delete;
+
+        private:
+            std::string path_;
+            int fd_;
+            unsigned capabilities_ = 0;
+        };
+
+        // Opens every readable event node with at least one of the `wanted` capabilities
+        std::vector<std::unique_ptr<EvdevDevice>> openEvdevDevices(unsigned wanted);
+
+        // Frames serialized once, for writing to a UinputDevice many times
+        class EvdevFrames
+        {
+        public:
+            // Adds the events followed by SYN_REPORT
+            void append(const EvdevEvent *events, size_t count);
+            bool empty() const { return bytes_.empty(); }
+
+        private:
+            friend class UinputDevice;
+            std::vector<unsigned char> bytes_; // struct input_event records
+        };
+
+        // A virtual input device created through /dev/uinput. The kernel stamps
+        // the events, so EvdevEvent::timeNs is ignored when writing.
+        class UinputDevice
+        {
+        public:
+            // Keyboard (every code below 256) plus a three-button relative mouse
+            static std::unique_ptr<UinputDevice> createKeyboardMouse(const char *name);
+            // Absolute pointer covering a width x height screen, for warping the cursor
+            static std::unique_ptr<UinputDevice> createTablet(const char *name, int width, int height);
+            ~UinputDevice();
+
+            // Writes the events followed by SYN_REPORT in a single write()
+            bool writeFrame(const EvdevEvent *events, size_t count);
+            // Writes every frame in a single write()
+            bool writeFrames(const EvdevFrames &frames);
+
+            UinputDevice(const UinputDevice &) = delete;
+            UinputDevice &operator=(const UinputDevice &) = delete;
+
+        private:
+            explicit UinputDevice(int fd) : fd_(fd) {}
+
+            int fd_;
+        };
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
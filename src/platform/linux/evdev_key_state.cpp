@@ -0,0 +1,135 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include "evdev_device.h"
+#include "linux_keycodes.h"
+#include <chrono>
+#include <mutex>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace CrossInput
+{
+#ifdef CROSSINPUT_HAS_LIBEI
+    namespace WaylandImpl
+    {
+        // evdev code of `key` under the layout of the last keymap EIS sent;
+        // false until a keyboard with an XKB keymap has been used
+        bool LayoutEvdevCode(KeyCode key, unsigned int &code);
+    } // namespace WaylandImpl
+#endif
+
+    namespace EvdevImpl
+    {
+        namespace
+        {
+            using Clock = std::chrono::steady_clock;
+
+            // Keyboard nodes are found once and kept open. An inotify watch on
+            // /dev/input marks the set stale when devices come, go or change
+            // permissions; it is checked at most every kHotplugInterval, so a
+            // steady-state query is one EVIOCGKEY per keyboard and nothing else.
+            class KeyboardSet
+            {
+            public:
+                static constexpr std::chrono::milliseconds kHotplugInterval{250};
+
+                ~KeyboardSet()
+                {
+                    if (inotify_fd_ >= 0)
+                        close(inotify_fd_);
+                }
+
+                // Call with mutex() held
+                const std::vector<std::unique_ptr<Internal::EvdevDevice>> &keyboards()
+                {
+                    Clock::time_point now = Clock::now();
+                    if (!scanned_)
+                    {
+                        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                        if (inotify_fd_ >= 0)
+                            inotify_add_watch(inotify_fd_, "/dev/input", IN_CREATE | IN_DELETE | IN_ATTRIB);
+                        keyboards_ = Internal::openEvdevDevices(Internal::kEvdevKeyboard);
+                        scanned_ = true;
+                        next_check_ = now + kHotplugInterval;
+                    }
+                    else if (now >= next_check_)
+                    {
+                        next_check_ = now + kHotplugInterval;
+                        if (drainNotifications())
+                            keyboards_ = Internal::openEvdevDevices(Internal::kEvdevKeyboard);
+                    }
+                    return keyboards_;
+                }
+
+                std::mutex &mutex() { return mutex_; }
+
+            private:
+                bool drainNotifications()
+                {
+                    if (inotify_fd_ < 0)
+                        return false;
+
+                    alignas(inotify_event) char buffer[4096];
+                    bool changed = false;
+                    while (read(inotify_fd_, buffer, sizeof(buffer)) > 0)
+                        changed = true;
+                    return changed;
+                }
+
+                std::mutex mutex_;
+                std::vector<std::unique_ptr<Internal::EvdevDevice>> keyboards_;
+                int inotify_fd_ = -1;
+                bool scanned_ = false;
+                Clock::time_point next_check_;
+            };
+
+            KeyboardSet &keyboardSet()
+            {
+                static KeyboardSet set;
+                return set;
+            }
+
+            // The key libei would press for `key`, so state and injection agree
+            // on non-US layouts; the fixed US mapping without a keymap
+            unsigned int evdevCode(KeyCode key)
+            {
+#ifdef CROSSINPUT_HAS_LIBEI
+                unsigned int code = 0;
+                if (WaylandImpl::LayoutEvdevCode(key, code))
+                    return code;
+#endif
+                return Internal::keycode_to_evdev(key);
+            }
+        } // namespace
+
+        bool Available()
+        {
+            KeyboardSet &set = keyboardSet();
+            std::lock_guard<std::mutex> lock(set.mutex());
+            return !set.keyboards().empty();
+        }
+
+        bool IsKeyPressed(KeyCode key)
+        {
+            unsigned int code = evdevCode(key);
+            if (code == 0)
+                return false;
+
+            KeyboardSet &set = keyboardSet();
+            std::lock_guard<std::mutex> lock(set.mutex());
+            for (const auto &keyboard : set.keyboards())
+            {
+                uint8_t bits[Internal::kEvdevKeyStateBytes];
+                if (keyboard->keyState(bits) && (bits[code / 8] & (1u << (code % 8))))
+                    return true;
+            }
+            return false;
+        }
+
+    } // namespace EvdevImpl
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
@@ -3,11 +3,15 @@
 #ifdef CROSSINPUT_LINUX
 #ifdef CROSSINPUT_HAS_LIBEI
 
+#include "../../core/startup_phases.h"
+#include "../../core/stats.h"
+#include "../../core/trace.h"
 #include <libei.h>
 #include <poll.h>
 #include <unistd.h>
 #include <gio/gio.h>
 #include <gio/gunixfdlist.h>
+#include "dynamic_libs.h"
 #include <cstdio>
 
 namespace CrossInput
@@ -25,6 +29,8 @@ namespace CrossInput
                              session_ready_(false), portal_error_(false),
                              keyboard_resumed_(false), pointer_resumed_(false)
             {
+                if (!libeiAvailable())
+                    return;
                 initPortalSession();
 
                 if (ei_)
@@ -34,6 +40,25 @@ namespace CrossInput
                 }
             }
 
+            // Skips the portal and talks to an EIS server over an already
+            // connected socket, e.g. a compositor's test socket or libeis
+            explicit LibeiContext(int eis_fd)
+                : ei_(nullptr), seat_(nullptr), keyboard_(nullptr), pointer_(nullptr),
+                  connection_(nullptr), session_handle_(nullptr), eis_fd_(eis_fd),
+                  session_ready_(false), portal_error_(false),
+                  keyboard_resumed_(false), pointer_resumed_(false)
+            {
+                if (!libeiAvailable())
+                {
+                    close(eis_fd);
+                    return;
+                }
+                setupEi();
+
+                if (ei_)
+                    processEvents();
+            }
+
             ~LibeiContext()
             {
                 if (pointer_)
@@ -53,6 +78,8 @@ namespace CrossInput
             bool isValid() const { return ei_ != nullptr && (keyboard_ != nullptr || pointer_ != nullptr); }
             bool hasKeyboard() const { return keyboard_ != nullptr; }
             bool hasPointer() const { return pointer_ != nullptr; }
+            // False for a connection handed over with UseEisConnection
+            bool fromPortal() const { return connection_ != nullptr; }
 
             ei *get() const { return ei_; }
             ei_device *getKeyboard() const { return keyboard_; }
@@ -62,7 +89,12 @@ namespace CrossInput
             {
                 if (ei_)
                 {
-                    ei_dispatch(ei_);
+                    {
+                        FlushTimer timer;
+                        TraceScope trace("libei", "Flush");
+                        ei_dispatch(ei_);
+                    }
+                    markStartupPhase(StartupPhase::FirstFrame);
                     ei_event *event;
                     while ((event = ei_get_event(ei_)) != nullptr)
                     {
@@ -72,6 +104,50 @@ namespace CrossInput
                 }
             }
 
+            // Round trip to EIS: returns true once the compositor has answered a
+            // ping sent after every event queued so far, false on timeout
+            bool sync(int timeout_ms)
+            {
+                if (!ei_)
+                    return false;
+
+                TraceScope trace("libei", "Sync");
+                struct ei_ping *ping = ei_new_ping(ei_);
+                if (!ping)
+                    return false;
+                ei_ping(ping);
+
+                struct pollfd pfd;
+                pfd.fd = ei_get_fd(ei_);
+                pfd.events = POLLIN;
+
+                gint64 end_time = g_get_monotonic_time() + (gint64)(timeout_ms * 1000);
+                bool ponged = false;
+                while (!ponged)
+                {
+                    ei_dispatch(ei_);
+                    ei_event *event;
+                    while ((event = ei_get_event(ei_)) != nullptr)
+                    {
+                        if (ei_event_get_type(event) == EI_EVENT_PONG && ei_event_pong_get_ping(event) == ping)
+                            ponged = true;
+                        else
+                            handleEvent(event);
+                        ei_event_unref(event);
+                    }
+                    if (ponged)
+                        break;
+
+                    gint64 remaining_ms = (end_time - g_get_monotonic_time()) / 1000;
+                    if (remaining_ms <= 0)
+                        break;
+                    poll(&pfd, 1, static_cast<int>(remaining_ms));
+                }
+
+                ei_ping_unref(ping);
+                return ponged;
+            }
+
             // Non-copyable
             LibeiContext(const LibeiContext &) = delete;
             LibeiContext &operator=(const LibeiContext &) = delete;
@@ -151,6 +227,8 @@ namespace CrossInput
 
             void initPortalSession()
             {
+                // One span per portal round trip; the last one ends when this returns
+                TraceScope step("portal", "Connect session bus");
                 GError *error = nullptr;
                 connection_ = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, &error);
                 if (!connection_)
@@ -160,6 +238,7 @@ namespace CrossInput
                         g_error_free(error);
                     return;
                 }
+                markStartupPhase(StartupPhase::Connect);
 
                 // Generate unique tokens
                 char token[64];
@@ -185,6 +264,7 @@ namespace CrossInput
                 guint signal_id = subscribeToResponse(expected_request_path);
 
                 // === Step 1: CreateSession ===
+                step.next("CreateSession");
                 GVariantBuilder options;
                 g_variant_builder_init(&options, G_VARIANT_TYPE("a{sv}"));
                 g_variant_builder_add(&options, "{sv}", "handle_token", g_variant_new_string(token));
@@ -229,6 +309,7 @@ namespace CrossInput
                 session_handle_ = g_strdup(session_path);
 
                 // === Step 2: SelectDevices ===
+                step.next("SelectDevices");
                 char select_token[64];
                 snprintf(select_token, sizeof(select_token), "selectdevices%d", getpid());
 
@@ -276,6 +357,7 @@ namespace CrossInput
                 }
 
                 // === Step 3: Start (may show permission dialog) ===
+                step.next("Start");
                 char start_token[64];
                 snprintf(start_token, sizeof(start_token), "start%d", getpid());
 
@@ -322,9 +404,10 @@ namespace CrossInput
                     return;
                 }
 
-                fprintf(stderr, "CrossInput: Portal session started successfully\n");
+                markStartupPhase(StartupPhase::Session);
 
                 // === Step 4: ConnectToEIS ===
+                step.next("ConnectToEIS");
                 g_variant_builder_init(&options, G_VARIANT_TYPE("a{sv}"));
 
                 GUnixFDList *fd_list = nullptr;
@@ -371,9 +454,14 @@ namespace CrossInput
                     return;
                 }
 
-                fprintf(stderr, "CrossInput: Got EIS fd: %d\n", eis_fd_);
-
                 // Create libei context
+                step.next("ei setup");
+                setupEi();
+            }
+
+            // Creates the libei sender on the connected EIS socket in eis_fd_
+            void setupEi()
+            {
                 ei_ = ei_new_sender(nullptr);
                 if (!ei_)
                 {
@@ -391,8 +479,6 @@ namespace CrossInput
                     ei_ = nullptr;
                     return;
                 }
-
-                fprintf(stderr, "CrossInput: libei context initialized successfully\n");
             }
 
             void processEvents()
@@ -400,6 +486,7 @@ namespace CrossInput
                 if (!ei_)
                     return;
 
+                TraceScope trace("libei", "Wait for devices");
                 struct pollfd pfd;
                 pfd.fd = ei_get_fd(ei_);
                 pfd.events = POLLIN;
@@ -420,10 +507,8 @@ namespace CrossInput
                     }
                 }
 
-                if (keyboard_)
-                    fprintf(stderr, "CrossInput: Got keyboard device (resumed: %d)\n", keyboard_resumed_);
-                if (pointer_)
-                    fprintf(stderr, "CrossInput: Got pointer device (resumed: %d)\n", pointer_resumed_);
+                if (keyboard_resumed_ || pointer_resumed_)
+                    markStartupPhase(StartupPhase::DeviceReady);
             }
 
             void handleEvent(ei_event *event)
@@ -450,6 +535,7 @@ namespace CrossInput
                     {
                         keyboard_ = device;
                         ei_device_ref(keyboard_);
+                        traceInstant("libei", "Keyboard added");
                     }
                     if ((ei_device_has_capability(device, EI_DEVICE_CAP_POINTER) ||
                          ei_device_has_capability(device, EI_DEVICE_CAP_POINTER_ABSOLUTE) ||
@@ -458,28 +544,8 @@ namespace CrossInput
                     {
                         pointer_ = device;
                         ei_device_ref(pointer_);
-                        fprintf(stderr, "CrossInput: Pointer capabilities: rel=%d abs=%d btn=%d\n",
-                                ei_device_has_capability(device, EI_DEVICE_CAP_POINTER),
-                                ei_device_has_capability(device, EI_DEVICE_CAP_POINTER_ABSOLUTE),
-                                ei_device_has_capability(device, EI_DEVICE_CAP_BUTTON));
-
-                        // Print region info for absolute pointer
-                        if (ei_device_has_capability(device, EI_DEVICE_CAP_POINTER_ABSOLUTE))
-                        {
-                            size_t i = 0;
-                            struct ei_region *region;
-                            while ((region = ei_device_get_region(device, i)) != nullptr)
-                            {
-                                fprintf(stderr, "CrossInput: Region %zu: x=%u y=%u w=%u h=%u\n",
-                                        i, ei_region_get_x(region), ei_region_get_y(region),
-                                        ei_region_get_width(region), ei_region_get_height(region));
-                                i++;
-                            }
-                            if (i == 0)
-                            {
-                                fprintf(stderr, "CrossInput: No regions found for absolute pointer\n");
-                            }
-                        }
+                        traceInstant("libei", "Pointer added", "absolute",
+                                     ei_device_has_capability(device, EI_DEVICE_CAP_POINTER_ABSOLUTE));
                     }
                     break;
                 }
@@ -489,12 +555,32 @@ namespace CrossInput
                     if (device == keyboard_)
                     {
                         keyboard_resumed_ = true;
-                        fprintf(stderr, "CrossInput: Keyboard device resumed\n");
+                        traceInstant("libei", "Keyboard resumed");
                     }
                     if (device == pointer_)
                     {
                         pointer_resumed_ = true;
-                        fprintf(stderr, "CrossInput: Pointer device resumed\n");
+                        traceInstant("libei", "Pointer resumed");
+                    }
+                    break;
+                }
+                case EI_EVENT_DEVICE_REMOVED:
+                {
+                    // EIS replaces a device to change its keymap or regions; the
+                    // next DEVICE_ADDED picks up the replacement
+                    ei_device *device = ei_event_get_device(event);
+                    traceInstant("libei", "Device removed");
+                    if (device == keyboard_)
+                    {
+                        ei_device_unref(keyboard_);
+                        keyboard_ = nullptr;
+                        keyboard_resumed_ = false;
+                    }
+                    if (device == pointer_)
+                    {
+                        ei_device_unref(pointer_);
+                        pointer_ = nullptr;
+                        pointer_resumed_ = false;
                     }
                     break;
                 }
@@ -505,7 +591,7 @@ namespace CrossInput
                         keyboard_resumed_ = false;
                     if (device == pointer_)
                         pointer_resumed_ = false;
-                    fprintf(stderr, "CrossInput: Device paused\n");
+                    traceInstant("libei", "Device paused");
                     break;
                 }
                 default:
@@ -0,0 +1,341 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include "../../core/event_capture.h"
+#include "evdev_device.h"
+#include "linux_keycodes.h"
+#include "x11_keymap.h"
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef CROSSINPUT_HAS_XI2
+#include <X11/extensions/XInput2.h>
+#endif
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+        namespace
+        {
+            bool evdevButton(unsigned int code, MouseButton &out)
+            {
+                switch (code)
+                {
+                case EvdevCodes::EVDEV_BTN_LEFT:
+                    out = MouseButton::Left;
+                    return true;
+                case EvdevCodes::EVDEV_BTN_RIGHT:
+                    out = MouseButton::Right;
+                    return true;
+                case EvdevCodes::EVDEV_BTN_MIDDLE:
+                    out = MouseButton::Middle;
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            // Reads every keyboard and mouse node on one epoll thread. Relative
+            // motion is summed per device until SYN_REPORT, so one hardware frame
+            // becomes one MoveCursor event.
+            class EvdevCapture : public CaptureSource
+            {
+            public:
+                EvdevCapture(CaptureSink &sink, std::vector<std::unique_ptr<EvdevDevice>> devices)
+                    : sink_(sink),
+                      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+                      stop_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+                {
+                    epoll_event ev = {};
+                    ev.events = EPOLLIN;
+                    ev.data.ptr = nullptr;
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &ev);
+
+                    for (auto &device : devices)
+                    {
+                        std::unique_ptr<Source> source(new Source{std::move(device), 0, 0});
+                        ev.data.ptr = source.get();
+                        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, source->device->fd(), &ev);
+                        sources_.push_back(std::move(source));
+                    }
+
+                    thread_ = std::thread([this]
+                                          { run(); });
+                }
+
+                ~EvdevCapture() override
+                {
+                    uint64_t one = 1;
+                    ssize_t ignored = write(stop_fd_, &one, sizeof(one));
+                    (void)ignored;
+                    thread_.join();
+                    close(epoll_fd_);
+                    close(stop_fd_);
+                }
+
+            private:
+                struct Source
+                {
+                    std::unique_ptr<EvdevDevice> device;
+                    int dx;
+                    int dy;
+                };
+
+                void run()
+                {
+                    epoll_event ready[16];
+                    EvdevEvent events[64];
+                    for (;;)
+                    {
+                        int count = epoll_wait(epoll_fd_, ready, 16, -1);
+                        if (count < 0 && errno == EINTR)
+                            continue;
+                        if (count < 0)
+                            return;
+
+                        for (int i = 0; i < count; ++i)
+                        {
+                            auto *source = static_cast<Source *>(ready[i].data.ptr);
+                            if (!source)
+                                return;
+
+                            bool gone = false;
+                            size_t n;
+                            while ((n = source->device->read(events, 64, gone)) > 0)
+                                translate(*source, events, n);
+                            if (gone)
+                                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, source->device->fd(), nullptr);
+                        }
+                        sink_.flush();
+                    }
+                }
+
+                void translate(Source &source, const EvdevEvent *events, size_t count)
+                {
+                    using namespace EvdevCodes;
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        const EvdevEvent &e = events[i];
+                        std::chrono::nanoseconds timestamp(e.timeNs);
+
+                        if (e.type == EVDEV_EV_KEY && e.value != 2) // 2 is autorepeat
+                        {
+                            KeyCode key;
+                            MouseButton button;
+                            if (evdev_to_keycode(e.code, key))
+                                sink_.push(InputEvent::Key(key, e.value != 0), timestamp);
+                            else if (evdevButton(e.code, button))
+                                sink_.push(InputEvent::Button(button, e.value != 0), timestamp);
+                        }
+                        else if (e.type == EVDEV_EV_REL)
+                        {
+                            if (e.code == EVDEV_REL_X)
+                                source.dx += e.value;
+                            else if (e.code == EVDEV_REL_Y)
+                                source.dy += e.value;
+                        }
+                        else if (e.type == EVDEV_EV_SYN && e.code == EVDEV_SYN_REPORT)
+                        {
+                            if (source.dx != 0 || source.dy != 0)
+                                sink_.push(InputEvent::MoveBy(source.dx, source.dy), timestamp);
+                            source.dx = 0;
+                            source.dy = 0;
+                        }
+                    }
+                }
+
+                CaptureSink &sink_;
+                int epoll_fd_;
+                int stop_fd_;
+                std::vector<std::unique_ptr<Source>> sources_;
+                std::thread thread_;
+            };
+
+#ifdef CROSSINPUT_HAS_XI2
+            // Selects XI2 raw events on the root window of a private connection, so
+            // input is seen regardless of which window has focus. Raw motion carries
+            // device deltas, so the pointer is queried once per batch of motion
+            // events and reported as an absolute SetCursorPosition.
+            class XI2Capture : public CaptureSource
+            {
+            public:
+                static std::unique_ptr<XI2Capture> open(CaptureSink &sink)
+                {
+                    if (!Internal::xi2Available())
+                        return nullptr;
+                    Display *display = XOpenDisplay(nullptr);
+                    if (!display)
+                        return nullptr;
+
+                    int opcode, firstEvent, firstError;
+                    int major = 2, minor = 0;
+                    if (!XQueryExtension(display, "XInputExtension", &opcode, &firstEvent, &firstError) ||
+                        XIQueryVersion(display, &major, &minor) != Success)
+                    {
+                        XCloseDisplay(display);
+                        return nullptr;
+                    }
+
+                    unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+                    XISetMask(bits, XI_RawKeyPress);
+                    XISetMask(bits, XI_RawKeyRelease);
+                    XISetMask(bits, XI_RawButtonPress);
+                    XISetMask(bits, XI_RawButtonRelease);
+                    XISetMask(bits, XI_RawMotion);
+                    XIEventMask mask = {XIAllMasterDevices, sizeof(bits), bits};
+                    XISelectEvents(display, DefaultRootWindow(display), &mask, 1);
+                    XFlush(display);
+
+                    return std::unique_ptr<XI2Capture>(new XI2Capture(sink, display, opcode));
+                }
+
+                ~XI2Capture() override
+                {
+                    uint64_t one = 1;
+                    ssize_t ignored = write(stop_fd_, &one, sizeof(one));
+                    (void)ignored;
+                    thread_.join();
+                    close(stop_fd_);
+                    XCloseDisplay(display_);
+                }
+
+            private:
+                XI2Capture(CaptureSink &sink, Display *display, int opcode)
+                    : sink_(sink), display_(display), opcode_(opcode),
+                      stop_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+                {
+                    rebuildKeymap();
+                    thread_ = std::thread([this]
+                                          { run(); });
+                }
+
+                // X keycode -> KeyCode + 1 (0 for keys CrossInput does not name),
+                // from each keycode's unshifted keysym
+                void rebuildKeymap()
+                {
+                    keymap_.fill(0);
+                    X11KeyboardMapping mapping(display_);
+                    if (!mapping.isValid())
+                        return;
+                    for (int keycode = mapping.minKeycode(); keycode <= mapping.maxKeycode(); ++keycode)
+                    {
+                        KeyCode key;
+                        if (x11_keysym_to_keycode(mapping.get(keycode, 0), key))
+                            keymap_[keycode & 0xFF] = static_cast<uint8_t>(static_cast<int>(key) + 1);
+                    }
+                }
+
+                void run()
+                {
+                    pollfd fds[2] = {{ConnectionNumber(display_), POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+                    for (;;)
+                    {
+                        if (!XPending(display_))
+                        {
+                            if (poll(fds, 2, -1) < 0 && errno != EINTR)
+                                return;
+                            if (fds[1].revents & POLLIN)
+                                return;
+                        }
+
+                        bool moved = false;
+                        std::chrono::nanoseconds moveTime{0};
+                        while (XPending(display_))
+                        {
+                            XEvent ev;
+                            XNextEvent(display_, &ev);
+                            if (ev.type == MappingNotify)
+                            {
+                                XRefreshKeyboardMapping(&ev.xmapping);
+                                rebuildKeymap();
+                                continue;
+                            }
+                            if (ev.type != GenericEvent || ev.xcookie.extension != opcode_ ||
+                                !XGetEventData(display_, &ev.xcookie))
+                                continue;
+
+                            auto *raw = static_cast<XIRawEvent *>(ev.xcookie.data);
+                            auto timestamp = captureTimestamp();
+                            switch (ev.xcookie.evtype)
+                            {
+                            case XI_RawKeyPress:
+                            case XI_RawKeyRelease:
+                                if (uint8_t id = keymap_[raw->detail & 0xFF])
+                                    sink_.push(InputEvent::Key(static_cast<KeyCode>(id - 1),
+                                                               ev.xcookie.evtype == XI_RawKeyPress),
+                                               timestamp);
+                                break;
+                            case XI_RawButtonPress:
+                            case XI_RawButtonRelease:
+                                if (raw->detail >= 1 && raw->detail <= 3)
+                                {
+                                    static const MouseButton buttons[3] = {MouseButton::Left, MouseButton::Middle,
+                                                                           MouseButton::Right};
+                                    sink_.push(InputEvent::Button(buttons[raw->detail - 1],
+                                                                  ev.xcookie.evtype == XI_RawButtonPress),
+                                               timestamp);
+                                }
+                                break;
+                            case XI_RawMotion:
+                                moved = true;
+                                moveTime = timestamp;
+                                break;
+                            }
+                            XFreeEventData(display_, &ev.xcookie);
+                        }
+
+                        if (moved)
+                        {
+                            Window root, child;
+                            int rootX, rootY, winX, winY;
+                            unsigned int buttons;
+                            if (XQueryPointer(display_, DefaultRootWindow(display_), &root, &child,
+                                              &rootX, &rootY, &winX, &winY, &buttons))
+                                sink_.push(InputEvent::MoveTo({rootX, rootY}), moveTime);
+                        }
+                        sink_.flush();
+                    }
+                }
+
+                CaptureSink &sink_;
+                Display *display_;
+                int opcode_;
+                int stop_fd_;
+                std::array<uint8_t, 256> keymap_;
+                std::thread thread_;
+            };
+#endif // CROSSINPUT_HAS_XI2
+        } // namespace
+
+        std::unique_ptr<CaptureSource> startCapture(CaptureSink &sink)
+        {
+#ifdef CROSSINPUT_HAS_XI2
+            // Under Wayland, XWayland only sees input aimed at X clients
+            if (!IsWayland() && !IsWaylandSession() && HasX11Display())
+            {
+                if (auto source = XI2Capture::open(sink))
+                    return source;
+            }
+#endif
+
+            auto devices = openEvdevDevices(kEvdevKeyboard | kEvdevPointer);
+            if (!devices.empty())
+                return std::unique_ptr<CaptureSource>(new EvdevCapture(sink, std::move(devices)));
+
+            fprintf(stderr, "CrossInput: No input capture source available (is /dev/input readable?)\n");
+            return nullptr;
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
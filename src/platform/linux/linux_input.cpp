@@ -3,6 +3,13 @@
 #ifdef CROSSINPUT_LINUX
 
 #include "../../../include/CrossInput.h"
+#include "../../core/input_sequence.h"
+#include "../../core/stats.h"
+#include "../stub/null_backend.h"
+#include "daemon_protocol.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 // Forward declarations for X11 implementation
 namespace CrossInput
@@ -12,29 +19,122 @@ namespace CrossInput
         bool IsKeyPressed(KeyCode key);
         void KeyDown(KeyCode key);
         void KeyUp(KeyCode key);
+        void TypeText(std::string_view text);
         void MouseButtonDown(MouseButton button);
         void MouseButtonUp(MouseButton button);
         Point GetCursorPosition();
         void SetCursorPosition(const Point &pos);
         void MoveCursor(int dx, int dy);
+        bool Sync();
+        std::shared_ptr<const Internal::PreparedSequence> Prepare(const InputEvent *events, size_t count);
+        bool PasteText(std::string_view text, const PasteOptions &options);
     } // namespace X11Impl
 
 #ifdef CROSSINPUT_HAS_LIBEI
     namespace WaylandImpl
     {
+        bool KeyDown(KeyCode key);
+        bool KeyUp(KeyCode key);
+        bool TypeText(std::string_view text);
+        bool MouseButtonDown(MouseButton button);
+        bool MouseButtonUp(MouseButton button);
+        bool SetCursorPosition(const Point &pos);
+        bool MoveCursor(int dx, int dy);
+        bool FallbackToX11();
+        void SetReconnectPolicy(const ReconnectPolicy &policy);
+        bool Sync(int timeoutMs);
+        bool Connected();
+        bool TakeCursorTarget(Point &target);
+        void UseEisConnection(int fd);
+    } // namespace WaylandImpl
+#endif
+
+    namespace UinputImpl
+    {
+        bool Open();
         void KeyDown(KeyCode key);
         void KeyUp(KeyCode key);
+        void TypeText(std::string_view text);
         void MouseButtonDown(MouseButton button);
         void MouseButtonUp(MouseButton button);
         void SetCursorPosition(const Point &pos);
         void MoveCursor(int dx, int dy);
-    } // namespace WaylandImpl
+        std::shared_ptr<const Internal::PreparedSequence> Prepare(const InputEvent *events, size_t count);
+    } // namespace UinputImpl
+
+    namespace EvdevImpl
+    {
+        bool Available();
+        bool IsKeyPressed(KeyCode key);
+    } // namespace EvdevImpl
+
+    namespace DaemonImpl
+    {
+        bool Connect(const std::string &socketPath);
+        void KeyDown(KeyCode key);
+        void KeyUp(KeyCode key);
+        void TypeText(std::string_view text);
+        void MouseButtonDown(MouseButton button);
+        void MouseButtonUp(MouseButton button);
+        void SetCursorPosition(const Point &pos);
+        void MoveCursor(int dx, int dy);
+        bool Sync(int timeoutMs);
+    } // namespace DaemonImpl
+
+    namespace
+    {
+        std::atomic<Backend> g_backend{Backend::Auto};
+
+        // Set on an InjectorDaemon's thread, which keeps the backend it was
+        // started with whatever SetBackend later picks for the process
+        thread_local bool t_hasThreadBackend = false;
+        thread_local Backend t_threadBackend = Backend::Auto;
+
+        Backend requestedBackend()
+        {
+            return t_hasThreadBackend ? t_threadBackend : g_backend.load(std::memory_order_relaxed);
+        }
+
+        // Resolves Backend::Auto to the backend the session calls for
+        Backend activeBackend()
+        {
+            Backend backend = requestedBackend();
+            if (backend != Backend::Auto)
+                return backend;
+#ifdef CROSSINPUT_HAS_LIBEI
+            if (Internal::IsWayland() || Internal::IsWaylandSession())
+                return Backend::Wayland;
+#endif
+            return Backend::X11;
+        }
+
+#ifdef CROSSINPUT_HAS_LIBEI
+        // libei is unavailable: whether to send this call through XTest instead
+        bool fallBackToX11()
+        {
+            if (WaylandImpl::FallbackToX11() && Internal::HasX11Display())
+                return true;
+            Internal::markStatFailure();
+            return false;
+        }
 #endif
+    } // namespace
 
     // --- Public API Implementation (Hybrid approach: X11 for reading state, libei for input) ---
 
     bool IsKeyPressed(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::IsKeyPressed);
+        if (requestedBackend() == Backend::Null)
+            return NullImpl::IsKeyPressed(key);
+
+        // On Wayland, XWayland only tracks keys while an X client has focus, so
+        // prefer reading the keyboards' evdev nodes when they are accessible
+        if ((Internal::IsWayland() || Internal::IsWaylandSession()) && EvdevImpl::Available())
+        {
+            return EvdevImpl::IsKeyPressed(key);
+        }
+
         // Hybrid approach: Use X11/XWayland to get key state even on Wayland
         // XWayland provides key state to X11 clients
         if (Internal::HasX11Display())
@@ -42,18 +142,36 @@ namespace CrossInput
             return X11Impl::IsKeyPressed(key);
         }
 
-        // Pure Wayland without X11 - cannot get key state
-        return false;
+        // Pure Wayland without X11 and without evdev access
+        return EvdevImpl::IsKeyPressed(key);
     }
 
     void KeyDown(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::KeyDown);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::KeyDown(key);
+            return;
+        }
+        if (backend == Backend::Daemon)
+        {
+            DaemonImpl::KeyDown(key);
+            return;
+        }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::KeyDown(key);
+            return;
+        }
+
         // Hybrid approach: On Wayland sessions, use libei for input simulation
 #ifdef CROSSINPUT_HAS_LIBEI
-        if (Internal::IsWayland() || Internal::IsWaylandSession())
+        if (backend == Backend::Wayland)
         {
-            WaylandImpl::KeyDown(key);
-            return;
+            if (WaylandImpl::KeyDown(key) || !fallBackToX11())
+                return;
         }
 #endif
 
@@ -62,12 +180,30 @@ namespace CrossInput
 
     void KeyUp(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::KeyUp);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::KeyUp(key);
+            return;
+        }
+        if (backend == Backend::Daemon)
+        {
+            DaemonImpl::KeyUp(key);
+            return;
+        }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::KeyUp(key);
+            return;
+        }
+
         // Hybrid approach: On Wayland sessions, use libei for input simulation
 #ifdef CROSSINPUT_HAS_LIBEI
-        if (Internal::IsWayland() || Internal::IsWaylandSession())
+        if (backend == Backend::Wayland)
         {
-            WaylandImpl::KeyUp(key);
-            return;
+            if (WaylandImpl::KeyUp(key) || !fallBackToX11())
+                return;
         }
 #endif
 
@@ -95,15 +231,74 @@ namespace CrossInput
         }
     }
 
-    void MouseButtonDown(MouseButton button)
+    void TypeText(std::string_view utf8)
     {
+        Internal::StatScope stat(StatOp::TypeText);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::TypeText(utf8);
+            return;
+        }
+        if (backend == Backend::Daemon)
+        {
+            DaemonImpl::TypeText(utf8);
+            return;
+        }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::TypeText(utf8);
+            return;
+        }
+
         // Hybrid approach: On Wayland sessions, use libei for input simulation
 #ifdef CROSSINPUT_HAS_LIBEI
-        if (Internal::IsWayland() || Internal::IsWaylandSession())
+        if (backend == Backend::Wayland)
+        {
+            if (WaylandImpl::TypeText(utf8) || !fallBackToX11())
+                return;
+        }
+#endif
+
+        X11Impl::TypeText(utf8);
+    }
+
+    bool PasteText(std::string_view utf8, const PasteOptions &options)
+    {
+        // The selection lives on the X server, so this works under XWayland
+        // whichever backend sends the Ctrl+V
+        if (activeBackend() == Backend::Null || !Internal::HasX11Display())
+            return false;
+        return X11Impl::PasteText(utf8, options);
+    }
+
+    void MouseButtonDown(MouseButton button)
+    {
+        Internal::StatScope stat(StatOp::MouseButtonDown);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::MouseButtonDown(button);
+            return;
+        }
+        if (backend == Backend::Daemon)
         {
-            WaylandImpl::MouseButtonDown(button);
+            DaemonImpl::MouseButtonDown(button);
             return;
         }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::MouseButtonDown(button);
+            return;
+        }
+
+        // Hybrid approach: On Wayland sessions, use libei for input simulation
+#ifdef CROSSINPUT_HAS_LIBEI
+        if (backend == Backend::Wayland)
+        {
+            if (WaylandImpl::MouseButtonDown(button) || !fallBackToX11())
+                return;
+        }
 #endif
 
         X11Impl::MouseButtonDown(button);
@@ -111,12 +306,30 @@ namespace CrossInput
 
     void MouseButtonUp(MouseButton button)
     {
+        Internal::StatScope stat(StatOp::MouseButtonUp);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::MouseButtonUp(button);
+            return;
+        }
+        if (backend == Backend::Daemon)
+        {
+            DaemonImpl::MouseButtonUp(button);
+            return;
+        }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::MouseButtonUp(button);
+            return;
+        }
+
         // Hybrid approach: On Wayland sessions, use libei for input simulation
 #ifdef CROSSINPUT_HAS_LIBEI
-        if (Internal::IsWayland() || Internal::IsWaylandSession())
+        if (backend == Backend::Wayland)
         {
-            WaylandImpl::MouseButtonUp(button);
-            return;
+            if (WaylandImpl::MouseButtonUp(button) || !fallBackToX11())
+                return;
         }
 #endif
 
@@ -131,6 +344,10 @@ namespace CrossInput
 
     Point GetCursorPosition()
     {
+        Internal::StatScope stat(StatOp::GetCursorPosition);
+        if (requestedBackend() == Backend::Null)
+            return NullImpl::GetCursorPosition();
+
         // Hybrid approach: Use X11/XWayland to get cursor position even on Wayland
         // This works because XWayland provides cursor position to X11 clients
         if (Internal::HasX11Display())
@@ -139,18 +356,37 @@ namespace CrossInput
         }
 
         // Pure Wayland without X11 - cannot get cursor position
+        Internal::markStatFailure();
         return Point{0, 0};
     }
 
     void SetCursorPosition(const Point &pos)
     {
+        Internal::StatScope stat(StatOp::SetCursorPosition);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::SetCursorPosition(pos);
+            return;
+        }
+        if (backend == Backend::Daemon)
+        {
+            DaemonImpl::SetCursorPosition(pos);
+            return;
+        }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::SetCursorPosition(pos);
+            return;
+        }
+
         // Hybrid approach: On Wayland sessions, use libei for cursor movement
         // (XWayland blocks XWarpPointer for security)
 #ifdef CROSSINPUT_HAS_LIBEI
-        if (Internal::IsWayland() || Internal::IsWaylandSession())
+        if (backend == Backend::Wayland)
         {
-            WaylandImpl::SetCursorPosition(pos);
-            return;
+            if (WaylandImpl::SetCursorPosition(pos) || !fallBackToX11())
+                return;
         }
 #endif
 
@@ -159,18 +395,177 @@ namespace CrossInput
 
     void MoveCursor(int dx, int dy)
     {
+        Internal::StatScope stat(StatOp::MoveCursor);
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+        {
+            NullImpl::MoveCursor(dx, dy);
+            return;
+        }
+        if (backend == Backend::Daemon)
+        {
+            DaemonImpl::MoveCursor(dx, dy);
+            return;
+        }
+        if (backend == Backend::Uinput)
+        {
+            UinputImpl::MoveCursor(dx, dy);
+            return;
+        }
+
         // Hybrid approach: On Wayland sessions, use libei for cursor movement
 #ifdef CROSSINPUT_HAS_LIBEI
-        if (Internal::IsWayland() || Internal::IsWaylandSession())
+        if (backend == Backend::Wayland)
         {
-            WaylandImpl::MoveCursor(dx, dy);
-            return;
+            if (WaylandImpl::MoveCursor(dx, dy) || !fallBackToX11())
+                return;
         }
 #endif
 
         X11Impl::MoveCursor(dx, dy);
     }
 
+    bool Sync(int timeoutMs)
+    {
+        Backend backend = activeBackend();
+        if (backend == Backend::Null)
+            return true;
+        if (backend == Backend::Daemon)
+            return DaemonImpl::Sync(timeoutMs);
+        if (backend == Backend::Uinput)
+        {
+            // write() returns once the kernel has queued the events; whoever
+            // reads the device offers no acknowledgement
+            return true;
+        }
+
+#ifdef CROSSINPUT_HAS_LIBEI
+        if (backend == Backend::Wayland)
+        {
+            // Without a libei connection this thread's calls fell back to XTest,
+            // so the X server's round trip is the one to wait for
+            if (!WaylandImpl::Connected() && WaylandImpl::FallbackToX11())
+                return X11Impl::Sync();
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            if (!WaylandImpl::Sync(timeoutMs))
+                return false;
+
+            // The compositor has the motion, but XWayland learns of it
+            // asynchronously. Wait until X11 clients see the cursor there too.
+            Point target;
+            if (!WaylandImpl::TakeCursorTarget(target) || !Internal::HasX11Display())
+                return true;
+            for (;;)
+            {
+                Point pos = X11Impl::GetCursorPosition();
+                if (pos.x == target.x && pos.y == target.y)
+                    return true;
+                if (std::chrono::steady_clock::now() >= deadline)
+                    return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+#else
+        (void)timeoutMs;
+#endif
+
+        return X11Impl::Sync();
+    }
+
+    void SetReconnectPolicy(const ReconnectPolicy &policy)
+    {
+#ifdef CROSSINPUT_HAS_LIBEI
+        WaylandImpl::SetReconnectPolicy(policy);
+#else
+        (void)policy;
+#endif
+    }
+
+    bool UseEisConnection(int fd)
+    {
+#ifdef CROSSINPUT_HAS_LIBEI
+        if (fd < 0)
+            return false;
+        WaylandImpl::UseEisConnection(fd);
+        return true;
+#else
+        (void)fd;
+        return false;
+#endif
+    }
+
+    namespace Internal
+    {
+        bool openBackend(Backend backend)
+        {
+            switch (backend)
+            {
+            case Backend::X11:
+                return HasX11Display();
+            case Backend::Wayland:
+#ifdef CROSSINPUT_HAS_LIBEI
+                return true;
+#else
+                return false;
+#endif
+            case Backend::Uinput:
+                return UinputImpl::Open();
+            case Backend::Null:
+                NullImpl::Open();
+                return true;
+            case Backend::Daemon:
+                return DaemonImpl::Connect(DefaultDaemonSocket());
+            default:
+                return true;
+            }
+        }
+
+        void setThreadBackend(Backend backend)
+        {
+            t_threadBackend = backend;
+            t_hasThreadBackend = true;
+        }
+
+        std::shared_ptr<const PreparedSequence> prepareSequence(Backend backend, const InputEvent *events,
+                                                                size_t count)
+        {
+            // libei, the daemon and the Null backend take events one by one
+            switch (backend)
+            {
+            case Backend::X11:
+                return X11Impl::Prepare(events, count);
+            case Backend::Uinput:
+                return UinputImpl::Prepare(events, count);
+            default:
+                return nullptr;
+            }
+        }
+    } // namespace Internal
+
+    bool SetBackend(Backend backend)
+    {
+        if (!Internal::openBackend(backend))
+            return false;
+
+        g_backend.store(backend, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool ConnectDaemon(const std::string &socketPath)
+    {
+        if (!DaemonImpl::Connect(socketPath))
+            return false;
+
+        g_backend.store(Backend::Daemon, std::memory_order_relaxed);
+        return true;
+    }
+
+    Backend GetBackend()
+    {
+        return activeBackend();
+    }
+
     std::string GetPlatformName()
     {
         if (Internal::IsWayland() || Internal::IsWaylandSession())
@@ -3,6 +3,8 @@
 #ifdef CROSSINPUT_LINUX
 
 #include "../../../include/CrossInput.h"
+#include "../../core/text_input.h"
+#include "../keycode_table.h"
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
 
@@ -81,6 +83,7 @@ namespace EvdevCodes
     constexpr unsigned int EVDEV_KEY_LEFTSHIFT = 42;
     constexpr unsigned int EVDEV_KEY_LEFTCTRL = 29;
     constexpr unsigned int EVDEV_KEY_LEFTALT = 56;
+    constexpr unsigned int EVDEV_KEY_RIGHTALT = 100;
     constexpr unsigned int EVDEV_KEY_CAPSLOCK = 58;
     constexpr unsigned int EVDEV_KEY_BACKSPACE = 14;
     constexpr unsigned int EVDEV_KEY_DELETE = 111;
@@ -99,6 +102,11 @@ namespace EvdevCodes
     constexpr unsigned int EVDEV_KEY_APOSTROPHE = 40;
     constexpr unsigned int EVDEV_KEY_SLASH = 53;
     constexpr unsigned int EVDEV_KEY_BACKSLASH = 43;
+    constexpr unsigned int EVDEV_KEY_MINUS = 12;
+    constexpr unsigned int EVDEV_KEY_EQUAL = 13;
+    constexpr unsigned int EVDEV_KEY_LEFTBRACE = 26;
+    constexpr unsigned int EVDEV_KEY_RIGHTBRACE = 27;
+    constexpr unsigned int EVDEV_KEY_GRAVE = 41;
 
     // Mouse buttons
     constexpr unsigned int EVDEV_BTN_LEFT = 0x110;
@@ -111,164 +119,24 @@ namespace CrossInput
     namespace Internal
     {
 
+#define CROSSINPUT_X11_KEYSYM_COLUMN(name, keysym, evdev, vk, mac) static_cast<unsigned long>(keysym),
+        constexpr std::array<unsigned long, kKeyCodeCount> kX11Keysyms = {
+            CROSSINPUT_KEYCODE_TABLE(CROSSINPUT_X11_KEYSYM_COLUMN)};
+#undef CROSSINPUT_X11_KEYSYM_COLUMN
+
+        constexpr auto kX11KeysymToKeyCode = makeReverseKeyMap<512>(kX11Keysyms, 0UL);
+        static_assert(kX11KeysymToKeyCode.collisionFree, "X11 keysym reverse map needs more buckets");
+
         // Linux (X11): Maps CrossInput::KeyCode to X11 KeySym
         inline unsigned long keycode_to_x11_keysym(KeyCode key)
         {
-            switch (key)
-            {
-            // Alphanumeric Keys (a-z lowercase KeySyms)
-            case KeyCode::KEY_A:
-                return XK_a;
-            case KeyCode::KEY_B:
-                return XK_b;
-            case KeyCode::KEY_C:
-                return XK_c;
-            case KeyCode::KEY_D:
-                return XK_d;
-            case KeyCode::KEY_E:
-                return XK_e;
-            case KeyCode::KEY_F:
-                return XK_f;
-            case KeyCode::KEY_G:
-                return XK_g;
-            case KeyCode::KEY_H:
-                return XK_h;
-            case KeyCode::KEY_I:
-                return XK_i;
-            case KeyCode::KEY_J:
-                return XK_j;
-            case KeyCode::KEY_K:
-                return XK_k;
-            case KeyCode::KEY_L:
-                return XK_l;
-            case KeyCode::KEY_M:
-                return XK_m;
-            case KeyCode::KEY_N:
-                return XK_n;
-            case KeyCode::KEY_O:
-                return XK_o;
-            case KeyCode::KEY_P:
-                return XK_p;
-            case KeyCode::KEY_Q:
-                return XK_q;
-            case KeyCode::KEY_R:
-                return XK_r;
-            case KeyCode::KEY_S:
-                return XK_s;
-            case KeyCode::KEY_T:
-                return XK_t;
-            case KeyCode::KEY_U:
-                return XK_u;
-            case KeyCode::KEY_V:
-                return XK_v;
-            case KeyCode::KEY_W:
-                return XK_w;
-            case KeyCode::KEY_X:
-                return XK_x;
-            case KeyCode::KEY_Y:
-                return XK_y;
-            case KeyCode::KEY_Z:
-                return XK_z;
-
-            // Number Keys (0-9)
-            case KeyCode::KEY_0:
-                return XK_0;
-            case KeyCode::KEY_1:
-                return XK_1;
-            case KeyCode::KEY_2:
-                return XK_2;
-            case KeyCode::KEY_3:
-                return XK_3;
-            case KeyCode::KEY_4:
-                return XK_4;
-            case KeyCode::KEY_5:
-                return XK_5;
-            case KeyCode::KEY_6:
-                return XK_6;
-            case KeyCode::KEY_7:
-                return XK_7;
-            case KeyCode::KEY_8:
-                return XK_8;
-            case KeyCode::KEY_9:
-                return XK_9;
-
-            // Function Keys (F1-F12)
-            case KeyCode::KEY_F1:
-                return XK_F1;
-            case KeyCode::KEY_F2:
-                return XK_F2;
-            case KeyCode::KEY_F3:
-                return XK_F3;
-            case KeyCode::KEY_F4:
-                return XK_F4;
-            case KeyCode::KEY_F5:
-                return XK_F5;
-            case KeyCode::KEY_F6:
-                return XK_F6;
-            case KeyCode::KEY_F7:
-                return XK_F7;
-            case KeyCode::KEY_F8:
-                return XK_F8;
-            case KeyCode::KEY_F9:
-                return XK_F9;
-            case KeyCode::KEY_F10:
-                return XK_F10;
-            case KeyCode::KEY_F11:
-                return XK_F11;
-            case KeyCode::KEY_F12:
-                return XK_F12;
-
-            // Control Keys
-            case KeyCode::KEY_ESCAPE:
-                return XK_Escape;
-            case KeyCode::KEY_SPACE:
-                return XK_space;
-            case KeyCode::KEY_ENTER:
-                return XK_Return;
-            case KeyCode::KEY_TAB:
-                return XK_Tab;
-            case KeyCode::KEY_SHIFT:
-                return XK_Shift_L;
-            case KeyCode::KEY_CONTROL:
-                return XK_Control_L;
-            case KeyCode::KEY_ALT:
-                return XK_Alt_L;
-            case KeyCode::KEY_CAPS_LOCK:
-                return XK_Caps_Lock;
-            case KeyCode::KEY_BACKSPACE:
-                return XK_BackSpace;
-            case KeyCode::KEY_DELETE:
-                return XK_Delete;
-            case KeyCode::KEY_INSERT:
-                return XK_Insert;
-
-            // Arrow Keys
-            case KeyCode::KEY_LEFT:
-                return XK_Left;
-            case KeyCode::KEY_RIGHT:
-                return XK_Right;
-            case KeyCode::KEY_UP:
-                return XK_Up;
-            case KeyCode::KEY_DOWN:
-                return XK_Down;
-
-            // Symbol Keys
-            case KeyCode::KEY_COMMA:
-                return XK_comma;
-            case KeyCode::KEY_PERIOD:
-                return XK_period;
-            case KeyCode::KEY_SEMICOLON:
-                return XK_semicolon;
-            case KeyCode::KEY_APOSTROPHE:
-                return XK_apostrophe;
-            case KeyCode::KEY_SLASH:
-                return XK_slash;
-            case KeyCode::KEY_BACKSLASH:
-                return XK_backslash;
+            return lookupKeycode(kX11Keysyms, key, 0UL);
+        }
 
-            default:
-                return 0;
-            }
+        // Reverse of keycode_to_x11_keysym; false for keysyms with no KeyCode
+        inline bool x11_keysym_to_keycode(unsigned long keysym, KeyCode &out)
+        {
+            return keysym != 0 && kX11KeysymToKeyCode.lookup(keysym, out);
         }
 
         // Mouse button to X11 button code mapping
@@ -287,165 +155,25 @@ namespace CrossInput
             }
         }
 
+#define CROSSINPUT_EVDEV_COLUMN(name, keysym, evdev, vk, mac) EvdevCodes::evdev,
+        constexpr std::array<unsigned int, kKeyCodeCount> kEvdevCodes = {
+            CROSSINPUT_KEYCODE_TABLE(CROSSINPUT_EVDEV_COLUMN)};
+#undef CROSSINPUT_EVDEV_COLUMN
+
+        constexpr auto kEvdevToKeyCode = makeReverseKeyMap<128>(kEvdevCodes, 0U);
+        static_assert(kEvdevToKeyCode.collisionFree, "evdev reverse map needs more buckets");
+
         // Linux evdev keycode mapping for Wayland/libei
         // Maps CrossInput::KeyCode to Linux evdev keycodes (KEY_*)
         inline unsigned int keycode_to_evdev(KeyCode key)
         {
-            switch (key)
-            {
-            // Alphanumeric Keys (A-Z)
-            case KeyCode::KEY_A:
-                return EvdevCodes::EVDEV_KEY_A;
-            case KeyCode::KEY_B:
-                return EvdevCodes::EVDEV_KEY_B;
-            case KeyCode::KEY_C:
-                return EvdevCodes::EVDEV_KEY_C;
-            case KeyCode::KEY_D:
-                return EvdevCodes::EVDEV_KEY_D;
-            case KeyCode::KEY_E:
-                return EvdevCodes::EVDEV_KEY_E;
-            case KeyCode::KEY_F:
-                return EvdevCodes::EVDEV_KEY_F;
-            case KeyCode::KEY_G:
-                return EvdevCodes::EVDEV_KEY_G;
-            case KeyCode::KEY_H:
-                return EvdevCodes::EVDEV_KEY_H;
-            case KeyCode::KEY_I:
-                return EvdevCodes::EVDEV_KEY_I;
-            case KeyCode::KEY_J:
-                return EvdevCodes::EVDEV_KEY_J;
-            case KeyCode::KEY_K:
-                return EvdevCodes::EVDEV_KEY_K;
-            case KeyCode::KEY_L:
-                return EvdevCodes::EVDEV_KEY_L;
-            case KeyCode::KEY_M:
-                return EvdevCodes::EVDEV_KEY_M;
-            case KeyCode::KEY_N:
-                return EvdevCodes::EVDEV_KEY_N;
-            case KeyCode::KEY_O:
-                return EvdevCodes::EVDEV_KEY_O;
-            case KeyCode::KEY_P:
-                return EvdevCodes::EVDEV_KEY_P;
-            case KeyCode::KEY_Q:
-                return EvdevCodes::EVDEV_KEY_Q;
-            case KeyCode::KEY_R:
-                return EvdevCodes::EVDEV_KEY_R;
-            case KeyCode::KEY_S:
-                return EvdevCodes::EVDEV_KEY_S;
-            case KeyCode::KEY_T:
-                return EvdevCodes::EVDEV_KEY_T;
-            case KeyCode::KEY_U:
-                return EvdevCodes::EVDEV_KEY_U;
-            case KeyCode::KEY_V:
-                return EvdevCodes::EVDEV_KEY_V;
-            case KeyCode::KEY_W:
-                return EvdevCodes::EVDEV_KEY_W;
-            case KeyCode::KEY_X:
-                return EvdevCodes::EVDEV_KEY_X;
-            case KeyCode::KEY_Y:
-                return EvdevCodes::EVDEV_KEY_Y;
-            case KeyCode::KEY_Z:
-                return EvdevCodes::EVDEV_KEY_Z;
-
-            // Number Keys (0-9)
-            case KeyCode::KEY_0:
-                return EvdevCodes::EVDEV_KEY_0;
-            case KeyCode::KEY_1:
-                return EvdevCodes::EVDEV_KEY_1;
-            case KeyCode::KEY_2:
-                return EvdevCodes::EVDEV_KEY_2;
-            case KeyCode::KEY_3:
-                return EvdevCodes::EVDEV_KEY_3;
-            case KeyCode::KEY_4:
-                return EvdevCodes::EVDEV_KEY_4;
-            case KeyCode::KEY_5:
-                return EvdevCodes::EVDEV_KEY_5;
-            case KeyCode::KEY_6:
-                return EvdevCodes::EVDEV_KEY_6;
-            case KeyCode::KEY_7:
-                return EvdevCodes::EVDEV_KEY_7;
-            case KeyCode::KEY_8:
-                return EvdevCodes::EVDEV_KEY_8;
-            case KeyCode::KEY_9:
-                return EvdevCodes::EVDEV_KEY_9;
-
-            // Function Keys (F1-F12)
-            case KeyCode::KEY_F1:
-                return EvdevCodes::EVDEV_KEY_F1;
-            case KeyCode::KEY_F2:
-                return EvdevCodes::EVDEV_KEY_F2;
-            case KeyCode::KEY_F3:
-                return EvdevCodes::EVDEV_KEY_F3;
-            case KeyCode::KEY_F4:
-                return EvdevCodes::EVDEV_KEY_F4;
-            case KeyCode::KEY_F5:
-                return EvdevCodes::EVDEV_KEY_F5;
-            case KeyCode::KEY_F6:
-                return EvdevCodes::EVDEV_KEY_F6;
-            case KeyCode::KEY_F7:
-                return EvdevCodes::EVDEV_KEY_F7;
-            case KeyCode::KEY_F8:
-                return EvdevCodes::EVDEV_KEY_F8;
-            case KeyCode::KEY_F9:
-                return EvdevCodes::EVDEV_KEY_F9;
-            case KeyCode::KEY_F10:
-                return EvdevCodes::EVDEV_KEY_F10;
-            case KeyCode::KEY_F11:
-                return EvdevCodes::EVDEV_KEY_F11;
-            case KeyCode::KEY_F12:
-                return EvdevCodes::EVDEV_KEY_F12;
-
-            // Control Keys
-            case KeyCode::KEY_ESCAPE:
-                return EvdevCodes::EVDEV_KEY_ESC;
-            case KeyCode::KEY_SPACE:
-                return EvdevCodes::EVDEV_KEY_SPACE;
-            case KeyCode::KEY_ENTER:
-                return EvdevCodes::EVDEV_KEY_ENTER;
-            case KeyCode::KEY_TAB:
-                return EvdevCodes::EVDEV_KEY_TAB;
-            case KeyCode::KEY_SHIFT:
-                return EvdevCodes::EVDEV_KEY_LEFTSHIFT;
-            case KeyCode::KEY_CONTROL:
-                return EvdevCodes::EVDEV_KEY_LEFTCTRL;
-            case KeyCode::KEY_ALT:
-                return EvdevCodes::EVDEV_KEY_LEFTALT;
-            case KeyCode::KEY_CAPS_LOCK:
-                return EvdevCodes::EVDEV_KEY_CAPSLOCK;
-            case KeyCode::KEY_BACKSPACE:
-                return EvdevCodes::EVDEV_KEY_BACKSPACE;
-            case KeyCode::KEY_DELETE:
-                return EvdevCodes::EVDEV_KEY_DELETE;
-            case KeyCode::KEY_INSERT:
-                return EvdevCodes::EVDEV_KEY_INSERT;
-
-            // Arrow Keys
-            case KeyCode::KEY_LEFT:
-                return EvdevCodes::EVDEV_KEY_LEFT;
-            case KeyCode::KEY_RIGHT:
-                return EvdevCodes::EVDEV_KEY_RIGHT;
-            case KeyCode::KEY_UP:
-                return EvdevCodes::EVDEV_KEY_UP;
-            case KeyCode::KEY_DOWN:
-                return EvdevCodes::EVDEV_KEY_DOWN;
-
-            // Symbol Keys
-            case KeyCode::KEY_COMMA:
-                return EvdevCodes::EVDEV_KEY_COMMA;
-            case KeyCode::KEY_PERIOD:
-                return EvdevCodes::EVDEV_KEY_DOT;
-            case KeyCode::KEY_SEMICOLON:
-                return EvdevCodes::EVDEV_KEY_SEMICOLON;
-            case KeyCode::KEY_APOSTROPHE:
-                return EvdevCodes::EVDEV_KEY_APOSTROPHE;
-            case KeyCode::KEY_SLASH:
-                return EvdevCodes::EVDEV_KEY_SLASH;
-            case KeyCode::KEY_BACKSLASH:
-                return EvdevCodes::EVDEV_KEY_BACKSLASH;
+            return lookupKeycode(kEvdevCodes, key, 0U);
+        }
 
-            default:
-                return 0;
-            }
+        // Reverse of keycode_to_evdev; false for codes with no KeyCode
+        inline bool evdev_to_keycode(unsigned int code, KeyCode &out)
+        {
+            return code != 0 && kEvdevToKeyCode.lookup(code, out);
         }
 
         // Mouse button to evdev button code mapping for Wayland
@@ -464,6 +192,63 @@ namespace CrossInput
             }
         }
 
+        // US QWERTY codepoint -> evdev keystroke table, used for text input when
+        // the compositor does not provide a keymap
+        inline void build_us_evdev_keystroke_table(KeystrokeTable &table)
+        {
+            using namespace EvdevCodes;
+            static const unsigned int letters[26] = {
+                EVDEV_KEY_A, EVDEV_KEY_B, EVDEV_KEY_C, EVDEV_KEY_D, EVDEV_KEY_E, EVDEV_KEY_F, EVDEV_KEY_G,
+                EVDEV_KEY_H, EVDEV_KEY_I, EVDEV_KEY_J, EVDEV_KEY_K, EVDEV_KEY_L, EVDEV_KEY_M, EVDEV_KEY_N,
+                EVDEV_KEY_O, EVDEV_KEY_P, EVDEV_KEY_Q, EVDEV_KEY_R, EVDEV_KEY_S, EVDEV_KEY_T, EVDEV_KEY_U,
+                EVDEV_KEY_V, EVDEV_KEY_W, EVDEV_KEY_X, EVDEV_KEY_Y, EVDEV_KEY_Z};
+            static const unsigned int digits[10] = {
+                EVDEV_KEY_0, EVDEV_KEY_1, EVDEV_KEY_2, EVDEV_KEY_3, EVDEV_KEY_4,
+                EVDEV_KEY_5, EVDEV_KEY_6, EVDEV_KEY_7, EVDEV_KEY_8, EVDEV_KEY_9};
+            static const char shiftedDigits[10] = {')', '!', '@', '#', '$', '%', '^', '&', '*', '('};
+
+            struct SymbolKey
+            {
+                char plain;
+                char shifted;
+                unsigned int code;
+            };
+            static const SymbolKey symbols[] = {
+                {'-', '_', EVDEV_KEY_MINUS},
+                {'=', '+', EVDEV_KEY_EQUAL},
+                {'[', '{', EVDEV_KEY_LEFTBRACE},
+                {']', '}', EVDEV_KEY_RIGHTBRACE},
+                {'\\', '|', EVDEV_KEY_BACKSLASH},
+                {';', ':', EVDEV_KEY_SEMICOLON},
+                {'\'', '"', EVDEV_KEY_APOSTROPHE},
+                {',', '<', EVDEV_KEY_COMMA},
+                {'.', '>', EVDEV_KEY_DOT},
+                {'/', '?', EVDEV_KEY_SLASH},
+                {'`', '~', EVDEV_KEY_GRAVE},
+            };
+
+            table.clear();
+            for (int i = 0; i < 26; ++i)
+            {
+                table.add(static_cast<char32_t>('a' + i), letters[i], 0);
+                table.add(static_cast<char32_t>('A' + i), letters[i], kModShift);
+            }
+            for (int i = 0; i < 10; ++i)
+            {
+                table.add(static_cast<char32_t>('0' + i), digits[i], 0);
+                table.add(static_cast<char32_t>(shiftedDigits[i]), digits[i], kModShift);
+            }
+            for (const auto &symbol : symbols)
+            {
+                table.add(static_cast<char32_t>(symbol.plain), symbol.code, 0);
+                table.add(static_cast<char32_t>(symbol.shifted), symbol.code, kModShift);
+            }
+            table.add(U' ', EVDEV_KEY_SPACE, 0);
+            table.add(U'\n', EVDEV_KEY_ENTER, 0);
+            table.add(U'\t', EVDEV_KEY_TAB, 0);
+            table.add(U'\b', EVDEV_KEY_BACKSPACE, 0);
+        }
+
     } // namespace Internal
 } // namespace CrossInput
 
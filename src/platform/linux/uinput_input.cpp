@@ -0,0 +1,267 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include "../../core/input_sequence.h"
+#include "../../core/stats.h"
+#include "../../core/trace.h"
+#include "evdev_device.h"
+#include "linux_keycodes.h"
+#include "x11_display.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace CrossInput
+{
+    namespace UinputImpl
+    {
+        namespace
+        {
+            using Internal::EvdevEvent;
+            using Internal::UinputDevice;
+
+            // Created once and kept for the life of the process: the compositor needs
+            // a moment to pick up a new device, so recreating it would drop events.
+            // Owners are guarded by the mutex; the hot path only loads the pointers.
+            std::mutex g_mutex;
+            std::unique_ptr<UinputDevice> g_inputOwner;
+            std::unique_ptr<UinputDevice> g_tabletOwner;
+            std::atomic<UinputDevice *> g_input{nullptr};
+            std::atomic<UinputDevice *> g_tablet{nullptr};
+
+            EvdevEvent keyEvent(unsigned int code, bool down)
+            {
+                return EvdevEvent{EvdevCodes::EVDEV_EV_KEY, static_cast<uint16_t>(code), down ? 1 : 0, 0};
+            }
+
+            // Writes one frame, timed and checked for GetStats
+            void submit(UinputDevice *device, const EvdevEvent *events, size_t count)
+            {
+                Internal::FlushTimer timer;
+                Internal::TraceScope trace("uinput", "Frame");
+                if (!device->writeFrame(events, count))
+                    Internal::markStatFailure();
+            }
+
+            void sendKey(unsigned int code, bool down)
+            {
+                UinputDevice *input = g_input.load(std::memory_order_acquire);
+                if (!input)
+                {
+                    Internal::markStatFailure();
+                    return;
+                }
+                if (code == 0)
+                    return;
+
+                EvdevEvent event = keyEvent(code, down);
+                submit(input, &event, 1);
+            }
+
+            // An InputSequence as serialized frames, one run per device in event
+            // order, so a sequence that only touches the keyboard and mouse
+            // device is a single write()
+            class PreparedUinputSequence : public Internal::PreparedSequence
+            {
+            public:
+                struct Run
+                {
+                    UinputDevice *device;
+                    Internal::EvdevFrames frames;
+                };
+
+                PreparedUinputSequence(std::vector<Run> runs, bool missingTablet)
+                    : runs_(std::move(runs)), missing_tablet_(missingTablet)
+                {
+                }
+
+                bool play() const override
+                {
+                    if (missing_tablet_)
+                        Internal::markStatFailure();
+                    for (const Run &run : runs_)
+                    {
+                        Internal::FlushTimer timer;
+                        Internal::TraceScope trace("uinput", "Frames");
+                        if (!run.device->writeFrames(run.frames))
+                            Internal::markStatFailure();
+                    }
+                    return true;
+                }
+
+            private:
+                std::vector<Run> runs_;
+                bool missing_tablet_;
+            };
+
+            const Internal::KeystrokeTable &usKeystrokeTable()
+            {
+                static const Internal::KeystrokeTable table = []
+                {
+                    Internal::KeystrokeTable t;
+                    Internal::build_us_evdev_keystroke_table(t);
+                    return t;
+                }();
+                return table;
+            }
+        } // namespace
+
+        bool Open()
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            if (g_inputOwner)
+                return true;
+
+            g_inputOwner = UinputDevice::createKeyboardMouse("CrossInput virtual input");
+            if (!g_inputOwner)
+                return false;
+
+            // Absolute positioning needs the screen size to scale against, which
+            // only X11 (or XWayland) can report
+            Internal::X11Display display;
+            if (display.isValid())
+            {
+                int screen = DefaultScreen(display.get());
+                g_tabletOwner = UinputDevice::createTablet("CrossInput virtual tablet",
+                                                           DisplayWidth(display.get(), screen),
+                                                           DisplayHeight(display.get(), screen));
+            }
+
+            g_tablet.store(g_tabletOwner.get(), std::memory_order_release);
+            g_input.store(g_inputOwner.get(), std::memory_order_release);
+            return true;
+        }
+
+        std::shared_ptr<const Internal::PreparedSequence> Prepare(const InputEvent *events, size_t count)
+        {
+            UinputDevice *input = g_input.load(std::memory_order_acquire);
+            UinputDevice *tablet = g_tablet.load(std::memory_order_acquire);
+            if (!input)
+                return nullptr;
+
+            std::vector<PreparedUinputSequence::Run> runs;
+            bool missingTablet = false;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const InputEvent &event = events[i];
+                UinputDevice *device = input;
+                EvdevEvent frame[2] = {};
+                size_t length = 1;
+                switch (event.type)
+                {
+                case EventType::KeyDown:
+                case EventType::KeyUp:
+                    frame[0] = keyEvent(Internal::keycode_to_evdev(event.key), event.type == EventType::KeyDown);
+                    break;
+                case EventType::MouseButtonDown:
+                case EventType::MouseButtonUp:
+                    frame[0] = keyEvent(Internal::mouse_button_to_evdev(event.button),
+                                        event.type == EventType::MouseButtonDown);
+                    break;
+                case EventType::SetCursorPosition:
+                    device = tablet;
+                    frame[0] = {EvdevCodes::EVDEV_EV_ABS, EvdevCodes::EVDEV_ABS_X, event.pos.x, 0};
+                    frame[1] = {EvdevCodes::EVDEV_EV_ABS, EvdevCodes::EVDEV_ABS_Y, event.pos.y, 0};
+                    length = 2;
+                    break;
+                case EventType::MoveCursor:
+                    frame[0] = {EvdevCodes::EVDEV_EV_REL, EvdevCodes::EVDEV_REL_X, event.pos.x, 0};
+                    frame[1] = {EvdevCodes::EVDEV_EV_REL, EvdevCodes::EVDEV_REL_Y, event.pos.y, 0};
+                    length = 2;
+                    break;
+                default:
+                    continue;
+                }
+
+                // Skipped for the same reasons the single calls skip them
+                if (!device)
+                {
+                    missingTablet = true;
+                    continue;
+                }
+                if (frame[0].type == EvdevCodes::EVDEV_EV_KEY && frame[0].code == 0)
+                    continue;
+                if (event.type == EventType::MoveCursor && event.pos.x == 0 && event.pos.y == 0)
+                    continue;
+
+                if (runs.empty() || runs.back().device != device)
+                    runs.push_back(PreparedUinputSequence::Run{device, {}});
+                runs.back().frames.append(frame, length);
+            }
+            return std::make_shared<PreparedUinputSequence>(std::move(runs), missingTablet);
+        }
+
+        void KeyDown(KeyCode key)
+        {
+            sendKey(Internal::keycode_to_evdev(key), true);
+        }
+
+        void KeyUp(KeyCode key)
+        {
+            sendKey(Internal::keycode_to_evdev(key), false);
+        }
+
+        void TypeText(std::string_view text)
+        {
+            // The kernel device has no keymap of its own; the compositor applies the
+            // active layout, so characters are resolved against US QWERTY
+            const uint32_t modifierCodes[Internal::kModifierCount] = {
+                EvdevCodes::EVDEV_KEY_LEFTSHIFT, EvdevCodes::EVDEV_KEY_RIGHTALT};
+            Internal::typeKeystrokes(
+                text, usKeystrokeTable(), modifierCodes,
+                [](uint32_t code, bool down)
+                { sendKey(code, down); },
+                [](char32_t)
+                { return Internal::Keystroke{0, 0, false}; });
+        }
+
+        void MouseButtonDown(MouseButton button)
+        {
+            sendKey(Internal::mouse_button_to_evdev(button), true);
+        }
+
+        void MouseButtonUp(MouseButton button)
+        {
+            sendKey(Internal::mouse_button_to_evdev(button), false);
+        }
+
+        void SetCursorPosition(const Point &pos)
+        {
+            // Without a tablet device (no X screen to size it) there is no absolute path
+            UinputDevice *tablet = g_tablet.load(std::memory_order_acquire);
+            if (!tablet)
+            {
+                Internal::markStatFailure();
+                return;
+            }
+
+            EvdevEvent frame[2] = {
+                {EvdevCodes::EVDEV_EV_ABS, EvdevCodes::EVDEV_ABS_X, pos.x, 0},
+                {EvdevCodes::EVDEV_EV_ABS, EvdevCodes::EVDEV_ABS_Y, pos.y, 0}};
+            submit(tablet, frame, 2);
+        }
+
+        void MoveCursor(int dx, int dy)
+        {
+            UinputDevice *input = g_input.load(std::memory_order_acquire);
+            if (!input)
+            {
+                Internal::markStatFailure();
+                return;
+            }
+            if (dx == 0 && dy == 0)
+                return;
+
+            // Relative motion goes through the compositor's pointer acceleration
+            EvdevEvent frame[2] = {
+                {EvdevCodes::EVDEV_EV_REL, EvdevCodes::EVDEV_REL_X, dx, 0},
+                {EvdevCodes::EVDEV_EV_REL, EvdevCodes::EVDEV_REL_Y, dy, 0}};
+            submit(input, frame, 2);
+        }
+
+    } // namespace UinputImpl
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
@@ -4,117 +4,345 @@
 #ifdef CROSSINPUT_HAS_LIBEI
 
 #include "../../../include/CrossInput.h"
+#include "../../core/stats.h"
+#include "../../core/trace.h"
 #include "linux_keycodes.h"
 #include "libei_context.h"
+#include "x11_keymap.h"
+#include "xkb_keymap.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <memory>
+#include <mutex>
 #include <poll.h>
-#include <cstdio>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace CrossInput
 {
     namespace WaylandImpl
     {
         // Thread-local libei context for performance (avoids reconnecting each call)
-        // Note: In production, you may want a more sophisticated connection management
         static thread_local std::unique_ptr<Internal::LibeiContext> s_libeiContext;
 
+        // Socket handed over by UseEisConnection, adopted by the next thread that injects
+        static std::atomic<int> s_pendingEisFd{-1};
+
+        // Connection failures are shared by all threads: a missing or denied
+        // portal fails the same way everywhere. Until s_retryAtNs (steady
+        // clock) no handshake is attempted; INT64_MAX once the budget is spent.
+        static std::mutex s_policyMutex;
+        static ReconnectPolicy s_policy;
+        static std::atomic<int> s_failures{0};
+        static std::atomic<int64_t> s_retryAtNs{0};
+
+        int64_t steadyNowNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void noteConnectFailure()
+        {
+            ReconnectPolicy policy;
+            {
+                std::lock_guard<std::mutex> lock(s_policyMutex);
+                policy = s_policy;
+            }
+
+            int failures = s_failures.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (policy.maxAttempts > 0 && failures >= policy.maxAttempts)
+            {
+                s_retryAtNs.store(INT64_MAX, std::memory_order_relaxed);
+                Internal::traceInstant("libei", "Connect abandoned", "attempts", failures);
+                fprintf(stderr, "CrossInput: libei unavailable after %d attempts, not retrying\n", failures);
+                return;
+            }
+
+            // initialBackoff * 2^(failures - 1), capped
+            std::chrono::milliseconds backoff = policy.initialBackoff;
+            for (int i = 1; i < failures && backoff < policy.maxBackoff; ++i)
+                backoff *= 2;
+            backoff = std::min(backoff, policy.maxBackoff);
+
+            s_retryAtNs.store(steadyNowNs() + std::chrono::nanoseconds(backoff).count(), std::memory_order_relaxed);
+            Internal::traceInstant("libei", "Connect failed", "retryMs", backoff.count());
+        }
+
+        // The calling thread's connection, or nullptr while libei is unavailable
         Internal::LibeiContext *getContext()
         {
-            if (!s_libeiContext || !s_libeiContext->isValid())
+            if (s_libeiContext && s_libeiContext->isValid() &&
+                s_pendingEisFd.load(std::memory_order_relaxed) < 0)
+                return s_libeiContext.get();
+
+            int fd = s_pendingEisFd.exchange(-1);
+            if (fd < 0)
+            {
+                // Backing off: fail in nanoseconds rather than repeat the handshake
+                if (steadyNowNs() < s_retryAtNs.load(std::memory_order_relaxed))
+                    return nullptr;
+                if (s_libeiContext)
+                    Internal::recordReconnect();
+            }
+
+            // Close the old connection before the new handshake
+            s_libeiContext.reset();
+            auto ctx = fd >= 0 ? std::make_unique<Internal::LibeiContext>(fd)
+                               : std::make_unique<Internal::LibeiContext>();
+            if (!ctx->isValid())
             {
-                s_libeiContext = std::make_unique<Internal::LibeiContext>();
+                noteConnectFailure();
+                return nullptr;
             }
+
+            s_failures.store(0, std::memory_order_relaxed);
+            s_retryAtNs.store(0, std::memory_order_relaxed);
+            s_libeiContext = std::move(ctx);
             return s_libeiContext.get();
         }
 
-        void KeyDown(KeyCode key)
+        bool FallbackToX11()
+        {
+            std::lock_guard<std::mutex> lock(s_policyMutex);
+            return s_policy.fallbackToX11;
+        }
+
+        void SetReconnectPolicy(const ReconnectPolicy &policy)
+        {
+            {
+                std::lock_guard<std::mutex> lock(s_policyMutex);
+                s_policy = policy;
+            }
+            s_failures.store(0, std::memory_order_relaxed);
+            s_retryAtNs.store(0, std::memory_order_relaxed);
+        }
+
+        // Where the last absolute motion put the cursor, until Sync sees XWayland report it
+        static thread_local bool s_cursorPending = false;
+        static thread_local Point s_cursorTarget{0, 0};
+
+        // Closes the current emulation frame
+        void emitFrame(ei_device *device, Internal::LibeiContext *ctx)
+        {
+            Internal::traceInstant("libei", "Frame");
+            ei_device_frame(device, ei_now(ctx->get()));
+        }
+
+        // Keystroke table for the current keyboard device, compiled from the
+        // XKB keymap EIS sent with it. Rebuilt only when the device's keymap
+        // object changes (libei re-adds the device when the layout changes);
+        // the reference held here keeps a freed keymap's address from being reused.
+        struct KeymapCache
+        {
+            ei_keymap *keymap = nullptr;
+            bool ready = false;
+            Internal::KeystrokeTable table;
+
+            ~KeymapCache()
+            {
+                if (keymap)
+                    ei_keymap_unref(keymap);
+            }
+        };
+        static thread_local KeymapCache s_keymapCache;
+
+        // Copy of the last table compiled from an EIS keymap on any thread, for
+        // IsKeyPressed, which reads evdev nodes from whichever thread asks
+        static std::mutex s_layoutMutex;
+        static std::shared_ptr<const Internal::KeystrokeTable> s_layoutTable;
+
+        const Internal::KeystrokeTable &getKeystrokeTable(ei_device *kbd)
+        {
+            ei_keymap *keymap = ei_device_keyboard_get_keymap(kbd);
+            if (s_keymapCache.ready && keymap == s_keymapCache.keymap)
+                return s_keymapCache.table;
+
+            if (s_keymapCache.keymap)
+                ei_keymap_unref(s_keymapCache.keymap);
+            s_keymapCache.keymap = keymap ? ei_keymap_ref(keymap) : nullptr;
+
+            bool built = false;
+#ifdef CROSSINPUT_HAS_XKBCOMMON
+            if (keymap && ei_keymap_get_type(keymap) == EI_KEYMAP_TYPE_XKB)
+            {
+                size_t size = ei_keymap_get_size(keymap);
+                void *buffer = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, ei_keymap_get_fd(keymap), 0);
+                if (buffer != MAP_FAILED)
+                {
+                    built = Internal::build_xkb_keystroke_table(static_cast<const char *>(buffer), size,
+                                                                s_keymapCache.table);
+                    munmap(buffer, size);
+                }
+            }
+#endif
+            // No keymap from EIS (or no xkbcommon): assume US QWERTY
+            if (!built)
+                Internal::build_us_evdev_keystroke_table(s_keymapCache.table);
+
+            std::shared_ptr<const Internal::KeystrokeTable> shared;
+            if (built)
+                shared = std::make_shared<const Internal::KeystrokeTable>(s_keymapCache.table);
+            {
+                std::lock_guard<std::mutex> lock(s_layoutMutex);
+                s_layoutTable = std::move(shared);
+            }
+
+            s_keymapCache.ready = true;
+            return s_keymapCache.table;
+        }
+
+        // evdev code for a KeyCode under the active layout: keys that type a
+        // character are found by that character, the rest use the fixed mapping
+        unsigned int resolveEvdev(const Internal::KeystrokeTable &table, KeyCode key)
+        {
+            char32_t cp = Internal::x11_keysym_to_codepoint(Internal::keycode_to_x11_keysym(key));
+            if (cp != 0)
+            {
+                Internal::Keystroke stroke = table.lookup(cp);
+                if (stroke.valid)
+                    return stroke.code;
+            }
+            return Internal::keycode_to_evdev(key);
+        }
+
+        unsigned int resolveEvdev(ei_device *kbd, KeyCode key)
+        {
+            return resolveEvdev(getKeystrokeTable(kbd), key);
+        }
+
+        bool LayoutEvdevCode(KeyCode key, unsigned int &code)
+        {
+            std::shared_ptr<const Internal::KeystrokeTable> table;
+            {
+                std::lock_guard<std::mutex> lock(s_layoutMutex);
+                table = s_layoutTable;
+            }
+            if (!table)
+                return false;
+            code = resolveEvdev(*table, key);
+            return true;
+        }
+
+        // The injecting functions return false when libei is unavailable, so
+        // the caller can fall back; anything else counts as handled
+        bool KeyDown(KeyCode key)
         {
             auto *ctx = getContext();
             if (!ctx || !ctx->isValid() || !ctx->hasKeyboard())
-                return;
+                return false;
 
-            unsigned int evdevCode = Internal::keycode_to_evdev(key);
+            ei_device *kbd = ctx->getKeyboard();
+            unsigned int evdevCode = resolveEvdev(kbd, key);
             if (evdevCode == 0)
-                return;
+                return true;
 
-            ei_device *kbd = ctx->getKeyboard();
             ei_device_start_emulating(kbd, 0);
             ei_device_keyboard_key(kbd, evdevCode, true);
-            ei_device_frame(kbd, ei_now(ctx->get()));
+            emitFrame(kbd, ctx);
             ei_device_stop_emulating(kbd);
             ctx->dispatch();
+            return true;
         }
 
-        void KeyUp(KeyCode key)
+        bool KeyUp(KeyCode key)
         {
             auto *ctx = getContext();
             if (!ctx || !ctx->isValid() || !ctx->hasKeyboard())
-                return;
+                return false;
 
-            unsigned int evdevCode = Internal::keycode_to_evdev(key);
+            ei_device *kbd = ctx->getKeyboard();
+            unsigned int evdevCode = resolveEvdev(kbd, key);
             if (evdevCode == 0)
-                return;
+                return true;
 
-            ei_device *kbd = ctx->getKeyboard();
             ei_device_start_emulating(kbd, 0);
             ei_device_keyboard_key(kbd, evdevCode, false);
-            ei_device_frame(kbd, ei_now(ctx->get()));
+            emitFrame(kbd, ctx);
+            ei_device_stop_emulating(kbd);
+            ctx->dispatch();
+            return true;
+        }
+
+        bool TypeText(std::string_view text)
+        {
+            auto *ctx = getContext();
+            if (!ctx || !ctx->isValid() || !ctx->hasKeyboard())
+                return false;
+
+            ei_device *kbd = ctx->getKeyboard();
+            const Internal::KeystrokeTable &table = getKeystrokeTable(kbd);
+            const uint32_t modifierCodes[Internal::kModifierCount] = {
+                EvdevCodes::EVDEV_KEY_LEFTSHIFT, EvdevCodes::EVDEV_KEY_RIGHTALT};
+
+            // One emulation session and one dispatch for the whole text;
+            // each key event still gets its own frame
+            ei_device_start_emulating(kbd, 0);
+            Internal::typeKeystrokes(
+                text, table, modifierCodes,
+                [&](uint32_t code, bool down)
+                {
+                    ei_device_keyboard_key(kbd, code, down);
+                    emitFrame(kbd, ctx);
+                },
+                [](char32_t)
+                { return Internal::Keystroke{0, 0, false}; });
             ei_device_stop_emulating(kbd);
             ctx->dispatch();
+            return true;
         }
 
-        void MouseButtonDown(MouseButton button)
+        bool MouseButtonDown(MouseButton button)
         {
             auto *ctx = getContext();
             if (!ctx || !ctx->isValid() || !ctx->hasPointer())
-                return;
+                return false;
 
             unsigned int evdevButton = Internal::mouse_button_to_evdev(button);
             if (evdevButton == 0)
-                return;
+                return true;
 
             ei_device *ptr = ctx->getPointer();
             ei_device_start_emulating(ptr, 0);
             ei_device_button_button(ptr, evdevButton, true);
-            ei_device_frame(ptr, ei_now(ctx->get()));
+            emitFrame(ptr, ctx);
             ei_device_stop_emulating(ptr);
             ctx->dispatch();
+            return true;
         }
 
-        void MouseButtonUp(MouseButton button)
+        bool MouseButtonUp(MouseButton button)
         {
             auto *ctx = getContext();
             if (!ctx || !ctx->isValid() || !ctx->hasPointer())
-                return;
+                return false;
 
             unsigned int evdevButton = Internal::mouse_button_to_evdev(button);
             if (evdevButton == 0)
-                return;
+                return true;
 
             ei_device *ptr = ctx->getPointer();
             ei_device_start_emulating(ptr, 0);
             ei_device_button_button(ptr, evdevButton, false);
-            ei_device_frame(ptr, ei_now(ctx->get()));
+            emitFrame(ptr, ctx);
             ei_device_stop_emulating(ptr);
             ctx->dispatch();
+            return true;
         }
 
-        void SetCursorPosition(const Point &pos)
+        bool SetCursorPosition(const Point &pos)
         {
             auto *ctx = getContext();
             if (!ctx || !ctx->isValid() || !ctx->hasPointer())
-            {
-                fprintf(stderr, "CrossInput: SetCursorPosition - invalid context or no pointer\n");
-                return;
-            }
+                return false;
 
             ei_device *ptr = ctx->getPointer();
 
             // Check if device supports absolute positioning
             if (ei_device_has_capability(ptr, EI_DEVICE_CAP_POINTER_ABSOLUTE))
             {
-                fprintf(stderr, "CrossInput: Moving to absolute position (%d, %d)\n", pos.x, pos.y);
-
                 // Get the region to verify coordinates
                 struct ei_region *region = ei_device_get_region(ptr, 0);
                 if (region)
@@ -139,8 +367,11 @@ namespace CrossInput
 
                     ei_device_start_emulating(ptr, 0);
                     ei_device_pointer_motion_absolute(ptr, x, y);
-                    ei_device_frame(ptr, ei_now(ctx->get()));
+                    emitFrame(ptr, ctx);
                     ei_device_stop_emulating(ptr);
+                    // Only the portal's compositor is known to drive this display's XWayland
+                    s_cursorPending = ctx->fromPortal();
+                    s_cursorTarget = Point{static_cast<int>(x), static_cast<int>(y)};
 
                     // Ensure events are sent
                     int fd = ei_get_fd(ctx->get());
@@ -151,12 +382,13 @@ namespace CrossInput
                 }
                 else
                 {
-                    fprintf(stderr, "CrossInput: No region available\n");
+                    Internal::markStatFailure();
+                    Internal::traceInstant("libei", "No region for absolute motion");
                 }
             }
             else if (ei_device_has_capability(ptr, EI_DEVICE_CAP_POINTER))
             {
-                fprintf(stderr, "CrossInput: No absolute cap, using relative fallback\n");
+                Internal::traceInstant("libei", "Relative fallback for absolute motion");
                 // Relative motion only - we need to track our own position
                 static int last_x = 0, last_y = 0;
                 static bool initialized = false;
@@ -167,7 +399,7 @@ namespace CrossInput
                     last_x = pos.x;
                     last_y = pos.y;
                     initialized = true;
-                    return;
+                    return true;
                 }
 
                 int dx = pos.x - last_x;
@@ -179,7 +411,7 @@ namespace CrossInput
                     ei_device_pointer_motion(ptr,
                                              static_cast<double>(dx),
                                              static_cast<double>(dy));
-                    ei_device_frame(ptr, ei_now(ctx->get()));
+                    emitFrame(ptr, ctx);
                     ei_device_stop_emulating(ptr);
                     ctx->dispatch();
 
@@ -189,18 +421,21 @@ namespace CrossInput
             }
             else
             {
-                fprintf(stderr, "CrossInput: No pointer capability available!\n");
+                Internal::markStatFailure();
+                Internal::traceInstant("libei", "No pointer capability");
             }
+            return true;
         }
 
         // New function for relative mouse movement
-        void MoveCursor(int dx, int dy)
+        bool MoveCursor(int dx, int dy)
         {
             auto *ctx = getContext();
             if (!ctx || !ctx->isValid() || !ctx->hasPointer())
-                return;
+                return false;
 
             ei_device *ptr = ctx->getPointer();
+            s_cursorPending = false;
 
             // Try relative movement first
             if (ei_device_has_capability(ptr, EI_DEVICE_CAP_POINTER))
@@ -209,10 +444,10 @@ namespace CrossInput
                 ei_device_pointer_motion(ptr,
                                          static_cast<double>(dx),
                                          static_cast<double>(dy));
-                ei_device_frame(ptr, ei_now(ctx->get()));
+                emitFrame(ptr, ctx);
                 ei_device_stop_emulating(ptr);
                 ctx->dispatch();
-                return;
+                return true;
             }
 
             // Fall back to absolute positioning if only that's available
@@ -220,7 +455,7 @@ namespace CrossInput
             {
                 struct ei_region *region = ei_device_get_region(ptr, 0);
                 if (!region)
-                    return;
+                    return true;
 
                 // We need to track position ourselves for relative movement
                 static double current_x = -1, current_y = -1;
@@ -255,10 +490,40 @@ namespace CrossInput
 
                 ei_device_start_emulating(ptr, 0);
                 ei_device_pointer_motion_absolute(ptr, current_x, current_y);
-                ei_device_frame(ptr, ei_now(ctx->get()));
+                emitFrame(ptr, ctx);
                 ei_device_stop_emulating(ptr);
                 ctx->dispatch();
             }
+            return true;
+        }
+
+        void UseEisConnection(int fd)
+        {
+            int previous = s_pendingEisFd.exchange(fd);
+            if (previous >= 0)
+                close(previous);
+        }
+
+        bool Connected()
+        {
+            return s_libeiContext && s_libeiContext->isValid();
+        }
+
+        bool Sync(int timeoutMs)
+        {
+            if (!Connected())
+                return true; // nothing sent on this thread
+
+            return s_libeiContext->sync(timeoutMs);
+        }
+
+        bool TakeCursorTarget(Point &target)
+        {
+            if (!s_cursorPending)
+                return false;
+            s_cursorPending = false;
+            target = s_cursorTarget;
+            return true;
         }
 
     } // namespace WaylandImpl
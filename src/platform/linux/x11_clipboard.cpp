@@ -0,0 +1,659 @@
+#include "../../platform/platform_detect.h"
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../../include/CrossInput.h"
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include "dynamic_libs.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace CrossInput
+{
+    namespace X11Impl
+    {
+        namespace
+        {
+            using Clock = std::chrono::steady_clock;
+            using Text = std::shared_ptr<const std::string>;
+
+            // Incremental transfers whose requestor vanished are given up after this long
+            constexpr auto kTransferTimeout = std::chrono::seconds(10);
+            // Largest property written at once; bigger payloads go out as INCR
+            constexpr size_t kMaxChunk = 256 * 1024;
+
+            // Errors on the owner's connection (a requestor window destroyed
+            // mid-transfer) are expected; Xlib's default handler would exit
+            std::atomic<Display *> g_ownerDisplay{nullptr};
+            XErrorHandler g_previousErrorHandler = nullptr;
+
+            int ignoreOwnerErrors(Display *display, XErrorEvent *error)
+            {
+                if (display == g_ownerDisplay.load(std::memory_order_relaxed))
+                    return 0;
+                return g_previousErrorHandler ? g_previousErrorHandler(display, error) : 0;
+            }
+
+            // Owns CLIPBOARD (and optionally PRIMARY) on its own X connection
+            // and thread, answering SelectionRequests until another client
+            // takes the selection. Callers post commands; every X call happens
+            // on the thread.
+            class SelectionOwner
+            {
+            public:
+                // Started on first use; nullptr (retried next time) without an X display
+                static SelectionOwner *instance()
+                {
+                    static std::mutex mutex;
+                    static std::unique_ptr<SelectionOwner> owner;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!owner && Internal::x11Available())
+                    {
+                        std::unique_ptr<SelectionOwner> started(new SelectionOwner());
+                        if (started->display_)
+                            owner = std::move(started);
+                    }
+                    return owner.get();
+                }
+
+                ~SelectionOwner()
+                {
+                    if (thread_.joinable())
+                    {
+                        post(Command{Command::Stop, nullptr, false});
+                        thread_.join();
+                    }
+                    if (display_)
+                    {
+                        g_ownerDisplay.store(nullptr, std::memory_order_relaxed);
+                        XDestroyWindow(display_, window_);
+                        XCloseDisplay(display_);
+                    }
+                    if (wake_fd_ >= 0)
+                        close(wake_fd_);
+                }
+
+                // Takes the selections with `text`. Returns the generation to
+                // pass to waitForTransfer, or 0 if the server refused.
+                uint64_t own(Text text, bool primary, Clock::time_point deadline)
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    uint64_t generation = ++requested_generation_;
+                    commands_.push_back(Command{Command::Own, std::move(text), primary});
+                    wake();
+                    cond_.wait_until(lock, deadline, [&]
+                                     { return owned_generation_ >= generation; });
+                    return owned_generation_ == generation && owned_ ? generation : 0;
+                }
+
+                // Gives up both selections, leaving the clipboard empty
+                void release()
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    commands_.push_back(Command{Command::Release, nullptr, false});
+                    wake();
+                }
+
+                // Call right before the paste keystroke. Takes a server
+                // timestamp and the focused window; from then on only CLIPBOARD
+                // transfers requested at or after that time, or by the focused
+                // window's toplevel, count for waitForPaste. Clipboard managers
+                // copy the text whenever they get to it and must not count.
+                bool armPaste(Clock::time_point deadline)
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    uint64_t request = ++arm_requested_;
+                    commands_.push_back(Command{Command::Arm, nullptr, false});
+                    wake();
+                    return cond_.wait_until(lock, deadline, [&]
+                                            { return armed_ >= request; });
+                }
+
+                // Waits until the paste armed for `generation` has fetched the text in full
+                bool waitForPaste(uint64_t generation, Clock::time_point deadline)
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    return cond_.wait_until(lock, deadline, [&]
+                                            { return pasted_generation_ == generation && pasted_; });
+                }
+
+                // Reads the clipboard's current text. False if it is empty,
+                // holds no text, or its owner did not answer in time.
+                bool fetchClipboard(std::string &out, Clock::time_point deadline)
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    uint64_t request = ++fetch_requested_;
+                    commands_.push_back(Command{Command::Fetch, nullptr, false});
+                    wake();
+                    bool done = cond_.wait_until(lock, deadline, [&]
+                                                 { return fetch_completed_ >= request; });
+                    if (!done || fetch_completed_ != request || !fetch_ok_)
+                    {
+                        fetch_abandoned_ = request;
+                        return false;
+                    }
+                    out.swap(fetch_result_);
+                    return true;
+                }
+
+                SelectionOwner(const SelectionOwner &) = delete;
+                SelectionOwner &operator=(const SelectionOwner &) = delete;
+
+            private:
+                struct Command
+                {
+                    enum Kind
+                    {
+                        Own,
+                        Release,
+                        Arm,
+                        Fetch,
+                        Stop
+                    } kind;
+                    Text text;
+                    bool primary;
+                };
+
+                // An INCR transfer in progress: the next chunk is written each
+                // time the requestor deletes the property
+                struct Transfer
+                {
+                    Window requestor;
+                    Atom property;
+                    Atom type;
+                    Text text;
+                    uint64_t generation;
+                    bool paste; // counts for waitForPaste once complete
+                    size_t offset;
+                    Clock::time_point started;
+                };
+
+                SelectionOwner()
+                    : display_(XOpenDisplay(nullptr)), wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+                {
+                    if (!display_)
+                        return;
+                    if (wake_fd_ < 0)
+                    {
+                        XCloseDisplay(display_);
+                        display_ = nullptr;
+                        return;
+                    }
+
+                    window_ = XCreateSimpleWindow(display_, DefaultRootWindow(display_), 0, 0, 1, 1, 0, 0, 0);
+                    XSelectInput(display_, window_, PropertyChangeMask);
+                    clipboard_ = XInternAtom(display_, "CLIPBOARD", False);
+                    targets_ = XInternAtom(display_, "TARGETS", False);
+                    utf8_ = XInternAtom(display_, "UTF8_STRING", False);
+                    text_plain_ = XInternAtom(display_, "text/plain;charset=utf-8", False);
+                    text_ = XInternAtom(display_, "TEXT", False);
+                    incr_ = XInternAtom(display_, "INCR", False);
+                    fetch_property_ = XInternAtom(display_, "CROSSINPUT_SELECTION", False);
+                    timestamp_property_ = XInternAtom(display_, "CROSSINPUT_TIMESTAMP", False);
+
+                    long maxRequest = XExtendedMaxRequestSize(display_);
+                    if (maxRequest == 0)
+                        maxRequest = XMaxRequestSize(display_);
+                    chunk_ = std::min(kMaxChunk, static_cast<size_t>(maxRequest) * 4 - 1024);
+
+                    g_ownerDisplay.store(display_, std::memory_order_relaxed);
+                    XErrorHandler previous = XSetErrorHandler(ignoreOwnerErrors);
+                    if (previous != ignoreOwnerErrors)
+                        g_previousErrorHandler = previous;
+                    XSync(display_, False);
+
+                    thread_ = std::thread([this]
+                                          { run(); });
+                }
+
+                void post(Command command)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    commands_.push_back(std::move(command));
+                    wake();
+                }
+
+                // Call with the mutex held
+                void wake()
+                {
+                    uint64_t one = 1;
+                    ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+                    (void)ignored;
+                }
+
+                void run()
+                {
+                    for (;;)
+                    {
+                        std::deque<Command> commands;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            commands.swap(commands_);
+                        }
+                        for (Command &command : commands)
+                        {
+                            if (command.kind == Command::Stop)
+                                return;
+                            execute(command);
+                        }
+
+                        // XPending also flushes whatever the commands queued
+                        while (XPending(display_) > 0)
+                        {
+                            XEvent event;
+                            XNextEvent(display_, &event);
+                            handle(event);
+                        }
+                        dropStaleTransfers();
+
+                        pollfd fds[2] = {{ConnectionNumber(display_), POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+                        poll(fds, 2, transfers_.empty() ? -1 : 1000);
+                        uint64_t value;
+                        ssize_t ignored = read(wake_fd_, &value, sizeof(value));
+                        (void)ignored;
+                    }
+                }
+
+                void execute(const Command &command)
+                {
+                    switch (command.kind)
+                    {
+                    case Command::Own:
+                    {
+                        text_owned_ = command.text;
+                        generation_owned_++;
+                        paste_armed_ = false;
+                        XSetSelectionOwner(display_, clipboard_, window_, CurrentTime);
+                        owns_clipboard_ = XGetSelectionOwner(display_, clipboard_) == window_;
+                        owns_primary_ = false;
+                        if (command.primary)
+                        {
+                            XSetSelectionOwner(display_, XA_PRIMARY, window_, CurrentTime);
+                            owns_primary_ = XGetSelectionOwner(display_, XA_PRIMARY) == window_;
+                        }
+
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        owned_generation_ = generation_owned_;
+                        owned_ = owns_clipboard_;
+                        cond_.notify_all();
+                        break;
+                    }
+                    case Command::Release:
+                        if (owns_clipboard_)
+                            XSetSelectionOwner(display_, clipboard_, None, CurrentTime);
+                        if (owns_primary_)
+                            XSetSelectionOwner(display_, XA_PRIMARY, None, CurrentTime);
+                        owns_clipboard_ = owns_primary_ = false;
+                        break;
+                    case Command::Arm:
+                        // Appending nothing still sends a PropertyNotify, which carries the server's time
+                        arm_pending_++;
+                        XChangeProperty(display_, window_, timestamp_property_, XA_INTEGER, 8, PropModeAppend,
+                                        nullptr, 0);
+                        break;
+                    case Command::Fetch:
+                        fetch_pending_++;
+                        fetch_incr_ = false;
+                        fetch_buffer_.clear();
+                        if (owns_clipboard_)
+                        {
+                            finishFetch(true, std::string(*text_owned_));
+                            break;
+                        }
+                        if (XGetSelectionOwner(display_, clipboard_) == None)
+                        {
+                            finishFetch(false, std::string());
+                            break;
+                        }
+                        XDeleteProperty(display_, window_, fetch_property_);
+                        XConvertSelection(display_, clipboard_, utf8_, fetch_property_, window_, CurrentTime);
+                        fetch_active_ = true;
+                        break;
+                    case Command::Stop:
+                        break;
+                    }
+                }
+
+                void finishFetch(bool ok, std::string text)
+                {
+                    fetch_active_ = false;
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    // A caller that timed out no longer wants the result
+                    if (fetch_abandoned_ >= fetch_pending_)
+                        return;
+                    fetch_ok_ = ok;
+                    fetch_result_ = std::move(text);
+                    fetch_completed_ = fetch_pending_;
+                    cond_.notify_all();
+                }
+
+                void handle(const XEvent &event)
+                {
+                    switch (event.type)
+                    {
+                    case SelectionRequest:
+                        answer(event.xselectionrequest);
+                        break;
+                    case SelectionClear:
+                        if (event.xselectionclear.selection == clipboard_)
+                            owns_clipboard_ = false;
+                        else if (event.xselectionclear.selection == XA_PRIMARY)
+                            owns_primary_ = false;
+                        break;
+                    case SelectionNotify:
+                        if (fetch_active_ && event.xselection.selection == clipboard_)
+                            receiveFetch(event.xselection);
+                        break;
+                    case PropertyNotify:
+                        if (event.xproperty.window == window_)
+                        {
+                            if (event.xproperty.atom == timestamp_property_)
+                                finishArm(event.xproperty.time);
+                            else if (fetch_active_ && fetch_incr_ && event.xproperty.atom == fetch_property_ &&
+                                event.xproperty.state == PropertyNewValue)
+                                receiveFetchChunk();
+                        }
+                        else if (event.xproperty.state == PropertyDelete)
+                        {
+                            continueTransfer(event.xproperty.window, event.xproperty.atom);
+                        }
+                        break;
+                    }
+                }
+
+                bool isTextTarget(Atom target) const
+                {
+                    return target == utf8_ || target == text_plain_ || target == XA_STRING || target == text_;
+                }
+
+                void finishArm(Time time)
+                {
+                    paste_after_ = time;
+                    paste_focus_ = None;
+                    Window focus = None;
+                    int revert = 0;
+                    XGetInputFocus(display_, &focus, &revert);
+                    if (focus != None && focus != PointerRoot)
+                        paste_focus_ = toplevel(focus);
+                    paste_armed_ = true;
+
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    armed_ = arm_pending_;
+                    pasted_generation_ = generation_owned_;
+                    pasted_ = false;
+                    cond_.notify_all();
+                }
+
+                // The child of the root `window` belongs to: the window manager's
+                // frame, or the window itself when it is not reparented
+                Window toplevel(Window window)
+                {
+                    for (;;)
+                    {
+                        Window root = None, parent = None, *children = nullptr;
+                        unsigned count = 0;
+                        if (!XQueryTree(display_, window, &root, &parent, &children, &count))
+                            return window;
+                        if (children)
+                            XFree(children);
+                        if (parent == None || parent == root)
+                            return window;
+                        window = parent;
+                    }
+                }
+
+                // Whether `request` comes from the armed keystroke rather than
+                // a client that copied the text on its own. Toolkits pass the
+                // key event's time, which is never before the armed timestamp;
+                // some pass CurrentTime, so the focused window counts as well.
+                bool isPaste(const XSelectionRequestEvent &request)
+                {
+                    if (!paste_armed_ || request.selection != clipboard_)
+                        return false;
+                    // Server time is 32 bits and wraps around
+                    if (request.time != CurrentTime &&
+                        static_cast<int32_t>(static_cast<uint32_t>(request.time) - static_cast<uint32_t>(paste_after_)) >= 0)
+                        return true;
+                    return paste_focus_ != None && toplevel(request.requestor) == paste_focus_;
+                }
+
+                void answer(const XSelectionRequestEvent &request)
+                {
+                    XSelectionEvent reply = {};
+                    reply.type = SelectionNotify;
+                    reply.display = request.display;
+                    reply.requestor = request.requestor;
+                    reply.selection = request.selection;
+                    reply.target = request.target;
+                    reply.property = None;
+                    reply.time = request.time;
+
+                    bool owned = (request.selection == clipboard_ && owns_clipboard_) ||
+                                 (request.selection == XA_PRIMARY && owns_primary_);
+                    // Obsolete clients leave the property unset and expect the target's name
+                    Atom property = request.property != None ? request.property : request.target;
+
+                    if (owned && request.target == targets_)
+                    {
+                        Atom supported[] = {targets_, utf8_, text_plain_, XA_STRING, text_};
+                        XChangeProperty(display_, request.requestor, property, XA_ATOM, 32, PropModeReplace,
+                                        reinterpret_cast<unsigned char *>(supported),
+                                        sizeof(supported) / sizeof(supported[0]));
+                        reply.property = property;
+                    }
+                    else if (owned && isTextTarget(request.target))
+                    {
+                        Atom type = request.target == text_ ? utf8_ : request.target;
+                        const std::string &text = *text_owned_;
+                        bool paste = isPaste(request);
+                        if (text.size() > chunk_)
+                        {
+                            // Announce the size; chunks follow as the requestor deletes the property
+                            XSelectInput(display_, request.requestor, PropertyChangeMask);
+                            long size = static_cast<long>(text.size());
+                            XChangeProperty(display_, request.requestor, property, incr_, 32, PropModeReplace,
+                                            reinterpret_cast<unsigned char *>(&size), 1);
+                            transfers_.push_back(Transfer{request.requestor, property, type, text_owned_,
+                                                          generation_owned_, paste, 0, Clock::now()});
+                        }
+                        else
+                        {
+                            XChangeProperty(display_, request.requestor, property, type, 8, PropModeReplace,
+                                            reinterpret_cast<const unsigned char *>(text.data()),
+                                            static_cast<int>(text.size()));
+                            if (paste)
+                                markPasted(generation_owned_);
+                        }
+                        reply.property = property;
+                    }
+
+                    XSendEvent(display_, request.requestor, False, NoEventMask, reinterpret_cast<XEvent *>(&reply));
+                }
+
+                void continueTransfer(Window requestor, Atom property)
+                {
+                    for (auto it = transfers_.begin(); it != transfers_.end(); ++it)
+                    {
+                        if (it->requestor != requestor || it->property != property)
+                            continue;
+
+                        // A zero-length chunk ends the transfer
+                        size_t length = std::min(chunk_, it->text->size() - it->offset);
+                        XChangeProperty(display_, requestor, property, it->type, 8, PropModeReplace,
+                                        reinterpret_cast<const unsigned char *>(it->text->data() + it->offset),
+                                        static_cast<int>(length));
+                        it->offset += length;
+                        if (length == 0)
+                        {
+                            XSelectInput(display_, requestor, NoEventMask);
+                            if (it->paste)
+                                markPasted(it->generation);
+                            transfers_.erase(it);
+                        }
+                        return;
+                    }
+                }
+
+                void dropStaleTransfers()
+                {
+                    auto now = Clock::now();
+                    transfers_.erase(std::remove_if(transfers_.begin(), transfers_.end(), [&](const Transfer &t)
+                                                    { return now - t.started > kTransferTimeout; }),
+                                     transfers_.end());
+                }
+
+                void markPasted(uint64_t generation)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (generation == pasted_generation_)
+                        pasted_ = true;
+                    cond_.notify_all();
+                }
+
+                // Reads and deletes the fetch property; false if it is missing
+                bool takeFetchProperty(Atom &type, std::string &data)
+                {
+                    int format;
+                    unsigned long items, remaining;
+                    unsigned char *value = nullptr;
+                    if (XGetWindowProperty(display_, window_, fetch_property_, 0, LONG_MAX / 4, True,
+                                           AnyPropertyType, &type, &format, &items, &remaining, &value) != Success)
+                        return false;
+                    if (value)
+                    {
+                        if (format == 8)
+                            data.assign(reinterpret_cast<char *>(value), items);
+                        XFree(value);
+                    }
+                    return type != None;
+                }
+
+                void receiveFetch(const XSelectionEvent &event)
+                {
+                    Atom type;
+                    std::string data;
+                    if (event.property == None || !takeFetchProperty(type, data))
+                    {
+                        finishFetch(false, std::string());
+                        return;
+                    }
+                    if (type == incr_)
+                    {
+                        // Deleting the property (done above) asks for the first chunk
+                        fetch_incr_ = true;
+                        return;
+                    }
+                    finishFetch(type == utf8_ || type == XA_STRING, std::move(data));
+                }
+
+                void receiveFetchChunk()
+                {
+                    Atom type;
+                    std::string chunk;
+                    if (!takeFetchProperty(type, chunk))
+                        return;
+                    if (chunk.empty())
+                        finishFetch(true, std::move(fetch_buffer_));
+                    else
+                        fetch_buffer_ += chunk;
+                }
+
+                Display *display_;
+                int wake_fd_;
+                Window window_ = None;
+                Atom clipboard_ = None, targets_ = None, utf8_ = None, text_plain_ = None, text_ = None,
+                     incr_ = None, fetch_property_ = None, timestamp_property_ = None;
+                size_t chunk_ = kMaxChunk;
+                std::thread thread_;
+
+                // Owner thread only
+                Text text_owned_;
+                uint64_t generation_owned_ = 0;
+                bool owns_clipboard_ = false;
+                bool owns_primary_ = false;
+                std::vector<Transfer> transfers_;
+                bool fetch_active_ = false;
+                bool fetch_incr_ = false;
+                std::string fetch_buffer_;
+                uint64_t arm_pending_ = 0;
+                bool paste_armed_ = false;
+                Time paste_after_ = CurrentTime;
+                Window paste_focus_ = None;
+
+                // Shared with callers, guarded by the mutex
+                std::mutex mutex_;
+                std::condition_variable cond_;
+                std::deque<Command> commands_;
+                uint64_t requested_generation_ = 0;
+                uint64_t owned_generation_ = 0;
+                bool owned_ = false;
+                uint64_t arm_requested_ = 0;
+                uint64_t armed_ = 0;
+                uint64_t pasted_generation_ = 0;
+                bool pasted_ = false;
+                uint64_t fetch_requested_ = 0;
+                uint64_t fetch_pending_ = 0;
+                uint64_t fetch_completed_ = 0;
+                uint64_t fetch_abandoned_ = 0;
+                bool fetch_ok_ = false;
+                std::string fetch_result_;
+            };
+        } // namespace
+
+        bool PasteText(std::string_view text, const PasteOptions &options)
+        {
+            // One paste at a time, so a restore cannot overwrite another caller's text
+            static std::mutex pasteMutex;
+            std::lock_guard<std::mutex> lock(pasteMutex);
+
+            SelectionOwner *owner = SelectionOwner::instance();
+            if (!owner)
+                return false;
+
+            auto deadline = Clock::now() + options.timeout;
+            std::string previous;
+            bool hadPrevious = options.restoreClipboard && owner->fetchClipboard(previous, deadline);
+
+            uint64_t generation = owner->own(std::make_shared<const std::string>(text), options.primary, deadline);
+            if (generation == 0)
+                return false;
+
+            // Clipboard managers copy the text as soon as it is owned, and
+            // may still be at it after the keystroke; only the transfer the
+            // keystroke asked for counts as the paste
+            bool pasted = owner->armPaste(deadline);
+            if (pasted)
+            {
+                KeyCombination({KeyCode::KEY_CONTROL, KeyCode::KEY_V});
+                pasted = owner->waitForPaste(generation, deadline);
+            }
+
+            if (options.restoreClipboard)
+            {
+                if (hadPrevious)
+                    owner->own(std::make_shared<const std::string>(std::move(previous)), false,
+                               Clock::now() + std::chrono::seconds(1));
+                else
+                    owner->release();
+            }
+            return pasted;
+        }
+
+    } // namespace X11Impl
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
@@ -2,7 +2,12 @@
 
 #ifdef CROSSINPUT_LINUX
 
+#include "../../core/startup_phases.h"
+#include "../../core/stats.h"
+#include "../../core/trace.h"
 #include <X11/Xlib.h>
+#include "dynamic_libs.h"
+#include <atomic>
 
 namespace CrossInput
 {
@@ -13,21 +18,81 @@ namespace CrossInput
         class X11Display
         {
         public:
-            X11Display() : display_(XOpenDisplay(nullptr)) {}
+            X11Display() { open(); }
             ~X11Display()
             {
                 if (display_)
                     XCloseDisplay(display_);
             }
 
+            // This thread's long-lived connection, opened on first use and closed
+            // when the thread exits, so injecting costs no XOpenDisplay round
+            // trips or allocations. A failed open is retried on the next call.
+            static X11Display &forThread()
+            {
+                thread_local X11Display display(Deferred{});
+                if (!display.display_)
+                    display.open();
+                else
+                    display.applyMappingChanges();
+                return display;
+            }
+
+            // Bumped whenever any connection sees the keyboard mapping change, so
+            // keycodes looked up earlier can be checked for staleness
+            static unsigned mappingGeneration() { return generation().load(std::memory_order_acquire); }
+
             Display *get() const { return display_; }
             bool isValid() const { return display_ != nullptr; }
 
+            // Sends queued requests to the server
+            void flush()
+            {
+                FlushTimer timer;
+                TraceScope trace("x11", "Flush");
+                XFlush(display_);
+                markStartupPhase(StartupPhase::FirstFrame);
+            }
+
             // Non-copyable
             X11Display(const X11Display &) = delete;
             X11Display &operator=(const X11Display &) = delete;
 
         private:
+            struct Deferred
+            {
+            };
+            explicit X11Display(Deferred) : display_(nullptr) {}
+
+            void open()
+            {
+                display_ = x11Available() ? XOpenDisplay(nullptr) : nullptr;
+                if (display_)
+                    markStartupPhase(StartupPhase::Connect);
+            }
+
+            // Keycode lookups read Xlib's cached keyboard mapping. Every client
+            // receives MappingNotify, so refresh the cache when a layout changes.
+            void applyMappingChanges()
+            {
+                while (XPending(display_) > 0)
+                {
+                    XEvent event;
+                    XNextEvent(display_, &event);
+                    if (event.type == MappingNotify)
+                    {
+                        XRefreshKeyboardMapping(&event.xmapping);
+                        generation().fetch_add(1, std::memory_order_acq_rel);
+                    }
+                }
+            }
+
+            static std::atomic<unsigned> &generation()
+            {
+                static std::atomic<unsigned> value{0};
+                return value;
+            }
+
             Display *display_;
         };
 
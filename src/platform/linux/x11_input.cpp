@@ -3,20 +3,145 @@
 #ifdef CROSSINPUT_LINUX
 
 #include "../../../include/CrossInput.h"
+#include "../../core/input_sequence.h"
+#include "../../core/stats.h"
 #include "linux_keycodes.h"
 #include "x11_display.h"
+#include "x11_keymap.h"
+#include "x11_spare_keycodes.h"
 #include <X11/extensions/XTest.h>
+#include "dynamic_libs.h"
+#include <mutex>
+#include <vector>
 
 namespace CrossInput
 {
     namespace X11Impl
     {
+        namespace
+        {
+            // An InputSequence as XTest requests with the keycodes and buttons
+            // already looked up. Keycodes stay valid until the server's
+            // keyboard mapping changes.
+            class PreparedX11Sequence : public Internal::PreparedSequence
+            {
+            public:
+                struct Step
+                {
+                    EventType type;
+                    unsigned detail; // keycode or button
+                    int x, y;
+                };
+
+                PreparedX11Sequence(std::vector<Step> steps, unsigned generation)
+                    : steps_(std::move(steps)), generation_(generation)
+                {
+                }
+
+                bool play() const override
+                {
+                    Internal::X11Display &display = Internal::X11Display::forThread();
+                    if (!display.isValid())
+                    {
+                        Internal::markStatFailure();
+                        return true;
+                    }
+                    if (Internal::X11Display::mappingGeneration() != generation_)
+                        return false;
+
+                    // Every request lands in Xlib's output buffer; one flush sends them all
+                    Window root = DefaultRootWindow(display.get());
+                    for (const Step &step : steps_)
+                    {
+                        switch (step.type)
+                        {
+                        case EventType::KeyDown:
+                        case EventType::KeyUp:
+                            XTestFakeKeyEvent(display.get(), step.detail, step.type == EventType::KeyDown,
+                                              CurrentTime);
+                            break;
+                        case EventType::MouseButtonDown:
+                        case EventType::MouseButtonUp:
+                            XTestFakeButtonEvent(display.get(), step.detail,
+                                                 step.type == EventType::MouseButtonDown, CurrentTime);
+                            break;
+                        case EventType::SetCursorPosition:
+                            XWarpPointer(display.get(), None, root, 0, 0, 0, 0, step.x, step.y);
+                            break;
+                        case EventType::MoveCursor:
+                            XWarpPointer(display.get(), None, None, 0, 0, 0, 0, step.x, step.y);
+                            break;
+                        }
+                    }
+                    display.flush();
+                    return true;
+                }
+
+            private:
+                std::vector<Step> steps_;
+                unsigned generation_;
+            };
+
+            // TypeText's codepoint table for one keyboard mapping generation,
+            // guarded by the spare keycode pool's mutex
+            struct Keystrokes
+            {
+                Internal::KeystrokeTable table;
+                uint32_t modifierCodes[Internal::kModifierCount] = {0, 0};
+                unsigned generation = 0;
+                bool valid = false;
+            };
+        } // namespace
+
+        std::shared_ptr<const Internal::PreparedSequence> Prepare(const InputEvent *events, size_t count)
+        {
+            Internal::X11Display &display = Internal::X11Display::forThread();
+            if (!display.isValid())
+                return nullptr;
+
+            // Read before the lookups, so a change during them forces a retranslation
+            unsigned generation = Internal::X11Display::mappingGeneration();
+            std::vector<PreparedX11Sequence::Step> steps;
+            steps.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const InputEvent &event = events[i];
+                PreparedX11Sequence::Step step = {event.type, 0, event.pos.x, event.pos.y};
+                switch (event.type)
+                {
+                case EventType::KeyDown:
+                case EventType::KeyUp:
+                {
+                    // Keys without a keycode are skipped, as KeyDown does
+                    unsigned long keysym = Internal::keycode_to_x11_keysym(event.key);
+                    step.detail = keysym ? XKeysymToKeycode(display.get(), keysym) : 0;
+                    if (step.detail == 0)
+                        continue;
+                    break;
+                }
+                case EventType::MouseButtonDown:
+                case EventType::MouseButtonUp:
+                    step.detail = Internal::mouse_button_to_x11_button(event.button);
+                    if (step.detail == 0)
+                        continue;
+                    break;
+                case EventType::SetCursorPosition:
+                case EventType::MoveCursor:
+                    break;
+                }
+                steps.push_back(step);
+            }
+            return std::make_shared<PreparedX11Sequence>(std::move(steps), generation);
+        }
 
         bool IsKeyPressed(KeyCode key)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return false;
+            }
 
             unsigned long keysym = Internal::keycode_to_x11_keysym(key);
             if (keysym == 0)
@@ -34,9 +159,12 @@ namespace CrossInput
 
         void KeyDown(KeyCode key)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return;
+            }
 
             unsigned long keysym = Internal::keycode_to_x11_keysym(key);
             if (keysym == 0)
@@ -47,14 +175,17 @@ namespace CrossInput
                 return;
 
             XTestFakeKeyEvent(display.get(), xKeycode, True, CurrentTime);
-            XFlush(display.get());
+            display.flush();
         }
 
         void KeyUp(KeyCode key)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return;
+            }
 
             unsigned long keysym = Internal::keycode_to_x11_keysym(key);
             if (keysym == 0)
@@ -65,42 +196,99 @@ namespace CrossInput
                 return;
 
             XTestFakeKeyEvent(display.get(), xKeycode, False, CurrentTime);
-            XFlush(display.get());
+            display.flush();
+        }
+
+        void TypeText(std::string_view text)
+        {
+            Internal::X11Display &display = Internal::X11Display::forThread();
+            if (!display.isValid())
+            {
+                Internal::markStatFailure();
+                return;
+            }
+
+            auto &spares = Internal::X11SpareKeycodes::instance();
+            std::lock_guard<std::mutex> lock(spares.mutex());
+
+            // The keyboard mapping is only fetched again after a MappingNotify.
+            // Remapping a spare keycode causes one too, so the call after a new
+            // character is borrowed rebuilds; repeated text costs no round trip.
+            static Keystrokes cached;
+            unsigned generation = Internal::X11Display::mappingGeneration();
+            if (!cached.valid || cached.generation != generation)
+            {
+                Internal::X11KeyboardMapping mapping(display.get());
+                if (!mapping.isValid())
+                    return;
+                spares.sync(mapping);
+
+                // Spare keycodes are served by the allocator so their LRU order stays accurate
+                Internal::build_x11_keystroke_table(mapping, cached.table, [&](int keycode)
+                                                    { return spares.isPooled(keycode); });
+                cached.modifierCodes[0] = XKeysymToKeycode(display.get(), XK_Shift_L);
+                cached.generation = generation;
+                cached.valid = true;
+            }
+            spares.beginCall();
+
+            // Queue every key event in Xlib's output buffer, then flush once
+            Internal::typeKeystrokes(
+                text, cached.table, cached.modifierCodes,
+                [&](uint32_t keycode, bool down)
+                { XTestFakeKeyEvent(display.get(), keycode, down ? True : False, CurrentTime); },
+                [&](char32_t cp)
+                {
+                    // Not in the layout: borrow a spare keycode mapped to the keysym
+                    unsigned keycode = spares.acquire(display.get(), Internal::codepoint_to_x11_keysym(cp));
+                    return Internal::Keystroke{keycode, 0, keycode != 0};
+                });
+
+            display.flush();
         }
 
         void MouseButtonDown(MouseButton button)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return;
+            }
 
             unsigned int x11Button = Internal::mouse_button_to_x11_button(button);
             if (x11Button == 0)
                 return;
 
             XTestFakeButtonEvent(display.get(), x11Button, True, CurrentTime);
-            XFlush(display.get());
+            display.flush();
         }
 
         void MouseButtonUp(MouseButton button)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return;
+            }
 
             unsigned int x11Button = Internal::mouse_button_to_x11_button(button);
             if (x11Button == 0)
                 return;
 
             XTestFakeButtonEvent(display.get(), x11Button, False, CurrentTime);
-            XFlush(display.get());
+            display.flush();
         }
 
         Point GetCursorPosition()
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return Point{0, 0};
+            }
 
             Window root = DefaultRootWindow(display.get());
             Window root_return, child_return;
@@ -115,24 +303,42 @@ namespace CrossInput
 
         void SetCursorPosition(const Point &pos)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return;
+            }
 
             Window root = DefaultRootWindow(display.get());
             XWarpPointer(display.get(), None, root, 0, 0, 0, 0, pos.x, pos.y);
-            XFlush(display.get());
+            display.flush();
         }
 
         void MoveCursor(int dx, int dy)
         {
-            Internal::X11Display display;
+            Internal::X11Display &display = Internal::X11Display::forThread();
             if (!display.isValid())
+            {
+                Internal::markStatFailure();
                 return;
+            }
 
             // XWarpPointer with src_w/src_h = 0 means move relative to current position
             XWarpPointer(display.get(), None, None, 0, 0, 0, 0, dx, dy);
-            XFlush(display.get());
+            display.flush();
+        }
+
+        bool Sync()
+        {
+            Internal::X11Display &display = Internal::X11Display::forThread();
+            if (!display.isValid())
+                return false;
+
+            // Calls on this thread share the connection, so one round trip
+            // covers everything they sent
+            XSync(display.get(), False);
+            return true;
         }
 
     } // namespace X11Impl
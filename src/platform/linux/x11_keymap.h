@@ -0,0 +1,143 @@
+#pragma once
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../core/text_input.h"
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include "dynamic_libs.h"
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Codepoint a keysym types, 0 for keysyms that are not text
+        inline char32_t x11_keysym_to_codepoint(KeySym keysym)
+        {
+            // Latin-1 keysyms equal their codepoints
+            if ((keysym >= 0x20 && keysym <= 0x7E) || (keysym >= 0xA0 && keysym <= 0xFF))
+                return static_cast<char32_t>(keysym);
+            // Direct Unicode keysyms
+            if (keysym >= 0x01000100 && keysym <= 0x0110FFFF)
+                return static_cast<char32_t>(keysym - 0x01000000);
+
+            switch (keysym)
+            {
+            case XK_Return:
+            case XK_KP_Enter:
+                return U'\n';
+            case XK_Tab:
+                return U'\t';
+            case XK_BackSpace:
+                return U'\b';
+            case XK_EuroSign:
+                return 0x20AC;
+            default:
+                return 0;
+            }
+        }
+
+        // Keysym that types a codepoint
+        inline KeySym codepoint_to_x11_keysym(char32_t cp)
+        {
+            switch (cp)
+            {
+            case U'\n':
+                return XK_Return;
+            case U'\t':
+                return XK_Tab;
+            case U'\b':
+                return XK_BackSpace;
+            default:
+                break;
+            }
+            if ((cp >= 0x20 && cp <= 0x7E) || (cp >= 0xA0 && cp <= 0xFF))
+                return static_cast<KeySym>(cp);
+            return static_cast<KeySym>(0x01000000 + cp);
+        }
+
+        // Snapshot of the server's core keyboard mapping (one round trip)
+        class X11KeyboardMapping
+        {
+        public:
+            explicit X11KeyboardMapping(Display *display)
+                : keysyms_(nullptr), minKeycode_(0), maxKeycode_(0), perKeycode_(0)
+            {
+                XDisplayKeycodes(display, &minKeycode_, &maxKeycode_);
+                keysyms_ = XGetKeyboardMapping(display, static_cast<::KeyCode>(minKeycode_),
+                                               maxKeycode_ - minKeycode_ + 1, &perKeycode_);
+            }
+
+            ~X11KeyboardMapping()
+            {
+                if (keysyms_)
+                    XFree(keysyms_);
+            }
+
+            bool isValid() const { return keysyms_ != nullptr; }
+            int minKeycode() const { return minKeycode_; }
+            int maxKeycode() const { return maxKeycode_; }
+            int perKeycode() const { return perKeycode_; }
+
+            KeySym get(int keycode, int level) const
+            {
+                if (keycode < minKeycode_ || keycode > maxKeycode_ || level >= perKeycode_)
+                    return NoSymbol;
+                return keysyms_[(keycode - minKeycode_) * perKeycode_ + level];
+            }
+
+            bool isUnused(int keycode) const
+            {
+                for (int level = 0; level < perKeycode_; ++level)
+                    if (get(keycode, level) != NoSymbol)
+                        return false;
+                return true;
+            }
+
+            // Non-copyable
+            X11KeyboardMapping(const X11KeyboardMapping &) = delete;
+            X11KeyboardMapping &operator=(const X11KeyboardMapping &) = delete;
+
+        private:
+            KeySym *keysyms_;
+            int minKeycode_;
+            int maxKeycode_;
+            int perKeycode_;
+        };
+
+        // Fills `table` from group 1, shift levels 1 and 2 of the mapping.
+        // Keycodes for which `skip(keycode)` is true are left out.
+        template <typename Skip>
+        void build_x11_keystroke_table(const X11KeyboardMapping &mapping, KeystrokeTable &table, Skip &&skip)
+        {
+            table.clear();
+            for (int keycode = mapping.minKeycode(); keycode <= mapping.maxKeycode(); ++keycode)
+            {
+                if (skip(keycode))
+                    continue;
+
+                KeySym plain = mapping.get(keycode, 0);
+                KeySym shifted = mapping.get(keycode, 1);
+
+                // A lone lowercase keysym implies its uppercase form on the shift level
+                if (plain != NoSymbol && shifted == NoSymbol)
+                {
+                    KeySym lower, upper;
+                    XConvertCase(plain, &lower, &upper);
+                    if (upper != plain)
+                        shifted = upper;
+                }
+
+                if (char32_t cp = x11_keysym_to_codepoint(plain))
+                    table.add(cp, static_cast<uint32_t>(keycode), 0);
+                if (char32_t cp = x11_keysym_to_codepoint(shifted))
+                    table.add(cp, static_cast<uint32_t>(keycode), kModShift);
+            }
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
@@ -0,0 +1,90 @@
+#pragma once
+
+#ifdef CROSSINPUT_LINUX
+
+#include "../../core/spare_keycode_pool.h"
+#include "x11_display.h"
+#include "x11_keymap.h"
+#include <mutex>
+#include <vector>
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // The process's SpareKeycodePool, remapping keycodes with
+        // XChangeKeyboardMapping. Original (empty) mappings are restored in
+        // one batch when the process exits.
+        class X11SpareKeycodes
+        {
+        public:
+            static X11SpareKeycodes &instance()
+            {
+                static X11SpareKeycodes spares;
+                return spares;
+            }
+
+            // Held for the duration of a TypeText call
+            std::mutex &mutex() { return mutex_; }
+
+            void sync(const X11KeyboardMapping &mapping) { pool_.sync(mapping); }
+            bool isPooled(int keycode) const { return pool_.isPooled(keycode); }
+            void beginCall() { pool_.beginCall(); }
+
+            // Keycode that types `keysym` (mapped at every shift level), 0 if the pool is empty
+            unsigned acquire(Display *display, KeySym keysym)
+            {
+                Server server{display};
+                return pool_.acquire(server, keysym);
+            }
+
+            void restoreAll(Display *display)
+            {
+                Server server{display};
+                pool_.restoreAll(server);
+            }
+
+            ~X11SpareKeycodes()
+            {
+                if (!pool_.dirty())
+                    return;
+                X11Display display;
+                if (display.isValid())
+                    restoreAll(display.get());
+            }
+
+            // Non-copyable
+            X11SpareKeycodes(const X11SpareKeycodes &) = delete;
+            X11SpareKeycodes &operator=(const X11SpareKeycodes &) = delete;
+
+        private:
+            X11SpareKeycodes() = default;
+
+            struct Server
+            {
+                Display *display;
+
+                void sync() { XSync(display, False); }
+
+                void remap(unsigned keycode, KeySym keysym)
+                {
+                    KeySym keysyms[2] = {keysym, keysym};
+                    XChangeKeyboardMapping(display, static_cast<int>(keycode), 2, keysyms, 1);
+                }
+
+                void clear(unsigned first, unsigned count)
+                {
+                    std::vector<KeySym> empty(2 * count, NoSymbol);
+                    XChangeKeyboardMapping(display, static_cast<int>(first), 2, empty.data(), static_cast<int>(count));
+                }
+            };
+
+            std::mutex mutex_;
+            SpareKeycodePool pool_;
+        };
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_LINUX
@@ -0,0 +1,105 @@
+#pragma once
+
+#ifdef CROSSINPUT_LINUX
+#ifdef CROSSINPUT_HAS_XKBCOMMON
+
+#include "../../core/text_input.h"
+#include <xkbcommon/xkbcommon.h>
+#include "dynamic_libs.h"
+
+namespace CrossInput
+{
+    namespace Internal
+    {
+
+        // Compiles an XKB keymap (text format, as sent by EIS or a Wayland
+        // compositor) and fills `table` with codepoint -> (evdev code, modifiers)
+        // for every level of layout 1 reachable with Shift and/or AltGr.
+        inline bool build_xkb_keystroke_table(const char *buffer, size_t size, KeystrokeTable &table)
+        {
+            // The buffer usually carries its terminating NUL, which xkbcommon rejects
+            while (size > 0 && buffer[size - 1] == '\0')
+                --size;
+
+            if (!xkbcommonAvailable())
+                return false;
+            xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES);
+            if (!context)
+                return false;
+
+            xkb_keymap *keymap = xkb_keymap_new_from_buffer(context, buffer, size,
+                                                            XKB_KEYMAP_FORMAT_TEXT_V1,
+                                                            XKB_KEYMAP_COMPILE_NO_FLAGS);
+            xkb_context_unref(context);
+            if (!keymap)
+                return false;
+
+            struct Builder
+            {
+                KeystrokeTable *table;
+                xkb_mod_mask_t shiftMask;
+                xkb_mod_mask_t altGrMask;
+            };
+
+            // ISO_Level3_Shift (AltGr) sets Mod5 in the stock xkeyboard-config layouts
+            xkb_mod_index_t shiftIndex = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_SHIFT);
+            xkb_mod_index_t altGrIndex = xkb_keymap_mod_get_index(keymap, "Mod5");
+            Builder builder{&table,
+                            shiftIndex != XKB_MOD_INVALID ? (1u << shiftIndex) : 0u,
+                            altGrIndex != XKB_MOD_INVALID ? (1u << altGrIndex) : 0u};
+
+            table.clear();
+            xkb_keymap_key_for_each(
+                keymap,
+                [](xkb_keymap *map, xkb_keycode_t key, void *data)
+                {
+                    auto *b = static_cast<Builder *>(data);
+                    // XKB keycodes are evdev codes offset by 8
+                    if (key < 8)
+                        return;
+                    const uint32_t evdev = key - 8;
+
+                    xkb_level_index_t levels = xkb_keymap_num_levels_for_key(map, key, 0);
+                    for (xkb_level_index_t level = 0; level < levels; ++level)
+                    {
+                        const xkb_keysym_t *syms = nullptr;
+                        if (xkb_keymap_key_get_syms_by_level(map, key, 0, level, &syms) != 1)
+                            continue;
+
+                        char32_t cp = xkb_keysym_to_utf32(syms[0]);
+                        if (cp == 0)
+                            continue;
+
+                        // Pick a modifier combination for this level made of Shift/AltGr only
+                        xkb_mod_mask_t masks[8];
+                        size_t count = xkb_keymap_key_get_mods_for_level(map, key, 0, level, masks, 8);
+                        for (size_t i = 0; i < count; ++i)
+                        {
+                            if (masks[i] & ~(b->shiftMask | b->altGrMask))
+                                continue;
+
+                            uint8_t modifiers = 0;
+                            if (masks[i] & b->shiftMask)
+                                modifiers |= kModShift;
+                            if (masks[i] & b->altGrMask)
+                                modifiers |= kModAltGr;
+
+                            b->table->add(cp, evdev, modifiers);
+                            // Return produces CR; text uses LF for new lines
+                            if (cp == U'\r')
+                                b->table->add(U'\n', evdev, modifiers);
+                            break;
+                        }
+                    }
+                },
+                &builder);
+
+            xkb_keymap_unref(keymap);
+            return !table.empty();
+        }
+
+    } // namespace Internal
+} // namespace CrossInput
+
+#endif // CROSSINPUT_HAS_XKBCOMMON
+#endif // CROSSINPUT_LINUX
@@ -4,6 +4,12 @@
 
 #include "../../../include/CrossInput.h"
 #include "macos_keycodes.h"
+#include "../../core/daemon_server.h"
+#include "../../core/event_capture.h"
+#include "../../core/input_sequence.h"
+#include "../../core/stats.h"
+#include "../../core/text_input.h"
+#include "../stub/null_backend.h"
 #include <ApplicationServices/ApplicationServices.h>
 
 namespace CrossInput
@@ -11,6 +17,8 @@ namespace CrossInput
 
     bool IsKeyPressed(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::IsKeyPressed);
+        CROSSINPUT_NULL_DISPATCH(IsKeyPressed(key));
         CGKeyCode cgKey = Internal::keycode_to_cg(key);
         if (cgKey == 0xFFFF)
             return false;
@@ -20,6 +28,8 @@ namespace CrossInput
 
     void KeyDown(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::KeyDown);
+        CROSSINPUT_NULL_DISPATCH(KeyDown(key));
         CGKeyCode cgKey = Internal::keycode_to_cg(key);
         if (cgKey == 0xFFFF)
             return;
@@ -34,6 +44,8 @@ namespace CrossInput
 
     void KeyUp(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::KeyUp);
+        CROSSINPUT_NULL_DISPATCH(KeyUp(key));
         CGKeyCode cgKey = Internal::keycode_to_cg(key);
         if (cgKey == 0xFFFF)
             return;
@@ -67,8 +79,64 @@ namespace CrossInput
         }
     }
 
+    void TypeText(std::string_view utf8)
+    {
+        Internal::StatScope stat(StatOp::TypeText);
+        CROSSINPUT_NULL_DISPATCH(TypeText(utf8));
+        // CGEventKeyboardSetUnicodeString is layout-independent; events carry up to 20 UTF-16 units
+        constexpr size_t kChunk = 20;
+        UniChar units[kChunk + 1];
+        size_t count = 0;
+
+        auto flush = [&]()
+        {
+            if (count == 0)
+                return;
+            for (bool down : {true, false})
+            {
+                CGEventRef event = CGEventCreateKeyboardEvent(nullptr, 0, down);
+                if (event)
+                {
+                    CGEventKeyboardSetUnicodeString(event, count, units);
+                    CGEventPost(kCGHIDEventTap, event);
+                    CFRelease(event);
+                }
+            }
+            count = 0;
+        };
+
+        size_t pos = 0;
+        while (pos < utf8.size())
+        {
+            char32_t cp = Internal::nextCodepoint(utf8, pos);
+            if (cp == Internal::kInvalidCodepoint)
+                continue;
+            if (count + 2 > kChunk)
+                flush();
+            if (cp <= 0xFFFF)
+            {
+                units[count++] = static_cast<UniChar>(cp);
+            }
+            else
+            {
+                char32_t v = cp - 0x10000;
+                units[count++] = static_cast<UniChar>(0xD800 + (v >> 10));
+                units[count++] = static_cast<UniChar>(0xDC00 + (v & 0x3FF));
+            }
+        }
+        flush();
+    }
+
+    bool PasteText(std::string_view, const PasteOptions &)
+    {
+        // Only the X selection is implemented
+        return false;
+    }
+
     void MouseButtonDown(MouseButton button)
     {
+        Internal::StatScope stat(StatOp::MouseButtonDown);
+        CROSSINPUT_NULL_DISPATCH(MouseButtonDown(button));
         CGPoint location = CGEventGetLocation(CGEventCreate(nullptr));
         CGEventType eventType = Internal::mouse_button_down_event(button);
         CGMouseButton cgButton = Internal::mouse_button_to_cg(button);
@@ -83,6 +151,8 @@ namespace CrossInput
 
     void MouseButtonUp(MouseButton button)
     {
+        Internal::StatScope stat(StatOp::MouseButtonUp);
+        CROSSINPUT_NULL_DISPATCH(MouseButtonUp(button));
         CGPoint location = CGEventGetLocation(CGEventCreate(nullptr));
         CGEventType eventType = Internal::mouse_button_up_event(button);
         CGMouseButton cgButton = Internal::mouse_button_to_cg(button);
@@ -103,6 +173,8 @@ namespace CrossInput
 
     Point GetCursorPosition()
     {
+        Internal::StatScope stat(StatOp::GetCursorPosition);
+        CROSSINPUT_NULL_DISPATCH(GetCursorPosition());
         CGEventRef event = CGEventCreate(nullptr);
         CGPoint location = CGEventGetLocation(event);
         CFRelease(event);
@@ -112,6 +184,8 @@ namespace CrossInput
 
     void SetCursorPosition(const Point &pos)
     {
+        Internal::StatScope stat(StatOp::SetCursorPosition);
+        CROSSINPUT_NULL_DISPATCH(SetCursorPosition(pos));
         CGPoint location = CGPointMake(static_cast<CGFloat>(pos.x), static_cast<CGFloat>(pos.y));
         CGWarpMouseCursorPosition(location);
 
@@ -121,15 +195,77 @@ namespace CrossInput
 
     void MoveCursor(int dx, int dy)
     {
+        Internal::StatScope stat(StatOp::MoveCursor);
+        CROSSINPUT_NULL_DISPATCH(MoveCursor(dx, dy));
         Point current = GetCursorPosition();
         SetCursorPosition(Point{current.x + dx, current.y + dy});
     }
 
+    bool Sync(int)
+    {
+        // Cursor warps apply immediately; posted events get no acknowledgement
+        return true;
+    }
+
+    void SetReconnectPolicy(const ReconnectPolicy &) {}
+
+    bool UseEisConnection(int)
+    {
+        return false;
+    }
+
+    // The injector daemon relies on memfd and eventfd, which are Linux-only
+    std::string DefaultDaemonSocket()
+    {
+        return std::string();
+    }
+
+    bool ConnectDaemon(const std::string &)
+    {
+        return false;
+    }
+
+    bool SetBackend(Backend backend)
+    {
+        if (backend == Backend::Null)
+            NullImpl::Open();
+        else if (backend != Backend::Auto)
+            return false;
+        NullImpl::SetActive(backend == Backend::Null);
+        return true;
+    }
+
+    Backend GetBackend()
+    {
+        return NullImpl::Active() ? Backend::Null : Backend::Auto;
+    }
+
     std::string GetPlatformName()
     {
         return "macOS";
     }
 
+    namespace Internal
+    {
+        // Global capture on macOS needs a CGEventTap and the Input Monitoring
+        // permission; not implemented yet, so EventStream stays inactive
+        std::unique_ptr<CaptureSource> startCapture(CaptureSink &)
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<DaemonServer> startDaemonServer(const std::string &, Backend)
+        {
+            return nullptr;
+        }
+
+        // CGEventPost takes one event at a time, so there is nothing to batch
+        std::shared_ptr<const PreparedSequence> prepareSequence(Backend, const InputEvent *, size_t)
+        {
+            return nullptr;
+        }
+    } // namespace Internal
+
 } // namespace CrossInput
 
 #endif // CROSSINPUT_MACOS
@@ -11,7 +11,6 @@
 #define CROSSINPUT_LINUX
 #include <cstdlib>
 #include <cstring>
-#include <string>
 #endif
 
 namespace CrossInput
@@ -30,7 +29,7 @@ namespace CrossInput
         inline bool IsWaylandSession()
         {
             const char *session_type = std::getenv("XDG_SESSION_TYPE");
-            return session_type && std::string(session_type) == "wayland";
+            return session_type && std::strcmp(session_type, "wayland") == 0;
         }
 
         // Check if X11/XWayland is available for reading state
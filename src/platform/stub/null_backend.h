@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../../include/CrossInput.h"
+
+// Backend::Null: an in-process simulated desktop, available on every platform
+namespace CrossInput
+{
+    namespace NullImpl
+    {
+        // Allocates the default event buffer if ResetNullBackend has not run yet
+        void Open();
+        // Whether Backend::Null is selected, for platforms without their own backend switch
+        bool Active();
+        void SetActive(bool active);
+
+        bool IsKeyPressed(KeyCode key);
+        void KeyDown(KeyCode key);
+        void KeyUp(KeyCode key);
+        void TypeText(std::string_view text);
+        void MouseButtonDown(MouseButton button);
+        void MouseButtonUp(MouseButton button);
+        Point GetCursorPosition();
+        void SetCursorPosition(const Point &pos);
+        void MoveCursor(int dx, int dy);
+    } // namespace NullImpl
+} // namespace CrossInput
+
+// Starts each public entry point on platforms without their own backend
+// switch: while Backend::Null is selected, makes `call` there and returns its
+// result (void calls included)
+#define CROSSINPUT_NULL_DISPATCH(call)           \
+    do                                           \
+    {                                            \
+        if (::CrossInput::NullImpl::Active())    \
+            return ::CrossInput::NullImpl::call; \
+    } while (0)
@@ -0,0 +1,243 @@
+// Backend::Null, built on every platform
+#include "null_backend.h"
+#include "../keycode_table.h"
+#include "../../core/text_input.h"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <memory>
+#include <mutex>
+
+namespace CrossInput
+{
+    namespace NullImpl
+    {
+        namespace
+        {
+            constexpr size_t kDefaultCapacity = 65536;
+
+            // The simulated desktop. One mutex covers state and buffer; an
+            // uncontended lock is a few tens of nanoseconds, well inside the
+            // budget for millions of events per second.
+            struct Desktop
+            {
+                std::mutex mutex;
+                int width = 1920;
+                int height = 1080;
+                Point cursor{0, 0};
+                std::bitset<Internal::kKeyCodeCount> keys;
+                std::unique_ptr<InputEvent[]> events;
+                size_t capacity = 0;
+                size_t count = 0;
+                size_t dropped = 0;
+
+                // Call with the mutex held
+                void record(const InputEvent &event)
+                {
+                    if (count < capacity)
+                        events[count++] = event;
+                    else
+                        ++dropped;
+                }
+
+                // Call with the mutex held
+                void setKey(KeyCode key, bool down)
+                {
+                    keys.set(static_cast<size_t>(key), down);
+                    record(InputEvent::Key(key, down));
+                }
+
+                // Call with the mutex held
+                Point clamp(Point p) const
+                {
+                    return Point{std::min(std::max(p.x, 0), width - 1), std::min(std::max(p.y, 0), height - 1)};
+                }
+            };
+
+            Desktop &desktop()
+            {
+                static Desktop instance;
+                return instance;
+            }
+
+            std::atomic<bool> g_active{false};
+
+            // US QWERTY codepoint -> KeyCode. Codes are stored as KeyCode + 1
+            // because typeKeystrokes treats code 0 as "no key".
+            const Internal::KeystrokeTable &usKeystrokeTable()
+            {
+                static const Internal::KeystrokeTable table = []
+                {
+                    auto code = [](KeyCode key)
+                    { return static_cast<uint32_t>(key) + 1; };
+                    Internal::KeystrokeTable t;
+                    for (int i = 0; i < 26; ++i)
+                    {
+                        uint32_t letter = code(static_cast<KeyCode>(static_cast<int>(KeyCode::KEY_A) + i));
+                        t.add(static_cast<char32_t>('a' + i), letter, 0);
+                        t.add(static_cast<char32_t>('A' + i), letter, Internal::kModShift);
+                    }
+                    static const char shiftedDigits[10] = {')', '!', '@', '#', '$', '%', '^', '&', '*', '('};
+                    for (int i = 0; i < 10; ++i)
+                    {
+                        uint32_t digit = code(static_cast<KeyCode>(static_cast<int>(KeyCode::KEY_0) + i));
+                        t.add(static_cast<char32_t>('0' + i), digit, 0);
+                        t.add(static_cast<char32_t>(shiftedDigits[i]), digit, Internal::kModShift);
+                    }
+                    struct SymbolKey
+                    {
+                        char plain;
+                        char shifted;
+                        KeyCode key;
+                    };
+                    static const SymbolKey symbols[] = {
+                        {',', '<', KeyCode::KEY_COMMA},
+                        {'.', '>', KeyCode::KEY_PERIOD},
+                        {';', ':', KeyCode::KEY_SEMICOLON},
+                        {'\'', '"', KeyCode::KEY_APOSTROPHE},
+                        {'/', '?', KeyCode::KEY_SLASH},
+                        {'\\', '|', KeyCode::KEY_BACKSLASH},
+                    };
+                    for (const SymbolKey &symbol : symbols)
+                    {
+                        t.add(static_cast<char32_t>(symbol.plain), code(symbol.key), 0);
+                        t.add(static_cast<char32_t>(symbol.shifted), code(symbol.key), Internal::kModShift);
+                    }
+                    t.add(U' ', code(KeyCode::KEY_SPACE), 0);
+                    t.add(U'\n', code(KeyCode::KEY_ENTER), 0);
+                    t.add(U'\t', code(KeyCode::KEY_TAB), 0);
+                    return t;
+                }();
+                return table;
+            }
+        } // namespace
+
+        void Open()
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            if (!d.events)
+            {
+                d.events.reset(new InputEvent[kDefaultCapacity]);
+                d.capacity = kDefaultCapacity;
+            }
+        }
+
+        bool Active()
+        {
+            return g_active.load(std::memory_order_relaxed);
+        }
+
+        void SetActive(bool active)
+        {
+            g_active.store(active, std::memory_order_relaxed);
+        }
+
+        bool IsKeyPressed(KeyCode key)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            return d.keys.test(static_cast<size_t>(key));
+        }
+
+        void KeyDown(KeyCode key)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.setKey(key, true);
+        }
+
+        void KeyUp(KeyCode key)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.setKey(key, false);
+        }
+
+        void TypeText(std::string_view text)
+        {
+            const uint32_t modifierCodes[Internal::kModifierCount] = {
+                static_cast<uint32_t>(KeyCode::KEY_SHIFT) + 1, 0};
+
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            Internal::typeKeystrokes(
+                text, usKeystrokeTable(), modifierCodes,
+                [&](uint32_t code, bool down)
+                { d.setKey(static_cast<KeyCode>(code - 1), down); },
+                [](char32_t)
+                { return Internal::Keystroke{0, 0, false}; });
+        }
+
+        void MouseButtonDown(MouseButton button)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.record(InputEvent::Button(button, true));
+        }
+
+        void MouseButtonUp(MouseButton button)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.record(InputEvent::Button(button, false));
+        }
+
+        Point GetCursorPosition()
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            return d.cursor;
+        }
+
+        void SetCursorPosition(const Point &pos)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            // The log records where the cursor went, which is what a replay reproduces
+            d.cursor = d.clamp(pos);
+            d.record(InputEvent::MoveTo(d.cursor));
+        }
+
+        void MoveCursor(int dx, int dy)
+        {
+            Desktop &d = desktop();
+            std::lock_guard<std::mutex> lock(d.mutex);
+            Point from = d.cursor;
+            d.cursor = d.clamp(Point{from.x + dx, from.y + dy});
+            d.record(InputEvent::MoveBy(d.cursor.x - from.x, d.cursor.y - from.y));
+        }
+    } // namespace NullImpl
+
+    void ResetNullBackend(int width, int height, size_t capacity)
+    {
+        NullImpl::Desktop &d = NullImpl::desktop();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        d.width = std::max(width, 1);
+        d.height = std::max(height, 1);
+        d.cursor = Point{0, 0};
+        d.keys.reset();
+        if (d.capacity != capacity || !d.events)
+        {
+            d.events.reset(new InputEvent[capacity]);
+            d.capacity = capacity;
+        }
+        d.count = 0;
+        d.dropped = 0;
+    }
+
+    std::vector<InputEvent> GetNullBackendEvents()
+    {
+        NullImpl::Desktop &d = NullImpl::desktop();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        return std::vector<InputEvent>(d.events.get(), d.events.get() + d.count);
+    }
+
+    size_t GetNullBackendDropped()
+    {
+        NullImpl::Desktop &d = NullImpl::desktop();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        return d.dropped;
+    }
+
+} // namespace CrossInput
@@ -1,26 +1,118 @@
-#include "../platform/platform_detect.h"
+#include "../platform_detect.h"
 
 // Stub implementation for unsupported platforms
 #if !defined(CROSSINPUT_WINDOWS) && !defined(CROSSINPUT_LINUX)
 
-#include "../../include/CrossInput.h"
+#include "../../../include/CrossInput.h"
+#include "../../core/daemon_server.h"
+#include "../../core/event_capture.h"
+#include "../../core/input_sequence.h"
+#include "null_backend.h"
+#include <iterator>
 
 namespace CrossInput
 {
 
-    bool IsKeyPressed(KeyCode) { return false; }
-    void KeyDown(KeyCode) {}
-    void KeyUp(KeyCode) {}
-    void KeyPress(KeyCode) {}
-    void KeyCombination(const std::initializer_list<KeyCode> &) {}
-    void MouseButtonDown(MouseButton) {}
-    void MouseButtonUp(MouseButton) {}
-    void MouseClick(MouseButton) {}
-    Point GetCursorPosition() { return Point{0, 0}; }
-    void SetCursorPosition(const Point &) {}
-    void MoveCursor(int, int) {}
+    // Only Backend::Null does anything here
+    bool IsKeyPressed(KeyCode key) { return NullImpl::Active() && NullImpl::IsKeyPressed(key); }
+
+    void KeyDown(KeyCode key)
+    {
+        if (NullImpl::Active())
+            NullImpl::KeyDown(key);
+    }
+
+    void KeyUp(KeyCode key)
+    {
+        if (NullImpl::Active())
+            NullImpl::KeyUp(key);
+    }
+
+    void KeyPress(KeyCode key)
+    {
+        KeyDown(key);
+        KeyUp(key);
+    }
+
+    void KeyCombination(const std::initializer_list<KeyCode> &keys)
+    {
+        for (KeyCode key : keys)
+            KeyDown(key);
+        for (auto it = std::rbegin(keys); it != std::rend(keys); ++it)
+            KeyUp(*it);
+    }
+
+    void TypeText(std::string_view utf8)
+    {
+        if (NullImpl::Active())
+            NullImpl::TypeText(utf8);
+    }
+
+    bool PasteText(std::string_view, const PasteOptions &)
+    {
+        // Only the X selection is implemented
+        return false;
+    }
+
+    void MouseButtonDown(MouseButton button)
+    {
+        if (NullImpl::Active())
+            NullImpl::MouseButtonDown(button);
+    }
+
+    void MouseButtonUp(MouseButton button)
+    {
+        if (NullImpl::Active())
+            NullImpl::MouseButtonUp(button);
+    }
+
+    void MouseClick(MouseButton button)
+    {
+        MouseButtonDown(button);
+        MouseButtonUp(button);
+    }
+
+    Point GetCursorPosition() { return NullImpl::Active() ? NullImpl::GetCursorPosition() : Point{0, 0}; }
+
+    void SetCursorPosition(const Point &pos)
+    {
+        if (NullImpl::Active())
+            NullImpl::SetCursorPosition(pos);
+    }
+
+    void MoveCursor(int dx, int dy)
+    {
+        if (NullImpl::Active())
+            NullImpl::MoveCursor(dx, dy);
+    }
+
+    bool Sync(int) { return NullImpl::Active(); }
+
+    void SetReconnectPolicy(const ReconnectPolicy &) {}
+    bool UseEisConnection(int) { return false; }
+    std::string DefaultDaemonSocket() { return std::string(); }
+    bool ConnectDaemon(const std::string &) { return false; }
+
+    bool SetBackend(Backend backend)
+    {
+        if (backend == Backend::Null)
+            NullImpl::Open();
+        else if (backend != Backend::Auto)
+            return false;
+        NullImpl::SetActive(backend == Backend::Null);
+        return true;
+    }
+
+    Backend GetBackend() { return NullImpl::Active() ? Backend::Null : Backend::Auto; }
     std::string GetPlatformName() { return "Unsupported"; }
 
+    namespace Internal
+    {
+        std::unique_ptr<CaptureSource> startCapture(CaptureSink &) { return nullptr; }
+        std::unique_ptr<DaemonServer> startDaemonServer(const std::string &, Backend) { return nullptr; }
+        std::shared_ptr<const PreparedSequence> prepareSequence(Backend, const InputEvent *, size_t) { return nullptr; }
+    } // namespace Internal
+
 } // namespace CrossInput
 
 #endif
@@ -4,12 +4,34 @@
 
 #include "../../../include/CrossInput.h"
 #include "windows_keycodes.h"
+#include "../../core/daemon_server.h"
+#include "../../core/event_capture.h"
+#include "../../core/input_sequence.h"
+#include "../../core/stats.h"
+#include "../../core/text_input.h"
+#include "../stub/null_backend.h"
+#include <atomic>
+#include <bitset>
+#include <thread>
+#include <vector>
 
 namespace CrossInput
 {
+    namespace
+    {
+        // SendInput, timed and checked for GetStats
+        void sendInputs(INPUT *inputs, UINT count)
+        {
+            Internal::FlushTimer timer;
+            if (SendInput(count, inputs, sizeof(INPUT)) != count)
+                Internal::markStatFailure();
+        }
+    } // namespace
 
     bool IsKeyPressed(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::IsKeyPressed);
+        CROSSINPUT_NULL_DISPATCH(IsKeyPressed(key));
         int vk = Internal::keycode_to_vk(key);
         if (vk == 0)
             return false;
@@ -20,6 +42,8 @@ namespace CrossInput
 
     void KeyDown(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::KeyDown);
+        CROSSINPUT_NULL_DISPATCH(KeyDown(key));
         int vk = Internal::keycode_to_vk(key);
         if (vk == 0)
             return;
@@ -28,11 +52,13 @@ namespace CrossInput
         input.type = INPUT_KEYBOARD;
         input.ki.wVk = static_cast<WORD>(vk);
         input.ki.dwFlags = 0; // Key down
-        SendInput(1, &input, sizeof(INPUT));
+        sendInputs(&input, 1);
     }
 
     void KeyUp(KeyCode key)
     {
+        Internal::StatScope stat(StatOp::KeyUp);
+        CROSSINPUT_NULL_DISPATCH(KeyUp(key));
         int vk = Internal::keycode_to_vk(key);
         if (vk == 0)
             return;
@@ -41,7 +67,7 @@ namespace CrossInput
         input.type = INPUT_KEYBOARD;
         input.ki.wVk = static_cast<WORD>(vk);
         input.ki.dwFlags = KEYEVENTF_KEYUP;
-        SendInput(1, &input, sizeof(INPUT));
+        sendInputs(&input, 1);
     }
 
     void KeyPress(KeyCode key)
@@ -65,20 +91,105 @@ namespace CrossInput
         }
     }
 
+    void TypeText(std::string_view utf8)
+    {
+        Internal::StatScope stat(StatOp::TypeText);
+        CROSSINPUT_NULL_DISPATCH(TypeText(utf8));
+        // Layout-derived keystrokes are cached per thread until the layout changes
+        static thread_local HKL cachedLayout = nullptr;
+        static thread_local Internal::KeystrokeTable table;
+
+        HKL layout = GetKeyboardLayout(0);
+        if (layout != cachedLayout)
+        {
+            table.clear();
+            cachedLayout = layout;
+        }
+
+        std::vector<INPUT> inputs;
+        inputs.reserve(utf8.size() * 2 + 4);
+
+        auto pushUnicode = [&](WCHAR unit)
+        {
+            INPUT input = {};
+            input.type = INPUT_KEYBOARD;
+            input.ki.wScan = unit;
+            input.ki.dwFlags = KEYEVENTF_UNICODE;
+            inputs.push_back(input);
+            input.ki.dwFlags = KEYEVENTF_UNICODE | KEYEVENTF_KEYUP;
+            inputs.push_back(input);
+        };
+
+        // AltGr is right Alt; Windows adds the implied Ctrl on layouts that have AltGr
+        const uint32_t modifierCodes[Internal::kModifierCount] = {VK_SHIFT, VK_RMENU};
+
+        Internal::typeKeystrokes(
+            utf8, table, modifierCodes,
+            [&](uint32_t vk, bool down)
+            {
+                INPUT input = {};
+                input.type = INPUT_KEYBOARD;
+                input.ki.wVk = static_cast<WORD>(vk);
+                input.ki.dwFlags = down ? 0 : KEYEVENTF_KEYUP;
+                inputs.push_back(input);
+            },
+            [&](char32_t cp)
+            {
+                if (cp <= 0xFFFF)
+                {
+                    SHORT scan = VkKeyScanExW(static_cast<WCHAR>(cp), layout);
+                    BYTE state = HIBYTE(scan);
+                    // Accept plain, Shift and AltGr (Ctrl+Alt) keystrokes only
+                    if (scan != -1 && (state & 6) != 2 && (state & 6) != 4)
+                    {
+                        uint8_t modifiers = 0;
+                        if (state & 1)
+                            modifiers |= Internal::kModShift;
+                        if ((state & 6) == 6)
+                            modifiers |= Internal::kModAltGr;
+                        table.add(cp, LOBYTE(scan), modifiers);
+                        return table.lookup(cp);
+                    }
+                    pushUnicode(static_cast<WCHAR>(cp));
+                }
+                else
+                {
+                    // Outside the BMP: send the UTF-16 surrogate pair
+                    char32_t v = cp - 0x10000;
+                    pushUnicode(static_cast<WCHAR>(0xD800 + (v >> 10)));
+                    pushUnicode(static_cast<WCHAR>(0xDC00 + (v & 0x3FF)));
+                }
+                return Internal::Keystroke{0, 0, false};
+            });
+
+        if (!inputs.empty())
+            sendInputs(inputs.data(), static_cast<UINT>(inputs.size()));
+    }
+
+    bool PasteText(std::string_view, const PasteOptions &)
+    {
+        // Only the X selection is implemented
+        return false;
+    }
+
     void MouseButtonDown(MouseButton button)
     {
+        Internal::StatScope stat(StatOp::MouseButtonDown);
+        CROSSINPUT_NULL_DISPATCH(MouseButtonDown(button));
         INPUT input = {};
         input.type = INPUT_MOUSE;
         input.mi.dwFlags = Internal::mouse_button_to_down_flag(button);
-        SendInput(1, &input, sizeof(INPUT));
+        sendInputs(&input, 1);
     }
 
     void MouseButtonUp(MouseButton button)
     {
+        Internal::StatScope stat(StatOp::MouseButtonUp);
+        CROSSINPUT_NULL_DISPATCH(MouseButtonUp(button));
         INPUT input = {};
         input.type = INPUT_MOUSE;
         input.mi.dwFlags = Internal::mouse_button_to_up_flag(button);
-        SendInput(1, &input, sizeof(INPUT));
+        sendInputs(&input, 1);
     }
 
     void MouseClick(MouseButton button)
@@ -89,6 +200,8 @@ namespace CrossInput
 
     Point GetCursorPosition()
     {
+        Internal::StatScope stat(StatOp::GetCursorPosition);
+        CROSSINPUT_NULL_DISPATCH(GetCursorPosition());
         POINT pt;
         if (GetCursorPos(&pt))
         {
@@ -99,20 +212,248 @@ namespace CrossInput
 
     void SetCursorPosition(const Point &pos)
     {
+        Internal::StatScope stat(StatOp::SetCursorPosition);
+        CROSSINPUT_NULL_DISPATCH(SetCursorPosition(pos));
         SetCursorPos(static_cast<int>(pos.x), static_cast<int>(pos.y));
     }
 
     void MoveCursor(int dx, int dy)
     {
+        Internal::StatScope stat(StatOp::MoveCursor);
+        CROSSINPUT_NULL_DISPATCH(MoveCursor(dx, dy));
         Point current = GetCursorPosition();
         SetCursorPosition(Point{current.x + dx, current.y + dy});
     }
 
+    bool Sync(int)
+    {
+        // SendInput returns once the events are in the system input queue;
+        // there is no later acknowledgement to wait for
+        return true;
+    }
+
+    void SetReconnectPolicy(const ReconnectPolicy &) {}
+
+    bool UseEisConnection(int)
+    {
+        return false;
+    }
+
+    // The injector daemon relies on memfd and eventfd, which are Linux-only
+    std::string DefaultDaemonSocket()
+    {
+        return std::string();
+    }
+
+    bool ConnectDaemon(const std::string &)
+    {
+        return false;
+    }
+
+    bool SetBackend(Backend backend)
+    {
+        if (backend == Backend::Null)
+            NullImpl::Open();
+        else if (backend != Backend::Auto)
+            return false;
+        NullImpl::SetActive(backend == Backend::Null);
+        return true;
+    }
+
+    Backend GetBackend()
+    {
+        return NullImpl::Active() ? Backend::Null : Backend::Auto;
+    }
+
     std::string GetPlatformName()
     {
         return "Windows";
     }
 
+    namespace Internal
+    {
+        namespace
+        {
+            // Low-level hook procedures get no user pointer, so the sink of the one
+            // capturing stream is kept here. The hooks run on the capture thread,
+            // which is therefore the ring's only producer.
+            std::atomic<CaptureSink *> g_captureSink{nullptr};
+            std::bitset<256> g_keysDown; // filters autorepeat, which LL hooks report as key downs
+
+            LRESULT CALLBACK keyboardHook(int code, WPARAM wParam, LPARAM lParam)
+            {
+                CaptureSink *sink = g_captureSink.load(std::memory_order_acquire);
+                if (code == HC_ACTION && sink)
+                {
+                    auto *info = reinterpret_cast<const KBDLLHOOKSTRUCT *>(lParam);
+                    bool down = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+                    KeyCode key;
+                    if (vk_to_keycode(static_cast<int>(info->vkCode), key) && g_keysDown[info->vkCode & 0xFF] != down)
+                    {
+                        g_keysDown[info->vkCode & 0xFF] = down;
+                        sink->push(InputEvent::Key(key, down), captureTimestamp());
+                        sink->flush();
+                    }
+                }
+                return CallNextHookEx(nullptr, code, wParam, lParam);
+            }
+
+            LRESULT CALLBACK mouseHook(int code, WPARAM wParam, LPARAM lParam)
+            {
+                CaptureSink *sink = g_captureSink.load(std::memory_order_acquire);
+                if (code == HC_ACTION && sink)
+                {
+                    auto *info = reinterpret_cast<const MSLLHOOKSTRUCT *>(lParam);
+                    auto timestamp = captureTimestamp();
+                    switch (wParam)
+                    {
+                    case WM_MOUSEMOVE:
+                        sink->push(InputEvent::MoveTo({static_cast<int>(info->pt.x), static_cast<int>(info->pt.y)}),
+                                   timestamp);
+                        break;
+                    case WM_LBUTTONDOWN:
+                    case WM_LBUTTONUP:
+                        sink->push(InputEvent::Button(MouseButton::Left, wParam == WM_LBUTTONDOWN), timestamp);
+                        break;
+                    case WM_RBUTTONDOWN:
+                    case WM_RBUTTONUP:
+                        sink->push(InputEvent::Button(MouseButton::Right, wParam == WM_RBUTTONDOWN), timestamp);
+                        break;
+                    case WM_MBUTTONDOWN:
+                    case WM_MBUTTONUP:
+                        sink->push(InputEvent::Button(MouseButton::Middle, wParam == WM_MBUTTONDOWN), timestamp);
+                        break;
+                    default:
+                        return CallNextHookEx(nullptr, code, wParam, lParam);
+                    }
+                    sink->flush();
+                }
+                return CallNextHookEx(nullptr, code, wParam, lParam);
+            }
+
+            // Low-level hooks are called on the installing thread's message loop
+            class HookCapture : public CaptureSource
+            {
+            public:
+                HookCapture()
+                {
+                    std::atomic<bool> ready{false};
+                    thread_ = std::thread([this, &ready]
+                                          {
+                        threadId_ = GetCurrentThreadId();
+                        HHOOK keyboard = SetWindowsHookExW(WH_KEYBOARD_LL, keyboardHook, GetModuleHandleW(nullptr), 0);
+                        HHOOK mouse = SetWindowsHookExW(WH_MOUSE_LL, mouseHook, GetModuleHandleW(nullptr), 0);
+                        // Create the message queue before the constructor can post WM_QUIT to it
+                        MSG msg;
+                        PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+                        ready.store(true, std::memory_order_release);
+
+                        while (GetMessageW(&msg, nullptr, 0, 0) > 0)
+                        {
+                        }
+
+                        if (keyboard)
+                            UnhookWindowsHookEx(keyboard);
+                        if (mouse)
+                            UnhookWindowsHookEx(mouse); });
+
+                    while (!ready.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+                }
+
+                ~HookCapture() override
+                {
+                    PostThreadMessageW(threadId_, WM_QUIT, 0, 0);
+                    thread_.join();
+                    g_keysDown.reset();
+                    g_captureSink.store(nullptr, std::memory_order_release);
+                }
+
+            private:
+                std::thread thread_;
+                DWORD threadId_ = 0;
+            };
+        } // namespace
+
+        std::unique_ptr<CaptureSource> startCapture(CaptureSink &sink)
+        {
+            CaptureSink *expected = nullptr;
+            if (!g_captureSink.compare_exchange_strong(expected, &sink))
+                return nullptr; // another EventStream is already capturing
+
+            return std::unique_ptr<CaptureSource>(new HookCapture());
+        }
+
+        std::unique_ptr<DaemonServer> startDaemonServer(const std::string &, Backend)
+        {
+            return nullptr;
+        }
+
+        namespace
+        {
+            // An InputSequence of keys and buttons as one SendInput batch.
+            // Virtual-key codes do not depend on the layout, so it never goes stale.
+            class PreparedWindowsSequence : public PreparedSequence
+            {
+            public:
+                explicit PreparedWindowsSequence(std::vector<INPUT> inputs) : inputs_(std::move(inputs)) {}
+
+                bool play() const override
+                {
+                    if (!inputs_.empty())
+                        sendInputs(const_cast<INPUT *>(inputs_.data()), static_cast<UINT>(inputs_.size()));
+                    return true;
+                }
+
+            private:
+                std::vector<INPUT> inputs_;
+            };
+        } // namespace
+
+        std::shared_ptr<const PreparedSequence> prepareSequence(Backend backend, const InputEvent *events,
+                                                                size_t count)
+        {
+            if (backend != Backend::Auto)
+                return nullptr;
+
+            std::vector<INPUT> inputs;
+            inputs.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                INPUT input = {};
+                switch (events[i].type)
+                {
+                case EventType::KeyDown:
+                case EventType::KeyUp:
+                {
+                    int vk = keycode_to_vk(events[i].key);
+                    if (vk == 0)
+                        continue;
+                    input.type = INPUT_KEYBOARD;
+                    input.ki.wVk = static_cast<WORD>(vk);
+                    input.ki.dwFlags = events[i].type == EventType::KeyUp ? KEYEVENTF_KEYUP : 0;
+                    break;
+                }
+                case EventType::MouseButtonDown:
+                    input.type = INPUT_MOUSE;
+                    input.mi.dwFlags = mouse_button_to_down_flag(events[i].button);
+                    break;
+                case EventType::MouseButtonUp:
+                    input.type = INPUT_MOUSE;
+                    input.mi.dwFlags = mouse_button_to_up_flag(events[i].button);
+                    break;
+                case EventType::SetCursorPosition:
+                case EventType::MoveCursor:
+                    // The cursor moves through SetCursorPos, which SendInput cannot batch
+                    return nullptr;
+                }
+                inputs.push_back(input);
+            }
+            return std::make_shared<PreparedWindowsSequence>(std::move(inputs));
+        }
+
+    } // namespace Internal
+
 } // namespace CrossInput
 
 #endif // CROSSINPUT_WINDOWS
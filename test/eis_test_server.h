@@ -0,0 +1,321 @@
+#pragma once
+
+// An in-process EIS server for exercising Backend::Wayland without a portal or
+// compositor. Hand the backend a client socket with
+// CrossInput::UseEisConnection(server.addClient()).
+
+#include <libeis.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <initializer_list>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace TestEis
+{
+    struct Event
+    {
+        enum Type
+        {
+            Key,            // code = evdev key
+            Button,         // code = evdev button
+            Motion,         // x, y = relative delta
+            MotionAbsolute, // x, y = position
+        };
+
+        Type type;
+        uint32_t code;
+        bool press;
+        double x;
+        double y;
+    };
+
+    // Everything a device sent between two ei_device_frame calls
+    struct Frame
+    {
+        std::vector<Event> events;
+        uint64_t deviceTimeUs; // the timestamp the client put on the frame
+        std::chrono::steady_clock::time_point received;
+    };
+
+    // Serves a single client one seat with a keyboard and an absolute +
+    // relative pointer spanning `width` x `height`, resumed as soon as the
+    // client binds them. libeis runs on its own thread so the client may
+    // block on round trips. The keyboard carries no keymap unless one is set.
+    class Server
+    {
+    public:
+        // With `record` false only frames are counted, for benchmarks
+        explicit Server(bool record = true, uint32_t width = 1920, uint32_t height = 1080)
+            : eis_(eis_new(nullptr)), stop_fd_(eventfd(0, EFD_CLOEXEC)), wake_fd_(eventfd(0, EFD_CLOEXEC)),
+              record_(record), width_(width), height_(height)
+        {
+            if (!eis_ || stop_fd_ < 0 || wake_fd_ < 0 || eis_setup_backend_fd(eis_) != 0)
+                return;
+            thread_ = std::thread([this]
+                                  { run(); });
+        }
+
+        ~Server()
+        {
+            if (thread_.joinable())
+            {
+                uint64_t one = 1;
+                ssize_t ignored = write(stop_fd_, &one, sizeof(one));
+                (void)ignored;
+                thread_.join();
+            }
+            for (eis_device *device : devices_)
+                eis_device_unref(device);
+            if (seat_)
+                eis_seat_unref(seat_);
+            if (eis_)
+                eis_unref(eis_);
+            if (stop_fd_ >= 0)
+                close(stop_fd_);
+            if (wake_fd_ >= 0)
+                close(wake_fd_);
+        }
+
+        Server(const Server &) = delete;
+        Server &operator=(const Server &) = delete;
+
+        bool isValid() const { return thread_.joinable(); }
+
+        // The client end of a new connection; pass it to CrossInput::UseEisConnection
+        int addClient()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return eis_backend_fd_add_client(eis_);
+        }
+
+        // XKB keymap (text format) for the keyboard; call before addClient
+        void setKeymap(std::string keymap)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            keymap_ = std::move(keymap);
+        }
+
+        // Removes the bound keyboard and adds a new one carrying `keymap`, as
+        // a compositor does when the layout changes. Returns once both are sent.
+        void replaceKeyboard(std::string keymap)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            keymap_ = std::move(keymap);
+            const uint64_t request = ++replacements_requested_;
+            uint64_t one = 1;
+            ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+            (void)ignored;
+            replaced_.wait(lock, [&]
+                           { return replacements_done_ >= request; });
+        }
+
+        std::vector<Frame> frames()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return frames_;
+        }
+
+        uint64_t frameCount() const { return frame_count_.load(std::memory_order_relaxed); }
+
+    private:
+        void run()
+        {
+            pollfd fds[3] = {{eis_get_fd(eis_), POLLIN, 0}, {stop_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+            while (!(fds[1].revents & POLLIN))
+            {
+                if (poll(fds, 3, -1) < 0)
+                    continue;
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (fds[2].revents & POLLIN)
+                {
+                    uint64_t count;
+                    ssize_t ignored = read(wake_fd_, &count, sizeof(count));
+                    (void)ignored;
+                    swapKeyboard();
+                }
+                eis_dispatch(eis_);
+                eis_event *event;
+                while ((event = eis_get_event(eis_)) != nullptr)
+                {
+                    handleEvent(event);
+                    eis_event_unref(event);
+                }
+            }
+        }
+
+        // Call with the mutex held
+        void handleEvent(eis_event *event)
+        {
+            switch (eis_event_get_type(event))
+            {
+            case EIS_EVENT_CLIENT_CONNECT:
+            {
+                eis_client *client = eis_event_get_client(event);
+                eis_client_connect(client);
+                seat_ = eis_client_new_seat(client, "test seat");
+                eis_seat_configure_capability(seat_, EIS_DEVICE_CAP_KEYBOARD);
+                eis_seat_configure_capability(seat_, EIS_DEVICE_CAP_POINTER);
+                eis_seat_configure_capability(seat_, EIS_DEVICE_CAP_POINTER_ABSOLUTE);
+                eis_seat_configure_capability(seat_, EIS_DEVICE_CAP_BUTTON);
+                eis_seat_add(seat_);
+                break;
+            }
+            case EIS_EVENT_SEAT_BIND:
+                if (devices_.empty())
+                {
+                    if (eis_event_seat_has_capability(event, EIS_DEVICE_CAP_KEYBOARD))
+                        addDevice("test keyboard", {EIS_DEVICE_CAP_KEYBOARD});
+                    if (eis_event_seat_has_capability(event, EIS_DEVICE_CAP_POINTER_ABSOLUTE))
+                        addDevice("test pointer",
+                                  {EIS_DEVICE_CAP_POINTER, EIS_DEVICE_CAP_POINTER_ABSOLUTE, EIS_DEVICE_CAP_BUTTON});
+                }
+                break;
+            case EIS_EVENT_KEYBOARD_KEY:
+                push(Event{Event::Key, eis_event_keyboard_get_key(event),
+                           eis_event_keyboard_get_key_is_press(event), 0, 0});
+                break;
+            case EIS_EVENT_BUTTON_BUTTON:
+                push(Event{Event::Button, eis_event_button_get_button(event),
+                           eis_event_button_get_is_press(event), 0, 0});
+                break;
+            case EIS_EVENT_POINTER_MOTION:
+                push(Event{Event::Motion, 0, false, eis_event_pointer_get_dx(event),
+                           eis_event_pointer_get_dy(event)});
+                break;
+            case EIS_EVENT_POINTER_MOTION_ABSOLUTE:
+                push(Event{Event::MotionAbsolute, 0, false, eis_event_pointer_get_absolute_x(event),
+                           eis_event_pointer_get_absolute_y(event)});
+                break;
+            case EIS_EVENT_FRAME:
+                frame_count_.store(frame_count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                if (record_)
+                {
+                    pending_.deviceTimeUs = eis_event_get_time(event);
+                    pending_.received = std::chrono::steady_clock::now();
+                    frames_.push_back(std::move(pending_));
+                    pending_ = Frame{};
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Call with the mutex held
+        void swapKeyboard()
+        {
+            if (keyboard_)
+            {
+                eis_device_remove(keyboard_);
+                for (auto it = devices_.begin(); it != devices_.end(); ++it)
+                {
+                    if (*it == keyboard_)
+                    {
+                        devices_.erase(it);
+                        break;
+                    }
+                }
+                eis_device_unref(keyboard_);
+                keyboard_ = nullptr;
+                addDevice("test keyboard", {EIS_DEVICE_CAP_KEYBOARD});
+            }
+            replacements_done_ = replacements_requested_;
+            replaced_.notify_all();
+        }
+
+        void push(const Event &event)
+        {
+            if (record_)
+                pending_.events.push_back(event);
+        }
+
+        void addDevice(const char *name, std::initializer_list<eis_device_capability> caps)
+        {
+            eis_device *device = eis_seat_new_device(seat_);
+            eis_device_configure_name(device, name);
+            eis_device_configure_type(device, EIS_DEVICE_TYPE_VIRTUAL);
+            for (eis_device_capability cap : caps)
+                eis_device_configure_capability(device, cap);
+            if (needsRegion(caps))
+            {
+                eis_region *region = eis_device_new_region(device);
+                eis_region_set_offset(region, 0, 0);
+                eis_region_set_size(region, width_, height_);
+                eis_region_add(region);
+                eis_region_unref(region);
+            }
+            if (hasKeyboard(caps))
+            {
+                addKeymap(device);
+                keyboard_ = device;
+            }
+            eis_device_add(device);
+            eis_device_resume(device);
+            devices_.push_back(device);
+        }
+
+        // libeis takes the keymap as a file descriptor it maps; the text goes
+        // with its terminating NUL, as compositors send it
+        void addKeymap(eis_device *device)
+        {
+            if (keymap_.empty())
+                return;
+            int fd = memfd_create("test keymap", MFD_CLOEXEC);
+            if (fd < 0)
+                return;
+            const size_t size = keymap_.size() + 1;
+            if (write(fd, keymap_.c_str(), size) == static_cast<ssize_t>(size))
+            {
+                eis_keymap *keymap = eis_device_new_keymap(device, EIS_KEYMAP_TYPE_XKB, fd, size);
+                eis_keymap_add(keymap);
+                eis_keymap_unref(keymap);
+            }
+            close(fd);
+        }
+
+        static bool hasKeyboard(std::initializer_list<eis_device_capability> caps)
+        {
+            for (eis_device_capability cap : caps)
+                if (cap == EIS_DEVICE_CAP_KEYBOARD)
+                    return true;
+            return false;
+        }
+
+        // Absolute pointers need a region to map coordinates into
+        static bool needsRegion(std::initializer_list<eis_device_capability> caps)
+        {
+            for (eis_device_capability cap : caps)
+                if (cap == EIS_DEVICE_CAP_POINTER_ABSOLUTE)
+                    return true;
+            return false;
+        }
+
+        eis *eis_;
+        int stop_fd_;
+        int wake_fd_; // signals a keyboard replacement to run()
+        bool record_;
+        uint32_t width_;
+        uint32_t height_;
+        std::thread thread_;
+        std::mutex mutex_;
+        eis_seat *seat_ = nullptr;
+        std::vector<eis_device *> devices_;
+        eis_device *keyboard_ = nullptr;
+        std::string keymap_;
+        uint64_t replacements_requested_ = 0;
+        uint64_t replacements_done_ = 0;
+        std::condition_variable replaced_;
+        Frame pending_{};
+        std::vector<Frame> frames_;
+        std::atomic<uint64_t> frame_count_{0};
+    };
+} // namespace TestEis
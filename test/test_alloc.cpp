@@ -0,0 +1,165 @@
+/**
+ * CrossInput Allocation Test
+ *
+ * Replaces malloc and operator new for the whole process and checks that the
+ * injection calls make no heap allocations once warmed up. It is a separate
+ * binary from test_crossinput because the counting allocator affects
+ * everything in the process.
+ *
+ * The Null backend is checked everywhere. X11 is checked when a server is reachable,
+ * using keys and relative motion only so the desktop sees no clicks.
+ */
+
+#include "../include/CrossInput.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#define CROSSINPUT_COUNT_MALLOC
+#endif
+
+namespace
+{
+    std::atomic<bool> g_counting{false};
+    std::atomic<size_t> g_allocations{0};
+
+    void noteAllocation()
+    {
+        if (g_counting.load(std::memory_order_relaxed))
+            g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+} // namespace
+
+// C libraries (Xlib, libei) allocate with malloc directly
+#ifdef CROSSINPUT_COUNT_MALLOC
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+
+    void *malloc(size_t size)
+    {
+        noteAllocation();
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        noteAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        noteAllocation();
+        return __libc_realloc(ptr, size);
+    }
+}
+#endif
+
+void *operator new(std::size_t size)
+{
+#ifndef CROSSINPUT_COUNT_MALLOC
+    noteAllocation();
+#endif
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+using CrossInput::InputEvent;
+using CrossInput::KeyCode;
+using CrossInput::MouseButton;
+
+namespace
+{
+    constexpr int kRounds = 100;
+
+    // Runs `calls` once to warm up (first-use connections, thread-local
+    // buffers, Xlib's keymap cache), then kRounds more while counting
+    template <typename Fn>
+    size_t allocationsDuring(Fn calls)
+    {
+        calls();
+        g_allocations.store(0, std::memory_order_relaxed);
+        g_counting.store(true, std::memory_order_relaxed);
+        for (int i = 0; i < kRounds; ++i)
+            calls();
+        g_counting.store(false, std::memory_order_relaxed);
+        return g_allocations.load(std::memory_order_relaxed);
+    }
+
+    void injectKeysAndMotion()
+    {
+        static const InputEvent batch[] = {
+            InputEvent::Key(KeyCode::KEY_F12, true),
+            InputEvent::Key(KeyCode::KEY_F12, false),
+            InputEvent::MoveBy(1, 0),
+            InputEvent::MoveBy(-1, 0),
+        };
+
+        CrossInput::KeyDown(KeyCode::KEY_F12);
+        CrossInput::KeyUp(KeyCode::KEY_F12);
+        CrossInput::MoveCursor(1, 0);
+        CrossInput::MoveCursor(-1, 0);
+        CrossInput::SubmitEvents(batch, sizeof(batch) / sizeof(batch[0]));
+
+        // Translated on the warm-up call for each backend, then only replayed
+        static const CrossInput::InputSequence sequence(batch, sizeof(batch) / sizeof(batch[0]));
+        sequence.Play();
+    }
+
+    void injectEverything()
+    {
+        injectKeysAndMotion();
+        CrossInput::MouseButtonDown(MouseButton::Left);
+        CrossInput::MouseButtonUp(MouseButton::Left);
+    }
+
+    bool check(const char *name, size_t allocations)
+    {
+        if (allocations == 0)
+        {
+            std::printf("%s: PASSED\n", name);
+            return true;
+        }
+        std::printf("%s: FAILED - %zu allocations in %d rounds\n", name, allocations, kRounds);
+        return false;
+    }
+} // namespace
+
+int main()
+{
+    std::printf("=== CrossInput Allocation Test ===\n");
+#ifndef CROSSINPUT_COUNT_MALLOC
+    std::printf("(malloc is not interposed on this platform; counting operator new only)\n");
+#endif
+
+    bool passed = true;
+
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    CrossInput::ResetNullBackend(1920, 1080, 65536);
+    passed &= check("Null backend", allocationsDuring(injectEverything));
+
+    // Sync fails when DISPLAY names no reachable server
+    if (CrossInput::SetBackend(CrossInput::Backend::X11) && CrossInput::Sync())
+        passed &= check("X11 backend", allocationsDuring(injectKeysAndMotion));
+    else
+        std::printf("X11 backend: skipped (no display)\n");
+
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    return passed ? 0 : 1;
+}
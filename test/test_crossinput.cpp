@@ -9,13 +9,54 @@
  */
 
 #include "../include/CrossInput.h"
+#include "../src/core/event_capture.h"
+#include "../src/core/spare_keycode_pool.h"
+#include "../src/core/text_input.h"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <chrono>
 #include <thread>
 
+#ifdef __linux__
+#include "../src/platform/platform_detect.h"
+#include "../src/platform/linux/evdev_device.h"
+#include "../src/platform/linux/daemon_protocol.h"
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Library internals the evdev key state tests reach past the public API
+namespace CrossInput
+{
+    namespace EvdevImpl
+    {
+        bool Available();
+        bool IsKeyPressed(KeyCode key);
+    } // namespace EvdevImpl
+} // namespace CrossInput
+#endif
+#ifdef CROSSINPUT_HAS_LIBEI
+#include <sys/socket.h>
+
+// How the evdev key state resolves keys under the keymap EIS sent
+namespace CrossInput
+{
+    namespace WaylandImpl
+    {
+        bool LayoutEvdevCode(KeyCode key, unsigned int &code);
+    } // namespace WaylandImpl
+} // namespace CrossInput
+#endif
+#ifdef CROSSINPUT_HAS_LIBEIS
+#include "eis_test_server.h"
+#endif
+
 // Test result tracking
 struct TestResult
 {
@@ -174,8 +215,7 @@ void test_SetAndGetCursorPosition()
     CrossInput::Point testPos{200, 300};
     CrossInput::SetCursorPosition(testPos);
 
-    // Small delay to let the system update
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TEST_ASSERT(CrossInput::Sync(), "Sync should confirm the cursor move");
 
     CrossInput::Point newPos = CrossInput::GetCursorPosition();
 
@@ -269,6 +309,117 @@ void test_KeyPress_DoesNotCrash()
     }
 }
 
+void test_TypeText_EmptyDoesNotCrash()
+{
+    // Empty text must not press (or leave pressed) any modifier
+    CrossInput::TypeText("");
+    CrossInput::TypeText(std::string_view());
+    TEST_ASSERT(!CrossInput::IsKeyPressed(CrossInput::KeyCode::KEY_SHIFT),
+                "TypeText should not leave Shift pressed");
+}
+
+// Types `text` on a fresh Null backend and returns the key events it recorded
+static std::vector<CrossInput::InputEvent> typeOnNullBackend(std::string_view text)
+{
+    CrossInput::ResetNullBackend(800, 600, 64);
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    CrossInput::TypeText(text);
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    return events;
+}
+
+static bool isKey(const CrossInput::InputEvent &event, CrossInput::KeyCode key, bool down)
+{
+    return event.key == key &&
+           event.type == (down ? CrossInput::EventType::KeyDown : CrossInput::EventType::KeyUp);
+}
+
+void test_TypeText_HoldsShiftOncePerRun()
+{
+    using CrossInput::KeyCode;
+    std::vector<CrossInput::InputEvent> events = typeOnNullBackend("ABc");
+
+    TEST_ASSERT(events.size() == 8, "Two shifted letters and one plain letter should take 8 events");
+    TEST_ASSERT(isKey(events[0], KeyCode::KEY_SHIFT, true), "Shift should be pressed once before the run");
+    TEST_ASSERT(isKey(events[1], KeyCode::KEY_A, true) && isKey(events[2], KeyCode::KEY_A, false) &&
+                    isKey(events[3], KeyCode::KEY_B, true) && isKey(events[4], KeyCode::KEY_B, false),
+                "Shifted letters should be typed back to back");
+    TEST_ASSERT(isKey(events[5], KeyCode::KEY_SHIFT, false), "Shift should be released once after the run");
+    TEST_ASSERT(isKey(events[6], KeyCode::KEY_C, true) && isKey(events[7], KeyCode::KEY_C, false),
+                "The plain letter should follow without Shift");
+}
+
+void test_TypeText_SkipsUnmappedCodepoints()
+{
+    using CrossInput::KeyCode;
+    // The Null backend types a US layout, which has no euro sign or CJK
+    std::vector<CrossInput::InputEvent> events = typeOnNullBackend("a\u20ACb\u4E2D");
+
+    TEST_ASSERT(events.size() == 4, "Only the mapped characters should be typed");
+    TEST_ASSERT(isKey(events[0], KeyCode::KEY_A, true) && isKey(events[2], KeyCode::KEY_B, true),
+                "Mapped characters should keep their order");
+}
+
+void test_TypeText_RejectsMalformedUtf8()
+{
+    using CrossInput::KeyCode;
+    // A lead byte without its continuation is skipped; the next byte still types
+    std::vector<CrossInput::InputEvent> events = typeOnNullBackend("a\xC3" "b");
+    TEST_ASSERT(events.size() == 4 && isKey(events[2], KeyCode::KEY_B, true),
+                "A truncated sequence should not swallow the following character");
+
+    // Truncated at the end of the text
+    events = typeOnNullBackend("a\xE2\x82");
+    TEST_ASSERT(events.size() == 2, "A sequence cut off by the end of the text should be skipped");
+
+    // Stray continuation bytes and invalid lead bytes
+    events = typeOnNullBackend("\x80\xBF\xF8\xFF");
+    TEST_ASSERT(events.empty(), "Bytes that cannot start a character should be skipped");
+
+    // Overlong encodings of '/', a surrogate, and a value past U+10FFFF
+    events = typeOnNullBackend("\xC0\xAF\xE0\x80\xAF\xF0\x80\x80\xAF\xED\xA0\x80\xF4\x90\x80\x80");
+    TEST_ASSERT(events.empty(), "Overlong forms, surrogates and out-of-range values should not decode");
+
+    // The shortest form of the same character still types
+    events = typeOnNullBackend("/");
+    TEST_ASSERT(events.size() == 2 && isKey(events[0], KeyCode::KEY_SLASH, true), "'/' should type normally");
+}
+
+void test_TypeKeystrokes_NeverResolvesMalformedBytes()
+{
+    // With an empty table every decoded character reaches `unmapped`; bytes that
+    // do not decode must not, or a backend would type U+FFFD for them
+    CrossInput::Internal::KeystrokeTable empty;
+    const uint32_t modifierCodes[CrossInput::Internal::kModifierCount] = {0, 0};
+    std::vector<char32_t> resolved;
+    CrossInput::Internal::typeKeystrokes(
+        "a\xC3" "b\xC0\xAF\xED\xA0\x80\xF4\x90\x80\x80\x80\xEF\xBF\xBD", empty, modifierCodes,
+        [](uint32_t, bool) {},
+        [&](char32_t cp)
+        {
+            resolved.push_back(cp);
+            return CrossInput::Internal::Keystroke{0, 0, false};
+        });
+
+    TEST_ASSERT(resolved.size() == 3, "Only decodable characters should be resolved");
+    TEST_ASSERT(resolved[0] == U'a' && resolved[1] == U'b', "Characters around malformed bytes should survive");
+    TEST_ASSERT(resolved[2] == 0xFFFD, "A literal U+FFFD in the text is still a character");
+}
+
+void test_PasteText_NullBackendSendsNothing()
+{
+    // The Null backend has no clipboard, so nothing is pasted or recorded
+    CrossInput::ResetNullBackend(800, 600, 64);
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    bool pasted = CrossInput::PasteText("hello");
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    TEST_ASSERT(!pasted, "PasteText should fail under the Null backend");
+    TEST_ASSERT(events.empty(), "A failed paste should not send Ctrl+V");
+}
+
 // =============================================================================
 // MOUSE FUNCTION TESTS (Non-Interactive)
 // =============================================================================
@@ -477,6 +628,1351 @@ void test_AllMouseButtons()
     TEST_ASSERT(mouseButtons.size() == 3, "Should have 3 mouse buttons");
 }
 
+// =============================================================================
+// SPARE KEYCODE POOL TESTS
+// =============================================================================
+
+// Keyboard mapping and server in one: keycodes 8-20, of which 18-20 start
+// unused. Requests are logged in the order the pool makes them.
+struct FakeKeymap
+{
+    std::vector<unsigned long> keysyms = std::vector<unsigned long>(21, 0);
+    std::vector<std::string> log;
+
+    FakeKeymap()
+    {
+        for (int keycode = 8; keycode < 18; ++keycode)
+            keysyms[keycode] = 0x61 + keycode;
+    }
+
+    int minKeycode() const { return 8; }
+    int maxKeycode() const { return 20; }
+    bool isUnused(int keycode) const { return keysyms[keycode] == 0; }
+    unsigned long get(int keycode, int) const { return keysyms[keycode]; }
+
+    void sync() { log.push_back("sync"); }
+    void remap(unsigned keycode, unsigned long keysym)
+    {
+        keysyms[keycode] = keysym;
+        log.push_back("remap " + std::to_string(keycode));
+    }
+    void clear(unsigned first, unsigned count)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            keysyms[first + i] = 0;
+        log.push_back("clear " + std::to_string(first) + "+" + std::to_string(count));
+    }
+};
+
+void test_SparePool_EvictsLeastRecentlyUsed()
+{
+    FakeKeymap keymap;
+    CrossInput::Internal::SpareKeycodePool pool;
+    pool.sync(keymap);
+    TEST_ASSERT(pool.size() == 3 && pool.isPooled(18) && pool.isPooled(20) && !pool.isPooled(17),
+                "Only unused keycodes should be pooled");
+
+    pool.beginCall();
+    unsigned a = pool.acquire(keymap, 0x1000001);
+    unsigned b = pool.acquire(keymap, 0x1000002);
+    unsigned c = pool.acquire(keymap, 0x1000003);
+    TEST_ASSERT(a != b && b != c && a != c, "Each keysym should get its own keycode");
+    TEST_ASSERT(pool.acquire(keymap, 0x1000002) == b && keymap.log.size() == 3,
+                "A keysym that is already mapped should not be remapped");
+
+    // b was touched last; a is now the oldest, then c
+    pool.beginCall();
+    TEST_ASSERT(pool.acquire(keymap, 0x1000004) == a, "The least recently used slot should be recycled first");
+    TEST_ASSERT(pool.acquire(keymap, 0x1000005) == c, "The next oldest slot should be recycled next");
+    TEST_ASSERT(pool.acquire(keymap, 0x1000002) == b && keymap.keysyms[b] == 0x1000002,
+                "A recently used slot should survive");
+}
+
+void test_SparePool_SyncsBeforeReusingASlotFromThisCall()
+{
+    FakeKeymap keymap;
+    keymap.keysyms[18] = 0x7A; // leave two spare keycodes
+    CrossInput::Internal::SpareKeycodePool pool;
+    pool.sync(keymap);
+
+    pool.beginCall();
+    pool.acquire(keymap, 0x1000001);
+    pool.acquire(keymap, 0x1000002);
+    TEST_ASSERT(std::count(keymap.log.begin(), keymap.log.end(), "sync") == 0,
+                "Free slots should be mapped without a round trip");
+
+    // Both slots were pressed in this call; the third keysym must wait for them
+    unsigned reused = pool.acquire(keymap, 0x1000003);
+    TEST_ASSERT(keymap.log.size() == 4 && keymap.log[2] == "sync" &&
+                    keymap.log[3] == "remap " + std::to_string(reused),
+                "Reusing a slot from this call should sync before the remap");
+
+    // Slots from an earlier call were already delivered
+    pool.beginCall();
+    pool.acquire(keymap, 0x1000004);
+    TEST_ASSERT(keymap.log.size() == 5 && keymap.log[4].rfind("remap", 0) == 0,
+                "Reusing a slot from an earlier call should not sync");
+}
+
+void test_SparePool_RestoreAllClearsRemappedKeycodes()
+{
+    FakeKeymap keymap;
+    const std::vector<unsigned long> original = keymap.keysyms;
+    CrossInput::Internal::SpareKeycodePool pool;
+    pool.sync(keymap);
+
+    pool.beginCall();
+    for (unsigned long keysym = 0x1000001; keysym <= 0x1000003; ++keysym)
+        pool.acquire(keymap, keysym);
+    TEST_ASSERT(pool.dirty() && keymap.keysyms != original, "Acquiring should remap the server's keycodes");
+
+    keymap.log.clear();
+    pool.restoreAll(keymap);
+    TEST_ASSERT(keymap.keysyms == original, "restoreAll should put back the original keysyms");
+    TEST_ASSERT(keymap.log.size() == 2 && keymap.log[0] == "clear 18+3" && keymap.log[1] == "sync",
+                "Adjacent keycodes should be cleared in one request");
+    TEST_ASSERT(!pool.dirty(), "A restored pool should not need restoring again");
+
+    // Restored slots are free again and start a fresh mapping
+    pool.beginCall();
+    pool.acquire(keymap, 0x1000001);
+    TEST_ASSERT(keymap.log.back().rfind("remap", 0) == 0, "A restored keysym should be remapped on next use");
+}
+
+void test_SparePool_DropsSlotsRemappedByOthers()
+{
+    FakeKeymap keymap;
+    CrossInput::Internal::SpareKeycodePool pool;
+    pool.sync(keymap);
+    pool.beginCall();
+    unsigned keycode = pool.acquire(keymap, 0x1000001);
+
+    // Another client takes the keycode for itself
+    keymap.keysyms[keycode] = 0x7A;
+    pool.sync(keymap);
+    TEST_ASSERT(!pool.isPooled(static_cast<int>(keycode)) && pool.size() == 2,
+                "A slot changed by another client should leave the pool");
+    TEST_ASSERT(pool.acquire(keymap, 0x1000001) != keycode, "The keysym should move to a slot still owned");
+}
+
+// =============================================================================
+// INPUT SEQUENCE TESTS
+// =============================================================================
+
+void test_InputSequence_PlaysEventsInOrder()
+{
+    using CrossInput::KeyCode;
+    CrossInput::InputSequence chord =
+        CrossInput::InputSequence::Chord({KeyCode::KEY_CONTROL, KeyCode::KEY_SHIFT, KeyCode::KEY_T});
+    TEST_ASSERT(chord.Size() == 6, "A chord should press and release every key");
+
+    CrossInput::InputSequence drag = {
+        CrossInput::InputEvent::MoveTo({10, 10}),
+        CrossInput::InputEvent::Button(CrossInput::MouseButton::Left, true),
+        CrossInput::InputEvent::MoveBy(30, 5),
+        CrossInput::InputEvent::Button(CrossInput::MouseButton::Left, false),
+    };
+
+    CrossInput::ResetNullBackend(800, 600, 64);
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    for (int i = 0; i < 3; ++i)
+        chord.Play();
+    drag.Play();
+    CrossInput::Point pos = CrossInput::GetCursorPosition();
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    TEST_ASSERT(events.size() == 22, "Every play should send every event");
+    TEST_ASSERT(events[0].key == KeyCode::KEY_CONTROL && events[2].key == KeyCode::KEY_T &&
+                    events[3].type == CrossInput::EventType::KeyUp && events[3].key == KeyCode::KEY_T &&
+                    events[5].key == KeyCode::KEY_CONTROL,
+                "Chord keys should be released in reverse order");
+    TEST_ASSERT(events[12].key == KeyCode::KEY_CONTROL && events[17].type == CrossInput::EventType::KeyUp,
+                "Replays should repeat the same events");
+    TEST_ASSERT(pos.x == 40 && pos.y == 15, "Motion in a sequence should move the cursor");
+}
+
+// =============================================================================
+// SCHEDULER TESTS
+// =============================================================================
+
+void test_Scheduler_FiresAllEventsInOrder()
+{
+    CrossInput::Scheduler scheduler;
+    auto base = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+
+    // Schedule in reverse to verify deadline ordering; zero moves are harmless
+    for (int i = 19; i >= 0; --i)
+    {
+        scheduler.Schedule(CrossInput::InputEvent::MoveBy(0, 0), base + std::chrono::milliseconds(i));
+    }
+
+    scheduler.Start();
+    scheduler.Wait();
+
+    std::vector<CrossInput::EventTiming> timings = scheduler.GetTimings();
+    TEST_ASSERT(timings.size() == 20, "All scheduled events should fire");
+
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+        TEST_ASSERT(timings[i].achieved >= timings[i].requested, "Events should never fire early");
+        if (i > 0)
+        {
+            TEST_ASSERT(timings[i].requested > timings[i - 1].requested, "Events should fire in deadline order");
+        }
+    }
+}
+
+void test_Scheduler_ReportsTiming()
+{
+    CrossInput::Scheduler scheduler;
+    scheduler.Start();
+
+    // Events scheduled after Start() must be picked up by the running thread
+    for (int i = 0; i < 10; ++i)
+    {
+        scheduler.ScheduleAfter(CrossInput::InputEvent::MoveBy(0, 0), std::chrono::milliseconds(2 + i));
+    }
+    scheduler.Wait();
+
+    CrossInput::TimingReport report = scheduler.GetReport();
+    TEST_ASSERT(report.events == 10, "Report should cover every fired event");
+    TEST_ASSERT(report.p50Error.count() >= 0, "Timing error should not be negative");
+    TEST_ASSERT(report.p50Error <= report.p99Error && report.p99Error <= report.maxError,
+                "Percentiles should be ordered");
+}
+
+void test_Scheduler_StopDropsPending()
+{
+    CrossInput::Scheduler scheduler;
+    scheduler.ScheduleAfter(CrossInput::InputEvent::MoveBy(0, 0), std::chrono::seconds(10));
+    scheduler.Start();
+    scheduler.Stop();
+
+    TEST_ASSERT(scheduler.GetTimings().empty(), "Stopped scheduler should not fire pending events");
+}
+
+void test_Scheduler_RunsWithoutTimerDescriptors()
+{
+#ifndef __linux__
+    std::cout << "(skipped: timerfd is Linux only) ";
+#else
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    CrossInput::ResetNullBackend(800, 600, 64);
+
+    // With the descriptor limit at the next free fd, timerfd_create and eventfd fail
+    rlimit saved = {};
+    getrlimit(RLIMIT_NOFILE, &saved);
+    int next = dup(0);
+    if (next < 0)
+    {
+        std::cout << "(skipped: no free descriptor) ";
+        return;
+    }
+    close(next);
+    rlimit limited = saved;
+    limited.rlim_cur = static_cast<rlim_t>(next);
+    setrlimit(RLIMIT_NOFILE, &limited);
+
+    std::vector<CrossInput::EventTiming> timings;
+    {
+        CrossInput::Scheduler scheduler;
+        scheduler.Start();
+        scheduler.ScheduleAfter(CrossInput::InputEvent::MoveBy(1, 0), std::chrono::milliseconds(5));
+        scheduler.ScheduleAfter(CrossInput::InputEvent::MoveBy(1, 0), std::chrono::milliseconds(10));
+        scheduler.Wait();
+        timings = scheduler.GetTimings();
+    }
+    setrlimit(RLIMIT_NOFILE, &saved);
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    TEST_ASSERT(timings.size() == 2, "The condition variable fallback should still fire every event");
+    TEST_ASSERT(timings[0].achieved >= timings[0].requested && timings[1].achieved >= timings[1].requested,
+                "The fallback should not fire early");
+#endif
+}
+
+void test_Scheduler_VirtualClockFiresAtExactTimes()
+{
+    auto clock = std::make_shared<CrossInput::VirtualClock>();
+    auto start = clock->Now();
+    CrossInput::SchedulerOptions options;
+    options.clock = clock;
+
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    CrossInput::ResetNullBackend(1920, 1080, 1024);
+
+    // A minute of simulated key presses, one per second
+    CrossInput::Scheduler scheduler(options);
+    for (int i = 0; i < 60; ++i)
+    {
+        scheduler.ScheduleAfter(CrossInput::InputEvent::Key(CrossInput::KeyCode::KEY_A, i % 2 == 0),
+                                std::chrono::seconds(i));
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    scheduler.Start();
+    scheduler.Wait();
+    auto wallElapsed = std::chrono::steady_clock::now() - wallStart;
+    scheduler.Stop();
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    std::vector<CrossInput::EventTiming> timings = scheduler.GetTimings();
+    TEST_ASSERT(timings.size() == 60 && events.size() == 60, "Every scheduled event should fire");
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+        TEST_ASSERT(timings[i].requested == start + std::chrono::seconds(i), "Deadlines should be on virtual time");
+        TEST_ASSERT(timings[i].achieved == timings[i].requested, "Virtual time should fire events exactly on time");
+        TEST_ASSERT(events[i].type == (i % 2 == 0 ? CrossInput::EventType::KeyDown : CrossInput::EventType::KeyUp),
+                    "Events should reach the backend in order");
+    }
+    TEST_ASSERT(clock->Now() == start + std::chrono::seconds(59), "The clock should stop at the last deadline");
+    TEST_ASSERT(wallElapsed < std::chrono::seconds(5), "Virtual time should not sleep");
+}
+
+// =============================================================================
+// RECORDING TESTS
+// =============================================================================
+
+const char *kRecordingPath = "test_recording.bin";
+
+void test_Recording_RoundTrip()
+{
+    std::vector<CrossInput::TimedEvent> events = {
+        {CrossInput::InputEvent::Key(CrossInput::KeyCode::KEY_BACKSLASH, true), std::chrono::nanoseconds(0)},
+        {CrossInput::InputEvent::Key(CrossInput::KeyCode::KEY_BACKSLASH, false), std::chrono::microseconds(1500)},
+        {CrossInput::InputEvent::Button(CrossInput::MouseButton::Middle, true), std::chrono::milliseconds(2)},
+        {CrossInput::InputEvent::MoveTo({1920, 1080}), std::chrono::milliseconds(3)},
+        {CrossInput::InputEvent::MoveTo({-5, 7}), std::chrono::milliseconds(3)},
+        {CrossInput::InputEvent::MoveBy(-300, 42), std::chrono::seconds(3600)},
+    };
+
+    {
+        CrossInput::RecordingWriter writer(kRecordingPath);
+        TEST_ASSERT(writer.IsOpen(), "Writer should open the file");
+        for (const auto &event : events)
+        {
+            TEST_ASSERT(writer.Write(event), "Write should succeed");
+        }
+        TEST_ASSERT(writer.Close(), "Close should succeed");
+    }
+
+    CrossInput::RecordingReader reader(kRecordingPath);
+    TEST_ASSERT(reader.IsOpen(), "Reader should map the file");
+
+    CrossInput::TimedEvent decoded;
+    for (const auto &expected : events)
+    {
+        TEST_ASSERT(reader.Next(decoded), "Reader should return every written event");
+        TEST_ASSERT(decoded.event.type == expected.event.type, "Event type should round-trip");
+        TEST_ASSERT(decoded.timestamp == expected.timestamp, "Timestamp should round-trip exactly");
+        TEST_ASSERT(decoded.event.pos.x == expected.event.pos.x && decoded.event.pos.y == expected.event.pos.y,
+                    "Coordinates should round-trip");
+    }
+    TEST_ASSERT(!reader.Next(decoded), "Reader should stop at the end of the file");
+
+    reader.Rewind();
+    TEST_ASSERT(reader.Next(decoded) && decoded.event.key == CrossInput::KeyCode::KEY_BACKSLASH,
+                "Rewind should restart from the first event");
+
+    std::remove(kRecordingPath);
+}
+
+void test_Recording_IsCompact()
+{
+    const int count = 1000;
+    {
+        CrossInput::RecordingWriter writer(kRecordingPath);
+        for (int i = 0; i < count; ++i)
+        {
+            writer.Write({CrossInput::InputEvent::MoveTo({500 + i, 400 - i / 2}), std::chrono::milliseconds(i)});
+        }
+    }
+
+    FILE *file = std::fopen(kRecordingPath, "rb");
+    TEST_ASSERT(file != nullptr, "Recording should exist");
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    std::remove(kRecordingPath);
+
+    // 1 kHz mouse stream: type byte + 3-byte delta + two 1-byte coordinate deltas
+    TEST_ASSERT(size < count * 7, "1 kHz mouse stream should encode in under 7 bytes per event");
+}
+
+void test_Recording_RejectsForeignFiles()
+{
+    FILE *file = std::fopen(kRecordingPath, "wb");
+    TEST_ASSERT(file != nullptr, "Should be able to create a scratch file");
+    std::fputs("not a recording", file);
+    std::fclose(file);
+
+    CrossInput::RecordingReader reader(kRecordingPath);
+    TEST_ASSERT(!reader.IsOpen(), "Reader should reject files without the recording header");
+    std::remove(kRecordingPath);
+
+    CrossInput::RecordingReader missing("does_not_exist.bin");
+    TEST_ASSERT(!missing.IsOpen(), "Reader should fail on missing files");
+}
+
+void test_Recording_ReplayAsFastAsPossible()
+{
+    {
+        CrossInput::RecordingWriter writer(kRecordingPath);
+        for (int i = 0; i < 50; ++i)
+        {
+            writer.Write({CrossInput::InputEvent::MoveBy(0, 0), std::chrono::seconds(i)});
+        }
+    }
+
+    CrossInput::ReplayOptions options;
+    options.speed = 0; // 50 s of recording must not actually wait
+
+    auto start = std::chrono::steady_clock::now();
+    size_t sent = CrossInput::ReplayRecording(kRecordingPath, options);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::remove(kRecordingPath);
+
+    TEST_ASSERT(sent == 50, "Replay should send every recorded event");
+    TEST_ASSERT(elapsed < std::chrono::seconds(5), "Unpaced replay should not sleep");
+}
+
+// =============================================================================
+// PATH SIMPLIFICATION TESTS
+// =============================================================================
+
+// 1 kHz circular trajectory with integer pixel positions
+std::vector<CrossInput::TimedEvent> makeCircleStream(int samples)
+{
+    std::vector<CrossInput::TimedEvent> events;
+    for (int i = 0; i < samples; ++i)
+    {
+        double angle = 2.0 * 3.14159265358979 * i / samples;
+        CrossInput::Point p{800 + static_cast<int>(std::lround(300 * std::cos(angle))),
+                            500 + static_cast<int>(std::lround(300 * std::sin(angle)))};
+        events.push_back({CrossInput::InputEvent::MoveTo(p), std::chrono::milliseconds(i)});
+    }
+    return events;
+}
+
+double distanceToPolyline(const CrossInput::Point &p, const std::vector<CrossInput::TimedEvent> &path)
+{
+    double best = 1e18;
+    for (size_t i = 0; i + 1 < path.size(); ++i)
+    {
+        double ax = path[i].event.pos.x, ay = path[i].event.pos.y;
+        double dx = path[i + 1].event.pos.x - ax, dy = path[i + 1].event.pos.y - ay;
+        double lengthSq = dx * dx + dy * dy;
+        double t = lengthSq > 0 ? ((p.x - ax) * dx + (p.y - ay) * dy) / lengthSq : 0;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        double ex = p.x - (ax + t * dx), ey = p.y - (ay + t * dy);
+        best = std::min(best, std::sqrt(ex * ex + ey * ey));
+    }
+    return best;
+}
+
+void test_SimplifyPath_DropsCollinearPoints()
+{
+    std::vector<CrossInput::TimedEvent> events;
+    for (int i = 0; i < 1000; ++i)
+    {
+        events.push_back({CrossInput::InputEvent::MoveTo({i, 2 * i}), std::chrono::milliseconds(i)});
+    }
+
+    auto simplified = CrossInput::SimplifyPath(events, 0.5);
+    TEST_ASSERT(simplified.size() == 2, "A straight line should reduce to its endpoints");
+    TEST_ASSERT(simplified.back().timestamp == std::chrono::milliseconds(999), "Endpoints keep their timestamps");
+}
+
+void test_SimplifyPath_StaysWithinTolerance()
+{
+    auto events = makeCircleStream(2000);
+    const double tolerance = 1.0;
+
+    for (auto method : {CrossInput::SimplifyMethod::DouglasPeucker, CrossInput::SimplifyMethod::Visvalingam})
+    {
+        auto simplified = CrossInput::SimplifyPath(events, tolerance, method);
+        TEST_ASSERT(simplified.size() * 10 <= events.size(), "Simplification should cut events by 10x");
+
+        if (method == CrossInput::SimplifyMethod::DouglasPeucker)
+        {
+            for (const auto &e : events)
+            {
+                TEST_ASSERT(distanceToPolyline(e.event.pos, simplified) <= tolerance + 1e-9,
+                            "Every original point should stay within tolerance");
+            }
+        }
+    }
+}
+
+void test_SimplifyPath_PreservesRelativeDisplacementAndBarriers()
+{
+    std::vector<CrossInput::TimedEvent> events;
+    int t = 0;
+    for (int i = 0; i < 500; ++i)
+        events.push_back({CrossInput::InputEvent::MoveBy(1, (i % 2) ? 1 : 0), std::chrono::milliseconds(t++)});
+    events.push_back({CrossInput::InputEvent::Button(CrossInput::MouseButton::Left, true), std::chrono::milliseconds(t++)});
+    for (int i = 0; i < 500; ++i)
+        events.push_back({CrossInput::InputEvent::MoveBy(-1, 0), std::chrono::milliseconds(t++)});
+
+    auto simplified = CrossInput::SimplifyPath(events, 1.0);
+
+    // The displacement up to the click and the total displacement must be unchanged
+    int x = 0, y = 0;
+    bool sawClick = false;
+    for (const auto &e : simplified)
+    {
+        if (e.event.type == CrossInput::EventType::MouseButtonDown)
+        {
+            TEST_ASSERT(x == 500 && y == 250, "Cursor position at the click should be preserved");
+            sawClick = true;
+            continue;
+        }
+        x += e.event.pos.x;
+        y += e.event.pos.y;
+    }
+    TEST_ASSERT(sawClick, "Non-cursor events should be kept");
+    TEST_ASSERT(x == 0 && y == 250, "Total relative displacement should be preserved");
+    TEST_ASSERT(simplified.size() < 20, "Relative runs should be simplified too");
+}
+
+void test_PathSimplifier_Streaming()
+{
+    auto events = makeCircleStream(2000);
+    const double tolerance = 1.0;
+
+    CrossInput::PathSimplifier simplifier(tolerance);
+    std::vector<CrossInput::TimedEvent> simplified;
+    for (const auto &e : events)
+        simplifier.Push(e, simplified);
+    simplifier.Finish(simplified);
+
+    TEST_ASSERT(simplified.size() * 10 <= events.size(), "Streaming simplification should cut events by 10x");
+    TEST_ASSERT(simplified.front().timestamp == events.front().timestamp &&
+                    simplified.back().timestamp == events.back().timestamp,
+                "Streaming simplification should keep the endpoints");
+    for (const auto &e : events)
+    {
+        TEST_ASSERT(distanceToPolyline(e.event.pos, simplified) <= tolerance + 1e-9,
+                    "Every original point should stay within tolerance");
+    }
+}
+
+void test_SimplifyRecording()
+{
+    const char *simplifiedPath = "test_recording_simplified.bin";
+    {
+        CrossInput::RecordingWriter writer(kRecordingPath);
+        for (const auto &e : makeCircleStream(2000))
+            writer.Write(e);
+    }
+
+    size_t written = CrossInput::SimplifyRecording(kRecordingPath, simplifiedPath, 1.0);
+    CrossInput::RecordingReader reader(simplifiedPath);
+    size_t read = 0;
+    CrossInput::TimedEvent e;
+    while (reader.Next(e))
+        ++read;
+
+    std::remove(kRecordingPath);
+    std::remove(simplifiedPath);
+
+    TEST_ASSERT(written > 0 && written * 10 <= 2000, "Simplified recording should be 10x smaller");
+    TEST_ASSERT(read == written, "Simplified recording should contain every written event");
+}
+
+// =============================================================================
+// LISTENING TESTS
+// =============================================================================
+
+void test_EventStream_PollAndStop()
+{
+    CrossInput::EventStream stream(64);
+    CrossInput::TimedEvent events[16];
+
+    if (!stream.IsActive())
+    {
+        // No capture source here (no display and /dev/input unreadable): Wait must not block
+        auto start = std::chrono::steady_clock::now();
+        TEST_ASSERT(stream.Wait(events, 16, std::chrono::milliseconds(500)) == 0,
+                    "Inactive stream should not produce events");
+        TEST_ASSERT(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250),
+                    "Wait on an inactive stream should return immediately");
+    }
+    else
+    {
+        size_t count = stream.Wait(events, 16, std::chrono::milliseconds(20));
+        TEST_ASSERT(count <= 16, "Wait should not exceed the batch size");
+    }
+
+    stream.Stop();
+    TEST_ASSERT(!stream.IsActive(), "Stopped stream should be inactive");
+    while (stream.Poll(events, 16) > 0)
+    {
+        // Buffered events stay drainable after Stop
+    }
+    TEST_ASSERT(stream.Poll(events, 16) == 0, "Drained stream should be empty");
+}
+
+void test_CaptureRing_CountsDropsWhenFull()
+{
+    CrossInput::Internal::CaptureSink sink(8);
+    TEST_ASSERT(sink.ring.capacity() == 8, "Capacity should stay at a power of two");
+
+    for (int i = 0; i < 11; ++i)
+        sink.push(CrossInput::InputEvent::MoveTo({i, 0}), std::chrono::nanoseconds(i));
+    TEST_ASSERT(sink.dropped.load() == 3, "Pushes into a full ring should be counted as dropped");
+
+    CrossInput::TimedEvent out[16];
+    size_t count = sink.ring.popBatch(out, 16);
+    TEST_ASSERT(count == 8, "A full ring should hold exactly its capacity");
+    TEST_ASSERT(out[0].event.pos.x == 0 && out[7].event.pos.x == 7,
+                "The oldest events should be kept and the newest dropped");
+
+    // Draining makes room again
+    sink.push(CrossInput::InputEvent::MoveTo({42, 0}), std::chrono::nanoseconds(42));
+    TEST_ASSERT(sink.dropped.load() == 3 && sink.ring.popBatch(out, 16) == 1 && out[0].event.pos.x == 42,
+                "A drained ring should accept events again");
+}
+
+void test_CaptureRing_KeepsOrderAcrossWraparound()
+{
+    // Start a few items short of where the size_t indices overflow, then lap
+    // the 16-slot ring many times with uneven push and pop batches
+    const size_t start = static_cast<size_t>(-1) - 40;
+    CrossInput::Internal::SpscRing<int> ring(16, start);
+
+    int next = 0, expected = 0;
+    int out[16];
+    for (int round = 0; round < 200; ++round)
+    {
+        int pushes = 1 + round % 13;
+        for (int i = 0; i < pushes; ++i)
+        {
+            if (ring.tryPush(next))
+                ++next;
+        }
+
+        size_t count = ring.popBatch(out, 1 + round % 7);
+        for (size_t i = 0; i < count; ++i)
+            TEST_ASSERT(out[i] == expected++, "Items should come out in the order they were pushed");
+    }
+
+    size_t count;
+    while ((count = ring.popBatch(out, 16)) > 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+            TEST_ASSERT(out[i] == expected++, "Items should come out in the order they were pushed");
+    }
+    TEST_ASSERT(expected == next && next > 16 * 40, "Every accepted item should come out exactly once");
+}
+
+// =============================================================================
+// BACKEND TESTS
+// =============================================================================
+
+void test_SetBackend_AutoAlwaysSucceeds()
+{
+    TEST_ASSERT(CrossInput::SetBackend(CrossInput::Backend::Auto), "Auto backend should always be accepted");
+    TEST_ASSERT(CrossInput::GetBackend() != CrossInput::Backend::Uinput, "Auto should never resolve to uinput");
+}
+
+void test_Uinput_EventsReadBackFromDevice()
+{
+    if (!CrossInput::SetBackend(CrossInput::Backend::Uinput))
+    {
+        // /dev/uinput not writable here; nothing to verify
+        TEST_ASSERT(CrossInput::GetBackend() != CrossInput::Backend::Uinput, "Failed SetBackend must not switch");
+        return;
+    }
+
+    // The stream opens device nodes at construction, so start it after the
+    // virtual device exists
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CrossInput::EventStream stream;
+    CrossInput::KeyPress(CrossInput::KeyCode::KEY_SHIFT);
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    if (!stream.IsActive())
+        return;
+
+    bool sawDown = false, sawUp = false;
+    CrossInput::TimedEvent events[16];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!(sawDown && sawUp) && std::chrono::steady_clock::now() < deadline)
+    {
+        size_t n = stream.Wait(events, 16, std::chrono::milliseconds(100));
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (events[i].event.key != CrossInput::KeyCode::KEY_SHIFT)
+                continue;
+            sawDown |= events[i].event.type == CrossInput::EventType::KeyDown;
+            sawUp |= events[i].event.type == CrossInput::EventType::KeyUp;
+        }
+    }
+    TEST_ASSERT(sawDown && sawUp, "Key press on the uinput device should be captured");
+}
+
+void test_Uinput_PreparedSequenceReadsBackFromDevice()
+{
+    if (!CrossInput::SetBackend(CrossInput::Backend::Uinput))
+    {
+        std::cout << "(skipped: /dev/uinput not writable) ";
+        return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CrossInput::EventStream stream;
+    // Played twice: the first Play prepares the frames, the second replays them as they are
+    CrossInput::InputSequence chord = CrossInput::InputSequence::Chord({CrossInput::KeyCode::KEY_SHIFT});
+    chord.Play();
+    chord.Play();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    if (!stream.IsActive())
+    {
+        std::cout << "(skipped: no capture source) ";
+        return;
+    }
+
+    int downs = 0, ups = 0;
+    CrossInput::TimedEvent events[16];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!(downs == 2 && ups == 2) && std::chrono::steady_clock::now() < deadline)
+    {
+        size_t n = stream.Wait(events, 16, std::chrono::milliseconds(100));
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (events[i].event.key != CrossInput::KeyCode::KEY_SHIFT)
+                continue;
+            downs += events[i].event.type == CrossInput::EventType::KeyDown;
+            ups += events[i].event.type == CrossInput::EventType::KeyUp;
+        }
+    }
+    TEST_ASSERT(downs == 2 && ups == 2, "Both plays of the prepared sequence should reach the device");
+}
+
+#ifdef __linux__
+// Writes Left Shift (evdev KEY_LEFTSHIFT) to a virtual keyboard, then waits up
+// to a second for EvdevImpl to report `down`
+static bool evdevShiftReads(CrossInput::Internal::UinputDevice &keyboard, bool down)
+{
+    CrossInput::Internal::EvdevEvent event = {EvdevCodes::EVDEV_EV_KEY, 42, down ? 1 : 0, 0};
+    if (!keyboard.writeFrame(&event, 1))
+        return false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (CrossInput::EvdevImpl::IsKeyPressed(CrossInput::KeyCode::KEY_SHIFT) != down)
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return true;
+}
+#endif
+
+void test_Evdev_KeyStateFollowsUinputKeyboard()
+{
+#ifndef __linux__
+    std::cout << "(skipped: evdev is Linux only) ";
+#else
+    auto keyboard = CrossInput::Internal::UinputDevice::createKeyboardMouse("CrossInput key state test");
+    if (!keyboard)
+    {
+        std::cout << "(skipped: /dev/uinput not writable) ";
+        return;
+    }
+
+    // Give udev time to create the node, then let the hotplug check open it
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    if (!CrossInput::EvdevImpl::Available())
+    {
+        std::cout << "(skipped: /dev/input not readable) ";
+        return;
+    }
+
+    TEST_ASSERT(evdevShiftReads(*keyboard, true), "A key held on the device should read as pressed");
+    TEST_ASSERT(evdevShiftReads(*keyboard, false), "A released key should read as up");
+#endif
+}
+
+void test_Evdev_PicksUpHotpluggedKeyboard()
+{
+#ifndef __linux__
+    std::cout << "(skipped: evdev is Linux only) ";
+#else
+    // Scan first, so the keyboard below can only be found through the inotify watch
+    CrossInput::EvdevImpl::IsKeyPressed(CrossInput::KeyCode::KEY_SHIFT);
+    auto keyboard = CrossInput::Internal::UinputDevice::createKeyboardMouse("CrossInput hotplug test");
+    if (!keyboard)
+    {
+        std::cout << "(skipped: /dev/uinput not writable) ";
+        return;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    if (!CrossInput::EvdevImpl::Available())
+    {
+        std::cout << "(skipped: /dev/input not readable) ";
+        return;
+    }
+    TEST_ASSERT(evdevShiftReads(*keyboard, true), "A keyboard added after the scan should be picked up");
+    TEST_ASSERT(evdevShiftReads(*keyboard, false), "The hotplugged keyboard's release should be seen too");
+#endif
+}
+
+void test_NullBackend_TracksDesktopState()
+{
+    using CrossInput::KeyCode;
+    CrossInput::ResetNullBackend(800, 600, 16);
+    TEST_ASSERT(CrossInput::SetBackend(CrossInput::Backend::Null), "Null backend should always be available");
+    TEST_ASSERT(CrossInput::GetBackend() == CrossInput::Backend::Null, "Null backend should be active");
+
+    CrossInput::KeyDown(KeyCode::KEY_CONTROL);
+    TEST_ASSERT(CrossInput::IsKeyPressed(KeyCode::KEY_CONTROL), "Held key should read as pressed");
+    CrossInput::KeyUp(KeyCode::KEY_CONTROL);
+    TEST_ASSERT(!CrossInput::IsKeyPressed(KeyCode::KEY_CONTROL), "Released key should read as up");
+
+    CrossInput::SetCursorPosition({100, 200});
+    CrossInput::MoveCursor(1000, -50);
+    CrossInput::Point pos = CrossInput::GetCursorPosition();
+    TEST_ASSERT(pos.x == 799 && pos.y == 150, "Cursor should move and clamp to the screen");
+
+    CrossInput::TypeText("Hi");
+    TEST_ASSERT(!CrossInput::IsKeyPressed(KeyCode::KEY_SHIFT), "Shift should be released after the text");
+    TEST_ASSERT(CrossInput::Sync(), "Null backend has nothing to wait for");
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    // Ctrl down/up, two moves, then Shift+H, Shift up, I down/up
+    TEST_ASSERT(events.size() == 10, "Every event should be recorded");
+    TEST_ASSERT(events[4].type == CrossInput::EventType::KeyDown && events[4].key == KeyCode::KEY_SHIFT,
+                "Capital letter should press Shift first");
+    TEST_ASSERT(events[5].key == KeyCode::KEY_H && events[8].key == KeyCode::KEY_I, "Text should map to key codes");
+
+    CrossInput::ResetNullBackend(800, 600, 4);
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    for (int i = 0; i < 6; ++i)
+        CrossInput::MouseClick(CrossInput::MouseButton::Left);
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    TEST_ASSERT(CrossInput::GetNullBackendEvents().size() == 4, "Recording should stop at the capacity");
+    TEST_ASSERT(CrossInput::GetNullBackendDropped() == 8, "Overflow should be counted");
+}
+
+void test_NullBackend_RecordsClampedMoves()
+{
+    CrossInput::ResetNullBackend(800, 600, 16);
+    CrossInput::SetBackend(CrossInput::Backend::Null);
+    CrossInput::SetCursorPosition({-5, 900});
+    CrossInput::MoveCursor(1000, -100);
+    CrossInput::Point pos = CrossInput::GetCursorPosition();
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+
+    TEST_ASSERT(pos.x == 799 && pos.y == 499, "Cursor should clamp to the screen");
+    TEST_ASSERT(events.size() == 2 && events[0].type == CrossInput::EventType::SetCursorPosition &&
+                    events[0].pos.x == 0 && events[0].pos.y == 599,
+                "An absolute move should be recorded at the clamped point");
+    TEST_ASSERT(events[1].type == CrossInput::EventType::MoveCursor && events[1].pos.x == 799 &&
+                    events[1].pos.y == -100,
+                "A relative move should be recorded as the distance actually moved");
+}
+
+void test_Wayland_DeliversToEisServer()
+{
+#ifndef CROSSINPUT_HAS_LIBEIS
+    std::cout << "(skipped: built without libeis) ";
+#else
+    TestEis::Server server;
+    TEST_ASSERT(server.isValid(), "libeis server should start");
+    TEST_ASSERT(CrossInput::UseEisConnection(server.addClient()), "Backend should accept the EIS socket");
+
+    // The libei connection is per thread; this one ends with the thread
+    bool synced = false;
+    std::thread([&]
+                {
+                    CrossInput::SetBackend(CrossInput::Backend::Wayland);
+                    CrossInput::KeyPress(CrossInput::KeyCode::KEY_A);
+                    CrossInput::MouseClick(CrossInput::MouseButton::Left);
+                    CrossInput::SetCursorPosition({100, 200});
+                    synced = CrossInput::Sync();
+                    CrossInput::SetBackend(CrossInput::Backend::Auto);
+                })
+        .join();
+    TEST_ASSERT(synced, "Sync should see the server's pong");
+
+    std::vector<TestEis::Frame> frames = server.frames();
+    TEST_ASSERT(frames.size() == 5, "Each key, button and motion event should arrive in its own frame");
+    TEST_ASSERT(frames[0].events.size() == 1 && frames[0].events[0].type == TestEis::Event::Key &&
+                    frames[0].events[0].code == 30 && frames[0].events[0].press,
+                "KEY_A press should arrive as evdev KEY_A");
+    TEST_ASSERT(frames[3].events[0].type == TestEis::Event::Button && frames[3].events[0].code == 0x110 &&
+                    !frames[3].events[0].press,
+                "Left button release should arrive as BTN_LEFT");
+    TEST_ASSERT(frames[4].events[0].type == TestEis::Event::MotionAbsolute && frames[4].events[0].x == 100 &&
+                    frames[4].events[0].y == 200,
+                "Absolute motion should arrive at the requested position");
+    TEST_ASSERT(frames[0].received <= frames[4].received, "Frames should be recorded in arrival order");
+#endif
+}
+
+#if defined(CROSSINPUT_HAS_LIBEIS) && defined(CROSSINPUT_HAS_XKBCOMMON)
+// A self-contained XKB keymap with just the keys the keymap tests press.
+// German swaps Y and Z and puts '@' on AltGr+Q; US has '@' on Shift+2.
+std::string testKeymap(bool german)
+{
+    std::string symbols = german ? R"(
+        key <AD06> { [ z, Z ] };
+        key <AB01> { [ y, Y ] };
+        key <AD01> { type = "FOUR_LEVEL", [ q, Q, at ] };
+        key <AE02> { [ 2, quotedbl ] };)"
+                                 : R"(
+        key <AB01> { [ z, Z ] };
+        key <AD06> { [ y, Y ] };
+        key <AD01> { [ q, Q ] };
+        key <AE02> { [ 2, at ] };)";
+    return R"(xkb_keymap {
+    xkb_keycodes "test" {
+        minimum = 8;
+        maximum = 255;
+        <AE02> = 11;
+        <AD01> = 24;
+        <AD06> = 29;
+        <LFSH> = 50;
+        <AB01> = 52;
+        <RALT> = 108;
+    };
+    xkb_types "test" {
+        type "ONE_LEVEL" {
+            modifiers = none;
+            level_name[Level1] = "Any";
+        };
+        type "TWO_LEVEL" {
+            modifiers = Shift;
+            map[Shift] = Level2;
+            level_name[Level1] = "Base";
+            level_name[Level2] = "Shift";
+        };
+        type "ALPHABETIC" {
+            modifiers = Shift + Lock;
+            map[Shift] = Level2;
+            map[Lock] = Level2;
+            level_name[Level1] = "Base";
+            level_name[Level2] = "Caps";
+        };
+        type "FOUR_LEVEL" {
+            modifiers = Shift + Mod5;
+            map[Shift] = Level2;
+            map[Mod5] = Level3;
+            map[Shift + Mod5] = Level4;
+            level_name[Level1] = "Base";
+            level_name[Level2] = "Shift";
+            level_name[Level3] = "AltGr";
+            level_name[Level4] = "Shift AltGr";
+        };
+    };
+    xkb_compatibility "test" {
+        interpret Shift_L { action = SetMods(modifiers = Shift); };
+        interpret ISO_Level3_Shift { action = SetMods(modifiers = Mod5); };
+    };
+    xkb_symbols "test" {)" +
+           symbols + R"(
+        key <LFSH> { [ Shift_L ] };
+        key <RALT> { [ ISO_Level3_Shift ] };
+        modifier_map Shift { <LFSH> };
+        modifier_map Mod5 { <RALT> };
+    };
+};
+)";
+}
+
+// (evdev code, press) of every key event the server received, in order
+std::vector<std::pair<uint32_t, bool>> receivedKeys(TestEis::Server &server)
+{
+    std::vector<std::pair<uint32_t, bool>> keys;
+    for (const TestEis::Frame &frame : server.frames())
+        for (const TestEis::Event &event : frame.events)
+            if (event.type == TestEis::Event::Key)
+                keys.emplace_back(event.code, event.press);
+    return keys;
+}
+#endif
+
+void test_Wayland_TypesThroughTheEisKeymap()
+{
+#if !defined(CROSSINPUT_HAS_LIBEIS) || !defined(CROSSINPUT_HAS_XKBCOMMON)
+    std::cout << "(skipped: built without libeis or xkbcommon) ";
+#else
+    TestEis::Server server;
+    TEST_ASSERT(server.isValid(), "libeis server should start");
+    server.setKeymap(testKeymap(true));
+    TEST_ASSERT(CrossInput::UseEisConnection(server.addClient()), "Backend should accept the EIS socket");
+
+    bool synced = false;
+    std::thread([&]
+                {
+                    CrossInput::SetBackend(CrossInput::Backend::Wayland);
+                    CrossInput::TypeText("zZ@");
+                    CrossInput::KeyDown(CrossInput::KeyCode::KEY_Z);
+                    CrossInput::KeyUp(CrossInput::KeyCode::KEY_Z);
+                    synced = CrossInput::Sync();
+                    CrossInput::SetBackend(CrossInput::Backend::Auto);
+                })
+        .join();
+    TEST_ASSERT(synced, "Sync should see the server's pong");
+
+    // German: z is evdev KEY_Y (21), '@' is AltGr (KEY_RIGHTALT, 100) + KEY_Q (16)
+    const std::vector<std::pair<uint32_t, bool>> expected = {
+        {21, true}, {21, false},                            // z
+        {42, true}, {21, true}, {21, false}, {42, false},   // Shift+z
+        {100, true}, {16, true}, {16, false}, {100, false}, // AltGr+q
+        {21, true}, {21, false},                            // KEY_Z
+    };
+    TEST_ASSERT(receivedKeys(server) == expected,
+                "Text and KEY_Z should arrive as the keymap's evdev codes and modifiers");
+#endif
+}
+
+// IsKeyPressed reads evdev nodes from any thread, so it has to find the
+// keymap another thread's libei connection received
+void test_Wayland_KeyStateUsesTheEisKeymap()
+{
+#if !defined(CROSSINPUT_HAS_LIBEIS) || !defined(CROSSINPUT_HAS_XKBCOMMON)
+    std::cout << "(skipped: built without libeis or xkbcommon) ";
+#else
+    TestEis::Server server;
+    TEST_ASSERT(server.isValid(), "libeis server should start");
+    server.setKeymap(testKeymap(true));
+    TEST_ASSERT(CrossInput::UseEisConnection(server.addClient()), "Backend should accept the EIS socket");
+
+    std::thread([&]
+                {
+                    CrossInput::SetBackend(CrossInput::Backend::Wayland);
+                    CrossInput::KeyPress(CrossInput::KeyCode::KEY_Z);
+                    CrossInput::Sync();
+                    CrossInput::SetBackend(CrossInput::Backend::Auto);
+                })
+        .join();
+
+    unsigned int z = 0, y = 0, f1 = 0;
+    TEST_ASSERT(CrossInput::WaylandImpl::LayoutEvdevCode(CrossInput::KeyCode::KEY_Z, z) &&
+                    CrossInput::WaylandImpl::LayoutEvdevCode(CrossInput::KeyCode::KEY_Y, y) &&
+                    CrossInput::WaylandImpl::LayoutEvdevCode(CrossInput::KeyCode::KEY_F1, f1),
+                "The keymap should be available to other threads once used");
+    TEST_ASSERT(z == 21 && y == 44, "Character keys should resolve through the German keymap");
+    TEST_ASSERT(f1 == 59, "Keys without a character should keep the fixed evdev code");
+#endif
+}
+
+void test_Wayland_RebuildsTableForReplacedKeyboard()
+{
+#if !defined(CROSSINPUT_HAS_LIBEIS) || !defined(CROSSINPUT_HAS_XKBCOMMON)
+    std::cout << "(skipped: built without libeis or xkbcommon) ";
+#else
+    TestEis::Server server;
+    TEST_ASSERT(server.isValid(), "libeis server should start");
+    server.setKeymap(testKeymap(true));
+    TEST_ASSERT(CrossInput::UseEisConnection(server.addClient()), "Backend should accept the EIS socket");
+
+    bool synced = false;
+    std::vector<std::pair<uint32_t, bool>> beforeReplacement;
+    std::thread([&]
+                {
+                    CrossInput::SetBackend(CrossInput::Backend::Wayland);
+                    CrossInput::TypeText("z");
+                    CrossInput::Sync();
+                    beforeReplacement = receivedKeys(server);
+
+                    // Sync reads the removal and the new device before the pong
+                    server.replaceKeyboard(testKeymap(false));
+                    CrossInput::Sync();
+                    CrossInput::TypeText("z@");
+                    synced = CrossInput::Sync();
+                    CrossInput::SetBackend(CrossInput::Backend::Auto);
+                })
+        .join();
+    TEST_ASSERT(synced, "Sync should see the server's pong");
+
+    const std::vector<std::pair<uint32_t, bool>> german = {{21, true}, {21, false}};
+    TEST_ASSERT(beforeReplacement == german, "z should use the first keyboard's German keymap");
+
+    std::vector<std::pair<uint32_t, bool>> keys = receivedKeys(server);
+    const std::vector<std::pair<uint32_t, bool>> us = {
+        {44, true}, {44, false},                        // z on evdev KEY_Z
+        {42, true}, {3, true}, {3, false}, {42, false}, // Shift+2
+    };
+    TEST_ASSERT(keys.size() == german.size() + us.size() &&
+                    std::equal(us.begin(), us.end(), keys.begin() + german.size()),
+                "The replacement keyboard's US keymap should be used once it arrives");
+#endif
+}
+
+void test_Wayland_BacksOffAfterFailedConnection()
+{
+#ifndef CROSSINPUT_HAS_LIBEI
+    std::cout << "(skipped: built without libei) ";
+#else
+    // An EIS socket whose server end is already gone
+    int fds[2];
+    TEST_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0, "socketpair should succeed");
+    close(fds[1]);
+
+    CrossInput::ReconnectPolicy policy;
+    policy.initialBackoff = std::chrono::hours(1);
+    policy.maxAttempts = 0;
+    CrossInput::SetReconnectPolicy(policy);
+    TEST_ASSERT(CrossInput::UseEisConnection(fds[0]), "Backend should accept the EIS socket");
+    CrossInput::SetBackend(CrossInput::Backend::Wayland);
+
+    std::chrono::steady_clock::duration elapsed{};
+    std::thread([&]
+                {
+                    CrossInput::KeyPress(CrossInput::KeyCode::KEY_F12); // fails and starts the backoff
+                    auto start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < 1000; ++i)
+                        CrossInput::KeyPress(CrossInput::KeyCode::KEY_F12);
+                    elapsed = std::chrono::steady_clock::now() - start;
+                })
+        .join();
+
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    CrossInput::SetReconnectPolicy(CrossInput::ReconnectPolicy());
+    TEST_ASSERT(elapsed < std::chrono::milliseconds(100),
+                "Calls while backing off should not attempt the portal handshake");
+#endif
+}
+
+void test_Wayland_SyncCoversX11Fallback()
+{
+#ifndef CROSSINPUT_HAS_LIBEI
+    std::cout << "(skipped: built without libei) ";
+#else
+    // A dead EIS socket, with calls allowed to fall back to XTest
+    int fds[2];
+    TEST_ASSERT(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0, "socketpair should succeed");
+    close(fds[1]);
+
+    CrossInput::ReconnectPolicy policy;
+    policy.initialBackoff = std::chrono::hours(1);
+    policy.fallbackToX11 = true;
+    CrossInput::SetReconnectPolicy(policy);
+    TEST_ASSERT(CrossInput::UseEisConnection(fds[0]), "Backend should accept the EIS socket");
+    CrossInput::SetBackend(CrossInput::Backend::Wayland);
+
+    bool synced = false;
+    CrossInput::Point pos{0, 0};
+    std::thread([&]
+                {
+                    CrossInput::SetCursorPosition({123, 45});
+                    synced = CrossInput::Sync();
+                    pos = CrossInput::GetCursorPosition();
+                })
+        .join();
+
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    CrossInput::SetReconnectPolicy(CrossInput::ReconnectPolicy());
+    if (std::getenv("DISPLAY"))
+    {
+        TEST_ASSERT(synced, "Sync should wait for the X server the call fell back to");
+        TEST_ASSERT(pos.x == 123 && pos.y == 45, "The fallen-back move should be applied after Sync");
+    }
+    else
+    {
+        TEST_ASSERT(!synced, "Sync should not report success when neither libei nor X11 is reachable");
+    }
+#endif
+}
+
+void test_Daemon_ForwardsCallsToItsBackend()
+{
+#ifndef __linux__
+    std::cout << "(skipped: the injector daemon is Linux only) ";
+#else
+    using CrossInput::KeyCode;
+    std::string path = "/tmp/crossinput_test_" + std::to_string(getpid()) + ".sock";
+    CrossInput::ResetNullBackend(800, 600, 64);
+
+    // In-process here, but the client only reaches it through the socket and the shared ring
+    CrossInput::InjectorDaemon daemon(path, CrossInput::Backend::Null);
+    TEST_ASSERT(daemon.IsRunning(), "Daemon should listen on a fresh socket");
+    CrossInput::InjectorDaemon second(path, CrossInput::Backend::Null);
+    TEST_ASSERT(!second.IsRunning(), "A second daemon should refuse a socket in use");
+
+    TEST_ASSERT(CrossInput::ConnectDaemon(path), "Client should connect to the daemon");
+    TEST_ASSERT(CrossInput::GetBackend() == CrossInput::Backend::Daemon, "Connecting should select the daemon");
+    TEST_ASSERT(daemon.ClientCount() == 1, "Daemon should count the client");
+
+    CrossInput::KeyDown(KeyCode::KEY_A);
+    CrossInput::KeyUp(KeyCode::KEY_A);
+    CrossInput::MoveCursor(10, 20);
+    CrossInput::TypeText("abcdefghijklmnopqrstuvwxyz"); // longer than one ring slot holds
+    bool synced = CrossInput::Sync();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    TEST_ASSERT(synced, "Sync should return once the daemon has injected everything");
+
+    std::vector<CrossInput::InputEvent> events = CrossInput::GetNullBackendEvents();
+    TEST_ASSERT(events.size() == 55, "Every call should reach the daemon's backend");
+    TEST_ASSERT(events[0].type == CrossInput::EventType::KeyDown && events[0].key == KeyCode::KEY_A,
+                "Calls should arrive in order");
+    TEST_ASSERT(events[2].type == CrossInput::EventType::MoveCursor && events[2].pos.x == 10 && events[2].pos.y == 20,
+                "Relative motion should keep its delta");
+    TEST_ASSERT(events[3].key == KeyCode::KEY_A && events[54].key == KeyCode::KEY_Z,
+                "Text split across slots should be typed whole");
+
+    daemon.Stop();
+    TEST_ASSERT(!CrossInput::ConnectDaemon(path), "Stopping should remove the socket");
+#endif
+}
+
+void test_Daemon_KeepsFilesThatAreNotSockets()
+{
+#ifndef __linux__
+    std::cout << "(skipped: the injector daemon is Linux only) ";
+#else
+    std::string path = "/tmp/crossinput_test_" + std::to_string(getpid()) + ".txt";
+    FILE *file = fopen(path.c_str(), "w");
+    TEST_ASSERT(file != nullptr, "Test file should be created");
+    fputs("keep", file);
+    fclose(file);
+
+    bool running = false;
+    {
+        CrossInput::InjectorDaemon daemon(path, CrossInput::Backend::Null);
+        running = daemon.IsRunning();
+    }
+    struct stat info = {};
+    bool kept = stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode) && info.st_size == 4;
+    remove(path.c_str());
+    TEST_ASSERT(!running, "Daemon should refuse a path that holds a regular file");
+    TEST_ASSERT(kept, "The file at the socket path should be left untouched");
+#endif
+}
+
+void test_Daemon_SplitsTextLongerThanItBuffers()
+{
+#ifndef __linux__
+    std::cout << "(skipped: the injector daemon is Linux only) ";
+#else
+    std::string path = "/tmp/crossinput_test_" + std::to_string(getpid()) + ".sock";
+    CrossInput::ResetNullBackend(800, 600, 64);
+    CrossInput::InjectorDaemon daemon(path, CrossInput::Backend::Null);
+    TEST_ASSERT(CrossInput::ConnectDaemon(path), "Client should connect to the daemon");
+
+    // The daemon drops a client whose text overruns its buffer; the two-byte
+    // code point straddles the limit, so the split has to back up over it
+    std::string text(CrossInput::Internal::kDaemonMaxText - 1, 'a');
+    text += "\xC3\xA9" "b";
+    CrossInput::TypeText(text);
+    bool synced = CrossInput::Sync();
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    TEST_ASSERT(synced, "Long text should not cost the connection");
+    TEST_ASSERT(daemon.ClientCount() == 1, "The daemon should keep the client");
+
+    // Every ASCII letter is a press and a release; the unmapped é is skipped
+    size_t recorded = CrossInput::GetNullBackendEvents().size() + CrossInput::GetNullBackendDropped();
+    TEST_ASSERT(recorded == 2 * CrossInput::Internal::kDaemonMaxText, "Every letter should be typed");
+    daemon.Stop();
+#endif
+}
+
+// =============================================================================
+// STATISTICS TESTS
+// =============================================================================
+
+void test_Stats_CountsCallsPerThreadAndOperation()
+{
+#ifdef CROSSINPUT_NO_STATS
+    CrossInput::EnableStats(true);
+    CrossInput::KeyDown(CrossInput::KeyCode::KEY_F12);
+    TEST_ASSERT(CrossInput::GetStats()[CrossInput::StatOp::KeyDown].calls == 0, "Compiled-out stats stay at zero");
+    return;
+#endif
+    CrossInput::EnableStats(true);
+    CrossInput::ResetStats();
+
+    CrossInput::KeyDown(CrossInput::KeyCode::KEY_F12);
+    CrossInput::KeyUp(CrossInput::KeyCode::KEY_F12);
+    std::thread worker([]
+                       {
+                           for (int i = 0; i < 3; ++i)
+                               CrossInput::MoveCursor(0, 0);
+                       });
+    worker.join();
+
+    uint64_t depthBefore = CrossInput::GetStats().schedulerQueueDepth;
+    {
+        CrossInput::Scheduler scheduler;
+        for (int i = 0; i < 4; ++i)
+            scheduler.ScheduleAfter(CrossInput::InputEvent::Key(CrossInput::KeyCode::KEY_F12, true),
+                                    std::chrono::hours(1));
+        TEST_ASSERT(CrossInput::GetStats().schedulerQueueDepth == depthBefore + 4,
+                    "Queued events should show in the queue depth");
+    }
+
+    CrossInput::Stats stats = CrossInput::GetStats();
+    CrossInput::EnableStats(false);
+
+    TEST_ASSERT(stats[CrossInput::StatOp::KeyDown].calls == 1, "KeyDown should be counted once");
+    TEST_ASSERT(stats[CrossInput::StatOp::KeyUp].calls == 1, "KeyUp should be counted once");
+    TEST_ASSERT(stats[CrossInput::StatOp::MoveCursor].calls == 3, "Calls from an exited thread should still count");
+    TEST_ASSERT(stats[CrossInput::StatOp::MoveCursor].submit.total == 3, "Every call should be in the histogram");
+    TEST_ASSERT(stats[CrossInput::StatOp::KeyDown].failures <= 1, "Failures cannot exceed calls");
+    TEST_ASSERT(stats[CrossInput::StatOp::TypeText].calls == 0, "Untouched operations should stay at zero");
+    TEST_ASSERT(stats.schedulerQueueDepth == depthBefore, "Destroyed scheduler should leave the queue depth");
+    TEST_ASSERT(stats.schedulerQueueHighWater >= depthBefore + 4, "High water should cover the peak depth");
+
+    CrossInput::ResetStats();
+    TEST_ASSERT(CrossInput::GetStats()[CrossInput::StatOp::MoveCursor].calls == 0, "Reset should clear counts");
+}
+
+void test_LatencyHistogram_Percentile()
+{
+    using CrossInput::LatencyHistogram;
+    TEST_ASSERT(LatencyHistogram::BucketLowerBound(15) == 15, "Small values should be exact");
+    TEST_ASSERT(LatencyHistogram::BucketLowerBound(16) == 16, "First log bucket should start at 16");
+    TEST_ASSERT(LatencyHistogram::BucketLowerBound(24) == 32, "Each power of two should have eight buckets");
+
+    LatencyHistogram histogram;
+    TEST_ASSERT(histogram.Percentile(50) == 0, "Empty histogram should report zero");
+
+    // 99 samples of 3 ns and one in the [1024, 1152) bucket
+    histogram.counts[3] = 99;
+    histogram.counts[16 + 6 * 8] = 1;
+    histogram.total = 100;
+    TEST_ASSERT(histogram.Percentile(50) == 3, "Median should fall in the exact bucket");
+    TEST_ASSERT(histogram.Percentile(99) == 3, "p99 should still be the common value");
+    TEST_ASSERT(histogram.Percentile(100) == 1151, "Max should report the top of its bucket");
+}
+
+void test_Trace_WritesChromeJson()
+{
+    const char *path = "test_trace.json";
+    CrossInput::StartTracing(8);
+    for (int i = 0; i < 10; ++i)
+        CrossInput::KeyPress(CrossInput::KeyCode::KEY_F12);
+    CrossInput::StopTracing();
+
+    TEST_ASSERT(CrossInput::WriteTrace(path), "Trace should be written");
+    TEST_ASSERT(!CrossInput::WriteTrace("/nonexistent-dir/trace.json"), "Unwritable path should fail");
+
+    FILE *file = fopen(path, "r");
+    TEST_ASSERT(file != nullptr, "Trace file should exist");
+    std::string json;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        json.append(buffer, n);
+    fclose(file);
+    std::remove(path);
+
+    TEST_ASSERT(json.find("\"traceEvents\":[") != std::string::npos, "Trace should be Chrome JSON");
+    TEST_ASSERT(json.find("]}") != std::string::npos, "Trace should be complete");
+    // 20 flushes into an 8-event buffer: the overflow is reported, not written
+    if (json.find("\"Flush\"") != std::string::npos)
+        TEST_ASSERT(json.find("\"dropped\"") != std::string::npos, "Overflow should be reported");
+}
+
 // =============================================================================
 // MAIN TEST RUNNER
 // =============================================================================
@@ -545,6 +2041,12 @@ int main()
     RUN_TEST(test_KeyDown_DoesNotCrash);
     RUN_TEST(test_KeyUp_DoesNotCrash);
     RUN_TEST(test_KeyPress_DoesNotCrash);
+    RUN_TEST(test_TypeText_EmptyDoesNotCrash);
+    RUN_TEST(test_TypeText_HoldsShiftOncePerRun);
+    RUN_TEST(test_TypeText_SkipsUnmappedCodepoints);
+    RUN_TEST(test_TypeText_RejectsMalformedUtf8);
+    RUN_TEST(test_TypeKeystrokes_NeverResolvesMalformedBytes);
+    RUN_TEST(test_PasteText_NullBackendSendsNothing);
 
     // Mouse function tests
     std::cout << "\n--- Mouse Function Tests ---" << std::endl;
@@ -562,6 +2064,74 @@ int main()
     RUN_TEST(test_AllSymbolKeys);
     RUN_TEST(test_AllMouseButtons);
 
+    // Spare keycode pool tests
+    std::cout << "\n--- Spare Keycode Pool Tests ---" << std::endl;
+    RUN_TEST(test_SparePool_EvictsLeastRecentlyUsed);
+    RUN_TEST(test_SparePool_SyncsBeforeReusingASlotFromThisCall);
+    RUN_TEST(test_SparePool_RestoreAllClearsRemappedKeycodes);
+    RUN_TEST(test_SparePool_DropsSlotsRemappedByOthers);
+
+    // Input sequence tests
+    std::cout << "\n--- Input Sequence Tests ---" << std::endl;
+    RUN_TEST(test_InputSequence_PlaysEventsInOrder);
+
+    // Scheduler tests
+    std::cout << "\n--- Scheduler Tests ---" << std::endl;
+    RUN_TEST(test_Scheduler_FiresAllEventsInOrder);
+    RUN_TEST(test_Scheduler_ReportsTiming);
+    RUN_TEST(test_Scheduler_StopDropsPending);
+    RUN_TEST(test_Scheduler_RunsWithoutTimerDescriptors);
+    RUN_TEST(test_Scheduler_VirtualClockFiresAtExactTimes);
+
+    // Recording tests
+    std::cout << "\n--- Recording Tests ---" << std::endl;
+    RUN_TEST(test_Recording_RoundTrip);
+    RUN_TEST(test_Recording_IsCompact);
+    RUN_TEST(test_Recording_RejectsForeignFiles);
+    RUN_TEST(test_Recording_ReplayAsFastAsPossible);
+
+    // Path simplification tests
+    std::cout << "\n--- Path Simplification Tests ---" << std::endl;
+    RUN_TEST(test_SimplifyPath_DropsCollinearPoints);
+    RUN_TEST(test_SimplifyPath_StaysWithinTolerance);
+    RUN_TEST(test_SimplifyPath_PreservesRelativeDisplacementAndBarriers);
+    RUN_TEST(test_PathSimplifier_Streaming);
+    RUN_TEST(test_SimplifyRecording);
+
+    // Listening tests
+    std::cout << "\n--- Listening Tests ---" << std::endl;
+    RUN_TEST(test_EventStream_PollAndStop);
+    RUN_TEST(test_CaptureRing_CountsDropsWhenFull);
+    RUN_TEST(test_CaptureRing_KeepsOrderAcrossWraparound);
+
+    // Backend tests
+    std::cout << "\n--- Backend Tests ---" << std::endl;
+    RUN_TEST(test_SetBackend_AutoAlwaysSucceeds);
+    RUN_TEST(test_Uinput_EventsReadBackFromDevice);
+    RUN_TEST(test_Uinput_PreparedSequenceReadsBackFromDevice);
+    RUN_TEST(test_Evdev_KeyStateFollowsUinputKeyboard);
+    RUN_TEST(test_Evdev_PicksUpHotpluggedKeyboard);
+    RUN_TEST(test_NullBackend_TracksDesktopState);
+    RUN_TEST(test_NullBackend_RecordsClampedMoves);
+    RUN_TEST(test_Wayland_DeliversToEisServer);
+    RUN_TEST(test_Wayland_TypesThroughTheEisKeymap);
+    RUN_TEST(test_Wayland_KeyStateUsesTheEisKeymap);
+    RUN_TEST(test_Wayland_RebuildsTableForReplacedKeyboard);
+    RUN_TEST(test_Wayland_BacksOffAfterFailedConnection);
+    RUN_TEST(test_Wayland_SyncCoversX11Fallback);
+    RUN_TEST(test_Daemon_ForwardsCallsToItsBackend);
+    RUN_TEST(test_Daemon_KeepsFilesThatAreNotSockets);
+    RUN_TEST(test_Daemon_SplitsTextLongerThanItBuffers);
+
+    // Statistics tests
+    std::cout << "\n--- Statistics Tests ---" << std::endl;
+    RUN_TEST(test_Stats_CountsCallsPerThreadAndOperation);
+    RUN_TEST(test_LatencyHistogram_Percentile);
+
+    // Tracing tests
+    std::cout << "\n--- Tracing Tests ---" << std::endl;
+    RUN_TEST(test_Trace_WritesChromeJson);
+
     // Print summary
     printSummary();
 
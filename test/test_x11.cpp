@@ -0,0 +1,333 @@
+/**
+ * CrossInput X11 Test
+ *
+ * Checks X11 behaviour that needs a server of its own: the tests change the
+ * keyboard mapping, take the clipboard and watch what a second client
+ * receives. Run it against a private Xvfb server with `make run_tests_x11`;
+ * it refuses to run without one.
+ */
+
+#include "../include/CrossInput.h"
+#include "../bench/x11_probe.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Bench::ProbeWindow;
+
+    constexpr std::chrono::milliseconds kDeliveryTimeout(1000);
+
+    // Returns nullptr when the test passes, otherwise the reason it failed
+    using Test = const char *(*)(ProbeWindow &probe);
+
+    bool run(const char *name, Test test, ProbeWindow &probe)
+    {
+        const char *failure = test(probe);
+        probe.drain();
+        if (!failure)
+        {
+            std::printf("%s: PASSED\n", name);
+            return true;
+        }
+        std::printf("%s: FAILED - %s\n", name, failure);
+        return false;
+    }
+
+    // Keycode of the next KeyPress the probe receives, 0 if none arrives
+    unsigned nextKeyPress(ProbeWindow &probe)
+    {
+        XEvent event;
+        return probe.waitFor(KeyPress, event, kDeliveryTimeout) ? event.xkey.keycode : 0;
+    }
+
+    // First keycode with no keysym at any level, 0 if the server has none
+    unsigned unusedKeycode(Display *display)
+    {
+        int minKeycode = 0, maxKeycode = 0, perKeycode = 0;
+        XDisplayKeycodes(display, &minKeycode, &maxKeycode);
+        KeySym *keysyms = XGetKeyboardMapping(display, static_cast<KeyCode>(minKeycode),
+                                              maxKeycode - minKeycode + 1, &perKeycode);
+        unsigned found = 0;
+        for (int keycode = minKeycode; keycode <= maxKeycode && !found; ++keycode)
+        {
+            const KeySym *row = keysyms + (keycode - minKeycode) * perKeycode;
+            if (std::all_of(row, row + perKeycode, [](KeySym keysym) { return keysym == NoSymbol; }))
+                found = static_cast<unsigned>(keycode);
+        }
+        XFree(keysyms);
+        return found;
+    }
+
+    // A prepared InputSequence caches keycodes; after the mapping moves a key,
+    // the next Play has to look them up again instead of pressing the old keycode
+    const char *test_PreparedSequence_RetranslatesAfterMappingChange(ProbeWindow &probe)
+    {
+        CrossInput::InputSequence press = {CrossInput::InputEvent::Key(CrossInput::KeyCode::KEY_A, true),
+                                           CrossInput::InputEvent::Key(CrossInput::KeyCode::KEY_A, false)};
+        press.Play();
+        CrossInput::Sync();
+        unsigned original = nextKeyPress(probe);
+        if (!original)
+            return "the first Play should reach the probe window";
+
+        // Move 'a' to a free keycode from the probe's connection, as another client would
+        Display *display = probe.display();
+        unsigned moved = unusedKeycode(display);
+        if (!moved)
+            return "the server should have an unused keycode";
+        int perKeycode = 0;
+        KeySym *saved = XGetKeyboardMapping(display, static_cast<KeyCode>(original), 1, &perKeycode);
+        std::vector<KeySym> cleared(static_cast<size_t>(perKeycode), NoSymbol);
+        KeySym letter[2] = {XK_a, XK_A};
+        XChangeKeyboardMapping(display, static_cast<int>(original), perKeycode, cleared.data(), 1);
+        XChangeKeyboardMapping(display, static_cast<int>(moved), 2, letter, 1);
+        XSync(display, False);
+        // Lets MappingNotify reach the library's connection before it plays
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        probe.drain();
+
+        press.Play();
+        CrossInput::Sync();
+        unsigned pressed = nextKeyPress(probe);
+
+        XChangeKeyboardMapping(display, static_cast<int>(original), perKeycode, saved, 1);
+        XChangeKeyboardMapping(display, static_cast<int>(moved), perKeycode, cleared.data(), 1);
+        XFree(saved);
+        XSync(display, False);
+
+        if (pressed == original)
+            return "Play should not press the keycode cached before the mapping changed";
+        if (pressed != moved)
+            return "Play should press the keycode 'a' moved to";
+        return nullptr;
+    }
+
+    Atom atom(Display *display, const char *name)
+    {
+        return XInternAtom(display, name, False);
+    }
+
+    // Reads and deletes `property`; false if it is missing
+    bool takeProperty(Display *display, Window window, Atom property, Atom &type, std::string &data)
+    {
+        int format = 0;
+        unsigned long items = 0, remaining = 0;
+        unsigned char *value = nullptr;
+        if (XGetWindowProperty(display, window, property, 0, LONG_MAX / 4, True, AnyPropertyType, &type, &format,
+                               &items, &remaining, &value) != Success)
+            return false;
+        data.clear();
+        if (value)
+        {
+            if (format == 8)
+                data.assign(reinterpret_cast<char *>(value), items);
+            XFree(value);
+        }
+        return type != None;
+    }
+
+    // Fetches CLIPBOARD as UTF-8 into a property of `requestor`, following
+    // INCR transfers, as a pasting application does. False if the owner refused.
+    bool convertClipboard(ProbeWindow &probe, Window requestor, Time time, std::string &text)
+    {
+        Display *display = probe.display();
+        Atom property = atom(display, "CROSSINPUT_TEST_PASTE");
+        XConvertSelection(display, atom(display, "CLIPBOARD"), atom(display, "UTF8_STRING"), property, requestor,
+                          time);
+        XEvent event;
+        do
+        {
+            if (!probe.waitFor(SelectionNotify, event, kDeliveryTimeout))
+                return false;
+        } while (event.xselection.requestor != requestor);
+
+        Atom type = None;
+        std::string chunk;
+        if (event.xselection.property == None || !takeProperty(display, requestor, property, type, chunk))
+            return false;
+        text = chunk;
+        if (type != atom(display, "INCR"))
+            return true;
+
+        // Deleting the INCR property asked for the first chunk; an empty one ends the transfer
+        text.clear();
+        for (;;)
+        {
+            do
+            {
+                if (!probe.waitFor(PropertyNotify, event, kDeliveryTimeout))
+                    return false;
+            } while (event.xproperty.window != requestor || event.xproperty.atom != property ||
+                     event.xproperty.state != PropertyNewValue);
+            if (!takeProperty(display, requestor, property, type, chunk))
+                return false;
+            if (chunk.empty())
+                return true;
+            text += chunk;
+        }
+    }
+
+    // Windows that fetch the clipboard: one inside the focused probe window,
+    // as the pasting application's, and one elsewhere, as a clipboard manager's
+    struct Requestors
+    {
+        explicit Requestors(ProbeWindow &probe) : display(probe.display())
+        {
+            focused = XCreateSimpleWindow(display, probe.window(), 0, 0, 1, 1, 0, 0, 0);
+            other = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0, 1, 1, 0, 0, 0);
+            XSelectInput(display, focused, PropertyChangeMask);
+            XSelectInput(display, other, PropertyChangeMask);
+        }
+
+        ~Requestors()
+        {
+            XDestroyWindow(display, focused);
+            XDestroyWindow(display, other);
+            XSync(display, False);
+        }
+
+        Requestors(const Requestors &) = delete;
+        Requestors &operator=(const Requestors &) = delete;
+
+        Display *display;
+        Window focused;
+        Window other;
+    };
+
+    // Runs PasteText on a thread; when its Ctrl+V reaches the probe window,
+    // `application` gets the key event's time. Returns what PasteText returned.
+    template <typename Application>
+    bool paste(ProbeWindow &probe, const std::string &text, const CrossInput::PasteOptions &options,
+               Application application)
+    {
+        bool pasted = false;
+        std::thread paster([&]
+                           { pasted = CrossInput::PasteText(text, options); });
+        XEvent key;
+        while (probe.waitFor(KeyPress, key, kDeliveryTimeout))
+        {
+            if (XLookupKeysym(&key.xkey, 0) == XK_v)
+            {
+                application(key.xkey.time);
+                break;
+            }
+        }
+        paster.join();
+        return pasted;
+    }
+
+    // Leaves "previous" on the clipboard for a restoring paste to bring back
+    bool primeClipboard(ProbeWindow &probe, Requestors &requestors)
+    {
+        std::string received;
+        return paste(probe, "previous", CrossInput::PasteOptions(), [&](Time time)
+                     { convertClipboard(probe, requestors.focused, time, received); }) &&
+               received == "previous";
+    }
+
+    // Pastes `text` into the focused window, which fetches it with the key
+    // event's time as toolkits do, and checks the clipboard is restored after
+    const char *pasteAndRestore(ProbeWindow &probe, const std::string &text)
+    {
+        Requestors requestors(probe);
+        if (!primeClipboard(probe, requestors))
+            return "the setup paste should succeed";
+
+        CrossInput::PasteOptions options;
+        options.restoreClipboard = true;
+        std::string received;
+        if (!paste(probe, text, options, [&](Time time)
+                   { convertClipboard(probe, requestors.focused, time, received); }))
+            return "PasteText should see the focused window fetch the text";
+        if (received != text)
+            return "the focused window should receive the text whole";
+
+        std::string restored;
+        if (!convertClipboard(probe, requestors.other, CurrentTime, restored) || restored != "previous")
+            return "the previous clipboard text should be back once PasteText returns";
+        return nullptr;
+    }
+
+    const char *test_PasteText_ServesSmallTextAndRestores(ProbeWindow &probe)
+    {
+        return pasteAndRestore(probe, "hello");
+    }
+
+    // Larger than one property write, so the text goes out in INCR chunks and
+    // the restore has to wait for the last of them
+    const char *test_PasteText_ServesIncrementallyAndRestores(ProbeWindow &probe)
+    {
+        std::string text(600 * 1024, ' ');
+        for (size_t i = 0; i < text.size(); ++i)
+            text[i] = static_cast<char>('a' + i % 26);
+        return pasteAndRestore(probe, text);
+    }
+
+    // Applications that fetch with CurrentTime are still recognized by focus
+    const char *test_PasteText_CountsTheFocusedWindowWithoutATime(ProbeWindow &probe)
+    {
+        Requestors requestors(probe);
+        std::string received;
+        if (!paste(probe, "focused", CrossInput::PasteOptions(), [&](Time)
+                   { convertClipboard(probe, requestors.focused, CurrentTime, received); }))
+            return "PasteText should count a CurrentTime fetch by the focused window";
+        if (received != "focused")
+            return "the focused window should receive the text";
+        return nullptr;
+    }
+
+    // A clipboard manager fetching after the keystroke is not the paste; the
+    // restore must wait for the application, and here none ever asks
+    const char *test_PasteText_IgnoresOtherClients(ProbeWindow &probe)
+    {
+        Requestors requestors(probe);
+        if (!primeClipboard(probe, requestors))
+            return "the setup paste should succeed";
+
+        CrossInput::PasteOptions options;
+        options.restoreClipboard = true;
+        options.timeout = std::chrono::milliseconds(500);
+        std::string copied;
+        bool pasted = paste(probe, "managed", options, [&](Time)
+                            { convertClipboard(probe, requestors.other, CurrentTime, copied); });
+        if (copied != "managed")
+            return "the other client should still be served";
+        if (pasted)
+            return "PasteText should not count another client's fetch as the paste";
+
+        std::string restored;
+        if (!convertClipboard(probe, requestors.other, CurrentTime, restored) || restored != "previous")
+            return "the previous clipboard text should be restored after the timeout";
+        return nullptr;
+    }
+} // namespace
+
+int main()
+{
+    std::printf("=== CrossInput X11 Test ===\n");
+
+    ProbeWindow probe;
+    if (!probe.isValid() || !CrossInput::SetBackend(CrossInput::Backend::X11) || !CrossInput::Sync())
+    {
+        std::printf("No X server; run these tests with `make run_tests_x11`\n");
+        return 1;
+    }
+
+    bool passed = true;
+    passed &= run("PreparedSequence retranslates after a mapping change",
+                  test_PreparedSequence_RetranslatesAfterMappingChange, probe);
+    passed &= run("PasteText serves small text and restores", test_PasteText_ServesSmallTextAndRestores, probe);
+    passed &= run("PasteText serves incrementally and restores", test_PasteText_ServesIncrementallyAndRestores,
+                  probe);
+    passed &= run("PasteText counts the focused window without a time",
+                  test_PasteText_CountsTheFocusedWindowWithoutATime, probe);
+    passed &= run("PasteText ignores other clients", test_PasteText_IgnoresOtherClients, probe);
+
+    CrossInput::SetBackend(CrossInput::Backend::Auto);
+    return passed ? 0 : 1;
+}
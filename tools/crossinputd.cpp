@@ -0,0 +1,93 @@
+/**
+ * crossinputd - CrossInput injector daemon
+ *
+ * Holds one backend connection (one RemoteDesktop portal session on Wayland)
+ * and injects on behalf of every process that calls ConnectDaemon, so the
+ * clients skip the backend's setup cost and share its permission grant.
+ * Runs until SIGINT or SIGTERM.
+ *
+ *   crossinputd [--socket PATH] [--backend auto|x11|wayland|uinput|null]
+ */
+
+#include "../include/CrossInput.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <csignal>
+#endif
+
+namespace
+{
+    void usage()
+    {
+        std::fprintf(stderr, "Usage: crossinputd [--socket PATH] [--backend auto|x11|wayland|uinput|null]\n");
+        std::fprintf(stderr, "Default socket: %s\n", CrossInput::DefaultDaemonSocket().c_str());
+    }
+
+    bool parseBackend(const char *name, CrossInput::Backend &backend)
+    {
+        using CrossInput::Backend;
+        static const struct
+        {
+            const char *name;
+            Backend backend;
+        } kBackends[] = {
+            {"auto", Backend::Auto}, {"x11", Backend::X11}, {"wayland", Backend::Wayland},
+            {"uinput", Backend::Uinput}, {"null", Backend::Null},
+        };
+        for (const auto &entry : kBackends)
+        {
+            if (std::strcmp(name, entry.name) == 0)
+            {
+                backend = entry.backend;
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string socketPath = CrossInput::DefaultDaemonSocket();
+    CrossInput::Backend backend = CrossInput::Backend::Auto;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc && parseBackend(argv[i + 1], backend))
+            ++i;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+#ifdef __linux__
+    // Blocked before the daemon's thread starts so that only sigwait sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    CrossInput::InjectorDaemon daemon(socketPath, backend);
+    if (!daemon.IsRunning())
+        return 1;
+    std::printf("crossinputd: listening on %s\n", socketPath.c_str());
+    std::fflush(stdout);
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    daemon.Stop();
+    return 0;
+#else
+    (void)backend;
+    std::fprintf(stderr, "crossinputd: unsupported on this platform\n");
+    return 1;
+#endif
+}